@@ -340,6 +340,16 @@ u8 vic_fce_ucode[] = {
 
 vic_config_t __attribute__((aligned (0x100))) vic_cfg = {0};
 
+static u32 vic_sfc_src;
+static u32 vic_sfc_dst;
+static u32 vic_sfc_width;
+static u32 vic_sfc_height;
+static u32 vic_sfc_flip_x;
+static u32 vic_sfc_flip_y;
+static u32 vic_sfc_swap_xy;
+static u32 vic_composed_px;
+static bool vic_cfg_dirty = false;
+
 u32 _vic_read_priv(u32 addr)
 {
 	u32 addr_lsb = addr & 0xFF;
@@ -390,6 +400,94 @@ static int _vic_wait_idle()
 	return 0;
 }
 
+static void _vic_config_push()
+{
+	// Flush data.
+	bpmp_mmu_maintenance(BPMP_MMU_MAINT_CLEAN_WAY, false);
+
+	// Set parameters base and size. Causes a parse by surface cache.
+	_vic_write_priv(VIC_SC_PRAMBASE, (u32)&vic_cfg >> 8);
+	_vic_write_priv(VIC_SC_PRAMSIZE, sizeof(vic_config_t) >> 6);
+
+	// Wait for surface cache to get ready.
+	_vic_wait_idle();
+
+	// Set slot mapping.
+	_vic_write_priv(VIC_FC_SLOT_MAP, 0xFFFFFFF0);
+
+	// Set input surface buffer.
+	_vic_write_priv(VIC_SC_SFC0_BASE_LUMA(0), vic_sfc_src >> 8);
+
+	// Set output surface buffer.
+	_vic_write_priv(VIC_BL_TARGET_BASADR, vic_sfc_dst >> 8);
+
+	// Set blending config and push changes to surface cache.
+	_vic_write_priv(VIC_BL_CONFIG, SLOTMASK(0x1F) | PROCESS_CFG_STRUCT_TRIGGER | SUBPARTITION_MODE);
+
+	// Wait for surface cache to get ready.
+	_vic_wait_idle();
+}
+
+static void _vic_set_rect(u32 x, u32 y, u32 w, u32 h)
+{
+	u32 right  = x + w - 1;
+	u32 bottom = y + h - 1;
+
+	// Set output destination rectangle. Anything outside will not be touched at output buffer.
+	vic_cfg.out_cfg.TargetRectLeft   = x;
+	vic_cfg.out_cfg.TargetRectRight  = right;
+	vic_cfg.out_cfg.TargetRectTop    = y;
+	vic_cfg.out_cfg.TargetRectBottom = bottom;
+
+	// Set input source rectangle.
+	vic_cfg.slots[0].slot_cfg.SourceRectLeft   = x << 16;
+	vic_cfg.slots[0].slot_cfg.SourceRectRight  = right << 16;
+	vic_cfg.slots[0].slot_cfg.SourceRectTop    = y << 16;
+	vic_cfg.slots[0].slot_cfg.SourceRectBottom = bottom << 16;
+
+	// Set input destination rectangle.
+	vic_cfg.slots[0].slot_cfg.DestRectLeft   = x;
+	vic_cfg.slots[0].slot_cfg.DestRectRight  = right;
+	vic_cfg.slots[0].slot_cfg.DestRectTop    = y;
+	vic_cfg.slots[0].slot_cfg.DestRectBottom = bottom;
+}
+
+static void _vic_rotate_dest_rect(u32 x, u32 y, u32 w, u32 h)
+{
+	if (!vic_sfc_flip_x && !vic_sfc_flip_y && !vic_sfc_swap_xy)
+		return;
+
+	// Map partial rectangle to the output surface config. Transpose first and then flip inside it.
+	u32 out_w = vic_cfg.out_sfc_cfg.OutSurfaceWidth  + 1;
+	u32 out_h = vic_cfg.out_sfc_cfg.OutSurfaceHeight + 1;
+	if (vic_sfc_swap_xy)
+	{
+		u32 tmp;
+		tmp = x; x = y; y = tmp;
+		tmp = w; w = h; h = tmp;
+		tmp = out_w; out_w = out_h; out_h = tmp;
+	}
+	if (vic_sfc_flip_x)
+		x = out_w - (x + w);
+	if (vic_sfc_flip_y)
+		y = out_h - (y + h);
+
+	u32 right  = x + w - 1;
+	u32 bottom = y + h - 1;
+
+	// Set output destination rectangle.
+	vic_cfg.out_cfg.TargetRectLeft   = x;
+	vic_cfg.out_cfg.TargetRectRight  = right;
+	vic_cfg.out_cfg.TargetRectTop    = y;
+	vic_cfg.out_cfg.TargetRectBottom = bottom;
+
+	// Set input destination rectangle.
+	vic_cfg.slots[0].slot_cfg.DestRectLeft   = x;
+	vic_cfg.slots[0].slot_cfg.DestRectRight  = right;
+	vic_cfg.slots[0].slot_cfg.DestRectTop    = y;
+	vic_cfg.slots[0].slot_cfg.DestRectBottom = bottom;
+}
+
 void vic_set_surface(const vic_surface_t *sfc)
 {
 	u32 flip_x  = 0;
@@ -462,12 +560,6 @@ void vic_set_surface(const vic_surface_t *sfc)
 	vic_cfg.out_sfc_cfg.OutLumaWidth     = width  - 1;
 	vic_cfg.out_sfc_cfg.OutLumaHeight    = height - 1;
 
-	// Set output destination rectangle. Anything outside will not be touched at output buffer.
-	vic_cfg.out_cfg.TargetRectLeft   = 0;
-	vic_cfg.out_cfg.TargetRectRight  = width - 1;
-	vic_cfg.out_cfg.TargetRectTop    = 0;
-	vic_cfg.out_cfg.TargetRectBottom = height - 1;
-
 	// Initialize slot parameters.
 	vic_cfg.slots[0].slot_cfg.SlotEnable    = 1;
 	vic_cfg.slots[0].slot_cfg.SoftClampLow  = SOFT_CLAMP_MIN;
@@ -476,17 +568,17 @@ void vic_set_surface(const vic_surface_t *sfc)
 	vic_cfg.slots[0].slot_cfg.ConstantAlpha = const_alpha;
 	vic_cfg.slots[0].slot_cfg.FrameFormat   = FORMAT_PROGRESSIVE;
 
-	// Set input source rectangle.
-	vic_cfg.slots[0].slot_cfg.SourceRectLeft   = 0;
-	vic_cfg.slots[0].slot_cfg.SourceRectRight  = (width  - 1) << 16;
-	vic_cfg.slots[0].slot_cfg.SourceRectTop    = 0;
-	vic_cfg.slots[0].slot_cfg.SourceRectBottom = (height - 1) << 16;
+	// Save surface parameters for rectangle compositions.
+	vic_sfc_src = src_buf;
+	vic_sfc_dst = dst_buf;
+	vic_sfc_width   = width;
+	vic_sfc_height  = height;
+	vic_sfc_flip_x  = flip_x;
+	vic_sfc_flip_y  = flip_y;
+	vic_sfc_swap_xy = swap_xy;
 
-	// Set input destination rectangle.
-	vic_cfg.slots[0].slot_cfg.DestRectLeft   = 0;
-	vic_cfg.slots[0].slot_cfg.DestRectRight  = (width  - 1);
-	vic_cfg.slots[0].slot_cfg.DestRectTop    = 0;
-	vic_cfg.slots[0].slot_cfg.DestRectBottom = (height - 1);
+	// Set full surface rectangle.
+	_vic_set_rect(0, 0, width, height);
 
 	// Set input surface format.
 	vic_cfg.slots[0].slot_sfc_cfg.SlotPixelFormat = pix_fmt;
@@ -500,43 +592,82 @@ void vic_set_surface(const vic_surface_t *sfc)
 	vic_cfg.slots[0].slot_sfc_cfg.SlotLumaWidth     = width  - 1;
 	vic_cfg.slots[0].slot_sfc_cfg.SlotLumaHeight    = height - 1;
 
-	// Flush data.
-	bpmp_mmu_maintenance(BPMP_MMU_MAINT_CLEAN_WAY, false);
-
-	// Set parameters base and size. Causes a parse by surface cache.
-	_vic_write_priv(VIC_SC_PRAMBASE, (u32)&vic_cfg >> 8);
-	_vic_write_priv(VIC_SC_PRAMSIZE, sizeof(vic_config_t) >> 6);
-
-	// Wait for surface cache to get ready.
-	_vic_wait_idle();
+	_vic_config_push();
+	vic_cfg_dirty = false;
+}
 
-	// Set slot mapping.
-	_vic_write_priv(VIC_FC_SLOT_MAP, 0xFFFFFFF0);
+int vic_compose()
+{
+	// Wait for surface cache to get ready. Otherwise VIC will hang.
+	int res = _vic_wait_idle();
 
-	// Set input surface buffer.
-	_vic_write_priv(VIC_SC_SFC0_BASE_LUMA(0), src_buf >> 8);
+	// Restore full surface rectangle and source if changed.
+	if (vic_cfg_dirty)
+	{
+		_vic_set_rect(0, 0, vic_sfc_width, vic_sfc_height);
+		_vic_config_push();
+		vic_cfg_dirty = false;
+	}
 
-	// Set output surface buffer.
-	_vic_write_priv(VIC_BL_TARGET_BASADR, dst_buf >> 8);
+	// Start composition of a single frame.
+	_vic_write_priv(VIC_FC_COMPOSE, COMPOSE_START);
 
-	// Set blending config and push changes to surface cache.
-	_vic_write_priv(VIC_BL_CONFIG, SLOTMASK(0x1F) | PROCESS_CFG_STRUCT_TRIGGER | SUBPARTITION_MODE);
+	vic_composed_px += vic_sfc_width * vic_sfc_height;
 
-	// Wait for surface cache to get ready.
-	_vic_wait_idle();
+	return res;
 }
 
-int vic_compose()
+int vic_compose_rect(u32 x, u32 y, u32 w, u32 h)
 {
-	// Wait for surface cache to get ready. Otherwise VIC will hang.
+	// Clip to surface.
+	if (!w || !h || x >= vic_sfc_width || y >= vic_sfc_height)
+		return 0;
+	if (x + w > vic_sfc_width)
+		w = vic_sfc_width - x;
+	if (y + h > vic_sfc_height)
+		h = vic_sfc_height - y;
+
+	// Align to surface cache tiles (64B x 4 lines).
+	u32 right  = ALIGN(x + w, VIC_RECT_ALIGN_X);
+	u32 bottom = ALIGN(y + h, VIC_RECT_ALIGN_Y);
+	x = ALIGN_DOWN(x, VIC_RECT_ALIGN_X);
+	y = ALIGN_DOWN(y, VIC_RECT_ALIGN_Y);
+	w = MIN(right,  vic_sfc_width)  - x;
+	h = MIN(bottom, vic_sfc_height) - y;
+
+	// Wait for any previous composition before changing config.
 	int res = _vic_wait_idle();
 
-	// Start composition of a single frame.
+	// Limit source, destination and target rectangles and push config.
+	_vic_set_rect(x, y, w, h);
+	_vic_rotate_dest_rect(x, y, w, h);
+	_vic_config_push();
+
+	// Start composition of the rectangle.
 	_vic_write_priv(VIC_FC_COMPOSE, COMPOSE_START);
 
+	vic_cfg_dirty = true;
+	vic_composed_px += w * h;
+
 	return res;
 }
 
+int vic_compose_wait()
+{
+	return _vic_wait_idle();
+}
+
+void vic_set_source(u32 src_buf)
+{
+	vic_sfc_src   = src_buf;
+	vic_cfg_dirty = true;
+}
+
+u32 vic_get_composed_pixels()
+{
+	return vic_composed_px;
+}
+
 int vic_init()
 {
 	clock_enable_vic();
@@ -23,6 +23,10 @@
 
 #define VIC_THI_SLCG_OVERRIDE_LOW_A 0x8C
 
+// Partial compose rectangle alignment in pixels/lines.
+#define VIC_RECT_ALIGN_X 16
+#define VIC_RECT_ALIGN_Y 4
+
 typedef enum _vic_rotation_t
 {
 	VIC_ROTATION_0   = 0,
@@ -60,6 +64,10 @@ typedef struct _vic_surface_t
 
 void vic_set_surface(const vic_surface_t *sfc);
 int  vic_compose();
+int  vic_compose_rect(u32 x, u32 y, u32 w, u32 h);
+int  vic_compose_wait();
+void vic_set_source(u32 src_buf);
+u32  vic_get_composed_pixels();
 int  vic_init();
 void vic_end();
 
@@ -32,6 +32,38 @@ const blz_footer *blz_get_footer(const u8 *comp_data, u32 comp_data_size, blz_fo
 	return src_footer;
 }
 
+#define BLZ_SEG_SIZE_MAX (0xF + 3)
+
+static void _blz_copy_segment(u8 *dst, u32 seg_ofs, u32 seg_size)
+{
+	const u8 *src = dst + seg_ofs;
+
+	// Source is always after destination, so an ascending copy is overlap safe.
+	// Use word copies when both are aligned, since there are no unaligned accesses on ARMv4.
+	if (!(((u32)dst | seg_ofs) & 3))
+	{
+		while (seg_size >= 4)
+		{
+			*(u32 *)dst = *(const u32 *)src;
+			dst += 4;
+			src += 4;
+			seg_size -= 4;
+		}
+
+		while (seg_size--)
+			*dst++ = *src++;
+
+		return;
+	}
+
+	// Minimum segment size is 3.
+	dst[0] = src[0];
+	dst[1] = src[1];
+	dst[2] = src[2];
+	for (u32 i = 3; i < seg_size; i++)
+		dst[i] = src[i];
+}
+
 // From https://github.com/SciresM/hactool/blob/master/kip.c which is exactly how kernel does it, thanks SciresM!
 int blz_uncompress_inplace(u8 *data, u32 comp_size, const blz_footer *footer)
 {
@@ -45,6 +77,51 @@ int blz_uncompress_inplace(u8 *data, u32 comp_size, const blz_footer *footer)
 
 	while (out_ofs)
 	{
+		// Fast path. A whole control block fits in both input and output, so no bounds checks are needed.
+		if (cmp_ofs > (1 + 8 * 2) && out_ofs > (8 * BLZ_SEG_SIZE_MAX))
+		{
+			u32 control = cmp_start[--cmp_ofs];
+
+			// Literal run.
+			if (!control)
+			{
+				u8 *src = &cmp_start[cmp_ofs];
+				u8 *dst = &cmp_start[out_ofs];
+
+				// Keep the same order as single literals, since they can overlap.
+				dst[-1] = src[-1];
+				dst[-2] = src[-2];
+				dst[-3] = src[-3];
+				dst[-4] = src[-4];
+				dst[-5] = src[-5];
+				dst[-6] = src[-6];
+				dst[-7] = src[-7];
+				dst[-8] = src[-8];
+
+				cmp_ofs -= 8;
+				out_ofs -= 8;
+
+				continue;
+			}
+
+			for (u32 i = 0; i < 8; i++, control <<= 1)
+			{
+				if (control & 0x80)
+				{
+					cmp_ofs -= 2;
+					u32 seg_val = ((u32)(cmp_start[cmp_ofs + 1]) << 8) | cmp_start[cmp_ofs];
+					u32 seg_size = (seg_val >> 12) + 3;
+
+					out_ofs -= seg_size;
+					_blz_copy_segment(&cmp_start[out_ofs], (seg_val & 0x0FFF) + 3, seg_size);
+				}
+				else // Copy directly.
+					cmp_start[--out_ofs] = cmp_start[--cmp_ofs];
+			}
+
+			continue;
+		}
+
 		u8 control = cmp_start[--cmp_ofs];
 		for (u32 i = 0; i < 8; i++)
 		{
@@ -458,6 +458,9 @@ typedef struct {
 #endif
 static FATFS* FatFs[FF_VOLUMES];	/* Pointer to the filesystem objects (logical drives) */
 static WORD Fsid;					/* Filesystem mount ID */
+#if FF_WIN_CACHE_SLOTS
+static BYTE* WcBuf[FF_VOLUMES];		/* Window cache lines of each logical drive (kept across mounts) */
+#endif
 
 #if FF_FS_RPATH != 0
 static BYTE CurrVol;				/* Current drive */
@@ -1065,6 +1068,112 @@ static void clear_lock (	/* Clear lock entries of the volume */
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Window cache: N-way read-ahead cache behind the disk access window    */
+/*-----------------------------------------------------------------------*/
+#if FF_WIN_CACHE_SLOTS
+
+static void wc_reset (	/* Invalidate all cache lines */
+	FATFS* fs			/* Filesystem object */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < FF_WIN_CACHE_SLOTS; i++) {
+		fs->wc_sect[i] = 0xFFFFFFFF;
+		fs->wc_cnt[i] = 0;
+		fs->wc_lru[i] = 0;
+	}
+	fs->wc_stamp = 0;
+}
+
+
+static DRESULT wc_read (	/* Read a sector through the cache */
+	FATFS* fs,			/* Filesystem object */
+	BYTE* buff,			/* Sector buffer */
+	DWORD sector		/* Sector to read */
+)
+{
+	UINT i, slot;
+	DWORD start, end, cnt;
+
+
+	/* Only cache mounted volumes and sectors inside them */
+	end = fs->database + (fs->n_fatent - 2) * fs->csize;
+	if (!fs->wc_buf || fs->fs_type == 0 || sector >= end) return disk_read(fs->pdrv, buff, sector, 1);
+
+	fs->wc_stamp++;
+	slot = 0;
+	for (i = 0; i < FF_WIN_CACHE_SLOTS; i++) {
+		if (sector - fs->wc_sect[i] < fs->wc_cnt[i]) {	/* Hit */
+			fs->wc_lru[i] = fs->wc_stamp;
+			mem_cpy(buff, fs->wc_buf + ((i * FF_WIN_CACHE_SECTORS + sector - fs->wc_sect[i]) * SS(fs)), SS(fs));
+			return RES_OK;
+		}
+		if (fs->wc_lru[i] < fs->wc_lru[slot]) slot = i;	/* Least recently used */
+	}
+
+	/* Miss: fill the aligned line that contains the sector */
+	start = sector & ~(DWORD)(FF_WIN_CACHE_SECTORS - 1);
+	cnt = (end - start < FF_WIN_CACHE_SECTORS) ? end - start : FF_WIN_CACHE_SECTORS;
+	if (disk_read(fs->pdrv, fs->wc_buf + slot * FF_WIN_CACHE_SECTORS * SS(fs), start, cnt) != RES_OK) {
+		fs->wc_sect[slot] = 0xFFFFFFFF;
+		fs->wc_cnt[slot] = 0;
+		return disk_read(fs->pdrv, buff, sector, 1);	/* Retry uncached */
+	}
+	fs->wc_sect[slot] = start;
+	fs->wc_cnt[slot] = cnt;
+	fs->wc_lru[slot] = fs->wc_stamp;
+	mem_cpy(buff, fs->wc_buf + ((slot * FF_WIN_CACHE_SECTORS + sector - start) * SS(fs)), SS(fs));
+
+	return RES_OK;
+}
+
+
+#if !FF_FS_READONLY
+static DRESULT wc_write (	/* Write sectors and update the cached copies */
+	FATFS* fs,			/* Filesystem object */
+	const BYTE* buff,	/* Data to be written */
+	DWORD sector,		/* Start sector */
+	UINT count			/* Number of sectors */
+)
+{
+	UINT i;
+	DWORD s, e;
+	DRESULT res;
+
+
+	res = disk_write(fs->pdrv, buff, sector, count);
+	if (!fs->wc_buf) return res;
+
+	for (i = 0; i < FF_WIN_CACHE_SLOTS; i++) {
+		s = (sector > fs->wc_sect[i]) ? sector : fs->wc_sect[i];
+		e = (sector + count < fs->wc_sect[i] + fs->wc_cnt[i]) ? sector + count : fs->wc_sect[i] + fs->wc_cnt[i];
+		if (!fs->wc_cnt[i] || s >= e) continue;
+		if (res == RES_OK) {	/* Write-through */
+			mem_cpy(fs->wc_buf + ((i * FF_WIN_CACHE_SECTORS + s - fs->wc_sect[i]) * SS(fs)),
+				buff + (s - sector) * SS(fs), (e - s) * SS(fs));
+		} else {				/* Unknown disk state, drop the line */
+			fs->wc_sect[i] = 0xFFFFFFFF;
+			fs->wc_cnt[i] = 0;
+		}
+	}
+
+	return res;
+}
+#endif
+
+#define WIN_READ(fs, buff, sector)			wc_read(fs, buff, sector)
+#define WIN_WRITE(fs, buff, sector, count)	wc_write(fs, buff, sector, count)
+#else
+#define WIN_READ(fs, buff, sector)			disk_read((fs)->pdrv, buff, sector, 1)
+#define WIN_WRITE(fs, buff, sector, count)	disk_write((fs)->pdrv, buff, sector, count)
+#endif	/* FF_WIN_CACHE_SLOTS */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Move/Flush disk access window in the filesystem object                */
 /*-----------------------------------------------------------------------*/
@@ -1077,10 +1186,10 @@ static FRESULT sync_window (	/* Returns FR_OK or FR_DISK_ERR */
 
 
 	if (fs->wflag) {	/* Is the disk access window dirty */
-		if (disk_write(fs->pdrv, fs->win, fs->winsect, 1) == RES_OK) {	/* Write back the window */
+		if (WIN_WRITE(fs, fs->win, fs->winsect, 1) == RES_OK) {	/* Write back the window */
 			fs->wflag = 0;	/* Clear window dirty flag */
 			if (fs->winsect - fs->fatbase < fs->fsize) {	/* Is it in the 1st FAT? */
-				if (fs->n_fats == 2) disk_write(fs->pdrv, fs->win, fs->winsect + fs->fsize, 1);	/* Reflect it to 2nd FAT if needed */
+				if (fs->n_fats == 2) WIN_WRITE(fs, fs->win, fs->winsect + fs->fsize, 1);	/* Reflect it to 2nd FAT if needed */
 			}
 		} else {
 			res = FR_DISK_ERR;
@@ -1104,7 +1213,7 @@ static FRESULT move_window (	/* Returns FR_OK or FR_DISK_ERR */
 		res = sync_window(fs);		/* Write-back changes */
 #endif
 		if (res == FR_OK) {			/* Fill sector window with new data */
-			if (disk_read(fs->pdrv, fs->win, sector, 1) != RES_OK) {
+			if (WIN_READ(fs, fs->win, sector) != RES_OK) {
 				sector = 0xFFFFFFFF;	/* Invalidate window if read data is not valid */
 				res = FR_DISK_ERR;
 			}
@@ -1141,7 +1250,7 @@ static FRESULT sync_fs (	/* Returns FR_OK or FR_DISK_ERR */
 			st_dword(fs->win + FSI_Nxt_Free, fs->last_clst);
 			/* Write it into the FSInfo sector */
 			fs->winsect = fs->volbase + 1;
-			disk_write(fs->pdrv, fs->win, fs->winsect, 1);
+			WIN_WRITE(fs, fs->win, fs->winsect, 1);
 			fs->fsi_flag = 0;
 		}
 		/* Make sure that no pending write process in the lower layer */
@@ -1324,32 +1433,53 @@ static DWORD find_bitmap (	/* 0:Not found, 2..:Cluster block found, 0xFFFFFFFF:D
 	DWORD ncl	/* Number of contiguous clusters to find (1..) */
 )
 {
-	BYTE bm, bv;
-	UINT i;
-	DWORD val, scl, ctr;
+	DWORD val, scl, ctr, nbit, bps, end, bm, rest, run, pos, cnt;
+	int wrap = 0;
 
 
+	nbit = fs->n_fatent - 2;	/* Number of bits in the bitmap */
+	bps = SS(fs) * 8;			/* Bits per bitmap sector */
 	clst -= 2;	/* The first bit in the bitmap corresponds to cluster #2 */
-	if (clst >= fs->n_fatent - 2) clst = 0;
+	if (clst >= nbit) clst = 0;
 	scl = val = clst; ctr = 0;
 	for (;;) {
-		if (move_window(fs, fs->bitbase + val / 8 / SS(fs)) != FR_OK) return 0xFFFFFFFF;
-		i = val / 8 % SS(fs); bm = 1 << (val % 8);
-		do {
-			do {
-				bv = fs->win[i] & bm; bm <<= 1;		/* Get bit value */
-				if (++val >= fs->n_fatent - 2) {	/* Next cluster (with wrap-around) */
-					val = 0; bm = 0; i = SS(fs);
-				}
-				if (bv == 0) {	/* Is it a free cluster? */
-					if (++ctr == ncl) return scl + 2;	/* Check if run length is sufficient for required */
-				} else {
-					scl = val; ctr = 0;		/* Encountered a cluster in-use, restart to scan */
+		end = (val / bps + 1) * bps;	/* Scan to the end of this sector... */
+		if (end > nbit) end = nbit;
+		if (wrap && end > clst) end = clst;	/* ...or to the scan start point */
+		if (fs->bm_free && fs->bm_free[val / bps] == 0) {	/* Sector is fully in use? */
+			scl = end; ctr = 0;
+		} else if (fs->bm_free && fs->bm_free[val / bps] == bps) {	/* Sector is fully free? */
+			if (ctr + (end - val) >= ncl) return scl + 2;
+			ctr += end - val;
+		} else {
+			if (move_window(fs, fs->bitbase + val / bps) != FR_OK) return 0xFFFFFFFF;
+			while (val < end) {	/* Scan the sector a DWORD at a time */
+				pos = val % 32;
+				cnt = 32 - pos;
+				if (cnt > end - val) cnt = end - val;
+				bm = ld_dword(fs->win + (val % bps) / 32 * 4) >> pos;
+				if (cnt < 32) bm &= (1UL << cnt) - 1;
+				for (run = 0; run < cnt; ) {	/* Walk runs of used/free bits */
+					rest = bm >> run;
+					if (rest & 1) {		/* Clusters in use, restart the run after them */
+						run += (~rest == 0) ? 32 - run : (DWORD)__builtin_ctz(~rest);
+						if (run > cnt) run = cnt;
+						scl = val + run; ctr = 0;
+					} else {			/* Free clusters, extend the run */
+						rest = rest ? (DWORD)__builtin_ctz(rest) : 32 - run;
+						if (rest > cnt - run) rest = cnt - run;
+						if (ctr + rest >= ncl) return scl + 2;	/* Check if run length is sufficient for required */
+						ctr += rest; run += rest;
+					}
 				}
-				if (val == clst) return 0;	/* All cluster scanned? */
-			} while (bm != 0);
-			bm = 1;
-		} while (++i < SS(fs));
+				val += cnt;
+			}
+		}
+		val = end;
+		if (val >= nbit) {		/* Wrap-around (a run does not continue across it) */
+			val = scl = 0; ctr = 0; wrap = 1;
+		}
+		if (wrap && val >= clst) return 0;	/* All cluster scanned? */
 	}
 }
 
@@ -1368,6 +1498,7 @@ static FRESULT change_bitmap (
 	BYTE bm;
 	UINT i;
 	DWORD sect;
+	WORD* nf;
 
 
 	clst -= 2;	/* The first bit corresponds to cluster #2 */
@@ -1375,12 +1506,14 @@ static FRESULT change_bitmap (
 	i = clst / 8 % SS(fs);					/* Byte offset in the sector */
 	bm = 1 << (clst % 8);					/* Bit mask in the byte */
 	for (;;) {
+		nf = fs->bm_free ? &fs->bm_free[sect - fs->bitbase] : 0;	/* Free count of the sector */
 		if (move_window(fs, sect++) != FR_OK) return FR_DISK_ERR;
 		do {
 			do {
 				if (bv == (int)((fs->win[i] & bm) != 0)) return FR_INT_ERR;	/* Is the bit expected value? */
 				fs->win[i] ^= bm;	/* Flip the bit */
 				fs->wflag = 1;
+				if (nf) *nf += bv ? -1 : 1;	/* Keep the summary in sync */
 				if (--ncl == 0) return FR_OK;	/* All bits processed? */
 			} while (bm <<= 1);		/* Next bit */
 			bm = 1;
@@ -1691,13 +1824,13 @@ static FRESULT dir_clear (	/* Returns FR_OK or FR_DISK_ERR */
 	if (szb > SS(fs)) {		/* Buffer allocated? */
 		mem_set(ibuf, 0, szb);
 		szb /= SS(fs);		/* Bytes -> Sectors */
-		for (n = 0; n < fs->csize && disk_write(fs->pdrv, ibuf, sect + n, szb) == RES_OK; n += szb) ;	/* Fill the cluster with 0 */
+		for (n = 0; n < fs->csize && WIN_WRITE(fs, ibuf, sect + n, szb) == RES_OK; n += szb) ;	/* Fill the cluster with 0 */
 		ff_memfree(ibuf);
 	} else
 #endif
 	{
 		ibuf = fs->win; szb = 1;	/* Use window buffer (many single-sector writes may take a time) */
-		for (n = 0; n < fs->csize && disk_write(fs->pdrv, ibuf, sect + n, szb) == RES_OK; n += szb) ;	/* Fill the cluster with 0 */
+		for (n = 0; n < fs->csize && WIN_WRITE(fs, ibuf, sect + n, szb) == RES_OK; n += szb) ;	/* Fill the cluster with 0 */
 	}
 	return (n == fs->csize) ? FR_OK : FR_DISK_ERR;
 }
@@ -3495,6 +3628,15 @@ static FRESULT find_volume (	/* FR_OK(0): successful, !=0: an error occurred */
 #endif	/* !FF_FS_READONLY */
 	}
 
+#if FF_WIN_CACHE_SLOTS
+	if (!WcBuf[vol]) WcBuf[vol] = ff_memalloc(FF_WIN_CACHE_SLOTS * FF_WIN_CACHE_SECTORS * FF_MAX_SS);	/* Allocated once, runs uncached if it fails */
+	fs->wc_buf = WcBuf[vol];
+	wc_reset(fs);
+#endif
+#if FF_FS_EXFAT && !FF_FS_READONLY
+	ff_memfree(fs->bm_free);	/* Bitmap summary is rebuilt by f_getfree */
+	fs->bm_free = 0;
+#endif
 	fs->fs_type = fmt;		/* FAT sub-type */
 	fs->id = ++Fsid;		/* Volume mount ID */
 #if FF_USE_LFN == 1
@@ -3591,10 +3733,23 @@ FRESULT f_mount (
 		if (!ff_del_syncobj(cfs->sobj)) return FR_INT_ERR;
 #endif
 		cfs->fs_type = 0;				/* Clear old fs object */
+#if FF_WIN_CACHE_SLOTS
+		cfs->wc_buf = 0;				/* Detach window cache, the lines are reused by the next mount */
+#endif
+#if FF_FS_EXFAT && !FF_FS_READONLY
+		ff_memfree(cfs->bm_free);		/* Discard bitmap summary */
+		cfs->bm_free = 0;
+#endif
 	}
 
 	if (fs) {
 		fs->fs_type = 0;				/* Clear new fs object */
+#if FF_WIN_CACHE_SLOTS
+		fs->wc_buf = 0;					/* Window cache is attached on mount */
+#endif
+#if FF_FS_EXFAT && !FF_FS_READONLY
+		fs->bm_free = 0;				/* Bitmap summary is allocated by f_getfree */
+#endif
 #if FF_FS_REENTRANT						/* Create sync object for the new volume */
 		if (!ff_cre_syncobj((BYTE)vol, &fs->sobj)) return FR_INT_ERR;
 #endif
@@ -3888,7 +4043,7 @@ FRESULT f_read (
 			if (fp->sect != sect) {			/* Load data sector if not in cache */
 #if !FF_FS_READONLY
 				if (fp->flag & FA_DIRTY) {		/* Write-back dirty sector cache */
-					if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) {
+					if (WIN_WRITE(fs, fp->buf, fp->sect, 1) != RES_OK) {
 						EFSPRINTF("RDC");
 						ABORT(fs, FR_DISK_ERR);
 					}
@@ -4078,7 +4233,7 @@ FRESULT f_write (
 			if (fs->winsect == fp->sect && sync_window(fs) != FR_OK) ABORT(fs, FR_DISK_ERR);	/* Write-back sector cache */
 #else
 			if (fp->flag & FA_DIRTY) {		/* Write-back sector cache */
-				if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
+				if (WIN_WRITE(fs, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
 				fp->flag &= (BYTE)~FA_DIRTY;
 			}
 #endif
@@ -4090,7 +4245,7 @@ FRESULT f_write (
 				if (csect + cc > fs->csize) {	/* Clip at cluster boundary */
 					cc = fs->csize - csect;
 				}
-				if (disk_write(fs->pdrv, wbuff, sect, cc) != RES_OK) {
+				if (WIN_WRITE(fs, wbuff, sect, cc) != RES_OK) {
 					EFSPRINTF("WLIO");
 					ABORT(fs, FR_DISK_ERR);
 				}
@@ -4208,7 +4363,7 @@ FRESULT f_write_fast (
 		work_sector = clst2sect(fs, fp->clust);
 		if ((work_sector - sector_base) == count) count += fs->csize;
 		else {
-			if (disk_write(fs->pdrv, wbuff, sector_base, count) != RES_OK) ABORT(fs, FR_DISK_ERR);
+			if (WIN_WRITE(fs, wbuff, sector_base, count) != RES_OK) ABORT(fs, FR_DISK_ERR);
 			wbuff += count * SS(fs);
 
 			sector_base = work_sector;
@@ -4221,7 +4376,7 @@ FRESULT f_write_fast (
 		// what about if data is smaller than cluster?
 		// Probably must read-write back that cluster.
 		if (!btw) {	/* Final cluster/sectors write. */
-			if (disk_write(fs->pdrv, wbuff, sector_base, count) != RES_OK) ABORT(fs, FR_DISK_ERR);
+			if (WIN_WRITE(fs, wbuff, sector_base, count) != RES_OK) ABORT(fs, FR_DISK_ERR);
 			fp->flag &= (BYTE)~FA_DIRTY;
 		}
 	}
@@ -4254,7 +4409,7 @@ FRESULT f_sync (
 		if (fp->flag & FA_MODIFIED) {	/* Is there any change to the file? */
 #if !FF_FS_TINY
 			if (fp->flag & FA_DIRTY) {	/* Write-back cached data if needed */
-				if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) LEAVE_FF(fs, FR_DISK_ERR);
+				if (WIN_WRITE(fs, fp->buf, fp->sect, 1) != RES_OK) LEAVE_FF(fs, FR_DISK_ERR);
 				fp->flag &= (BYTE)~FA_DIRTY;
 			}
 #endif
@@ -4596,7 +4751,7 @@ FRESULT f_lseek (
 #if !FF_FS_TINY
 #if !FF_FS_READONLY
 					if (fp->flag & FA_DIRTY) {		/* Write-back dirty sector cache */
-						if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
+						if (WIN_WRITE(fs, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
 						fp->flag &= (BYTE)~FA_DIRTY;
 					}
 #endif
@@ -4676,7 +4831,7 @@ FRESULT f_lseek (
 #if !FF_FS_TINY
 #if !FF_FS_READONLY
 			if (fp->flag & FA_DIRTY) {			/* Write-back dirty sector cache */
-				if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
+				if (WIN_WRITE(fs, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
 				fp->flag &= (BYTE)~FA_DIRTY;
 			}
 #endif
@@ -4980,23 +5135,27 @@ FRESULT f_getfree (
 			} else {
 #if FF_FS_EXFAT
 				if (fs->fs_type == FS_EXFAT) {	/* exFAT: Scan allocation bitmap */
-					BYTE bm;
-					UINT b;
-
-					clst = fs->n_fatent - 2;	/* Number of clusters */
-					sect = fs->bitbase;			/* Bitmap sector */
-					i = 0;						/* Offset in the sector */
-					do {	/* Counts numbuer of bits with zero in the bitmap */
-						if (i == 0) {
-							res = move_window(fs, sect++);
-							if (res != FR_OK) break;
-						}
-						for (b = 8, bm = fs->win[i]; b && clst; b--, clst--) {
-							if (!(bm & 1)) nfree++;
-							bm >>= 1;
+					DWORD bps, nbit, bm, sfree;
+
+					bps = SS(fs) * 8;			/* Bits per bitmap sector */
+					nbit = fs->n_fatent - 2;	/* Number of clusters */
+					if (!fs->bm_free) fs->bm_free = ff_memalloc((nbit + bps - 1) / bps * sizeof(WORD));	/* Runs without the summary if it fails */
+					for (clst = 0; clst < nbit; clst += bps) {	/* Count the zero bits a sector at a time */
+						res = move_window(fs, fs->bitbase + clst / bps);
+						if (res != FR_OK) break;
+						sfree = 0;
+						for (i = 0; i < bps && clst + i < nbit; i += 32) {
+							bm = ld_dword(fs->win + i / 8);
+							if (nbit - clst - i < 32) bm |= ~0UL << (nbit - clst - i);	/* Bits past the last cluster are not free */
+							sfree += 32 - __builtin_popcount(bm);
 						}
-						i = (i + 1) % SS(fs);
-					} while (clst);
+						if (fs->bm_free) fs->bm_free[clst / bps] = (WORD)sfree;
+						nfree += sfree;
+					}
+					if (res != FR_OK) {	/* Partial summary is useless */
+						ff_memfree(fs->bm_free);
+						fs->bm_free = 0;
+					}
 				} else
 #endif
 				{	/* FAT16/32: Scan WORD/DWORD FAT entries */
@@ -5065,7 +5224,7 @@ FRESULT f_truncate (
 		fp->flag |= FA_MODIFIED;
 #if !FF_FS_TINY
 		if (res == FR_OK && (fp->flag & FA_DIRTY)) {
-			if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) {
+			if (WIN_WRITE(fs, fp->buf, fp->sect, 1) != RES_OK) {
 				res = FR_DISK_ERR;
 			} else {
 				fp->flag &= (BYTE)~FA_DIRTY;
@@ -5817,7 +5976,7 @@ FRESULT f_forward (
 		if (fp->sect != sect) {		/* Fill sector cache with file data */
 #if !FF_FS_READONLY
 			if (fp->flag & FA_DIRTY) {		/* Write-back dirty sector cache */
-				if (disk_write(fs->pdrv, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
+				if (WIN_WRITE(fs, fp->buf, fp->sect, 1) != RES_OK) ABORT(fs, FR_DISK_ERR);
 				fp->flag &= (BYTE)~FA_DIRTY;
 			}
 #endif
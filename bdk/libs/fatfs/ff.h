@@ -29,6 +29,10 @@ extern "C" {
 #include <utils/types.h>	/* Basic integer types */
 #include <fatfs_cfg.h>	/* FatFs configuration options */
 
+#ifndef FF_WIN_CACHE_SLOTS
+#define FF_WIN_CACHE_SLOTS	0
+#endif
+
 #if FF_DEFINED != FFCONF_DEF
 #error Wrong configuration file (ffconf.h).
 #endif
@@ -139,6 +143,16 @@ typedef struct {
 #endif
 	DWORD	winsect;		/* Current sector appearing in the win[] */
 	BYTE	win[FF_MAX_SS] __attribute__((aligned(8)));	/* Disk access window for Directory, FAT (and file data at tiny cfg). DMA aligned. */
+#if FF_WIN_CACHE_SLOTS
+	BYTE*	wc_buf;			/* Window cache lines (attached on mount) */
+	DWORD	wc_sect[FF_WIN_CACHE_SLOTS];	/* Start sector of each line */
+	DWORD	wc_cnt[FF_WIN_CACHE_SLOTS];		/* Number of valid sectors in each line (0:invalid) */
+	DWORD	wc_lru[FF_WIN_CACHE_SLOTS];		/* Last access stamp of each line */
+	DWORD	wc_stamp;		/* Access stamp counter */
+#endif
+#if FF_FS_EXFAT && !FF_FS_READONLY
+	WORD*	bm_free;		/* Free clusters per allocation bitmap sector (built by f_getfree) */
+#endif
 } FATFS;
 
 
@@ -25,16 +25,23 @@
 
 /* Memory size which will be used by the library
  * to store the graphical objects and other data */
-#define LV_MEM_CUSTOM         0              /*1: use custom malloc/free, 0: use the built-in lv_mem_alloc/lv_mem_free*/
+#define LV_MEM_CUSTOM         1              /*1: use custom malloc/free, 0: use the built-in lv_mem_alloc/lv_mem_free*/
 #if LV_MEM_CUSTOM == 0
 #  define LV_MEM_SIZE         NYX_LV_MEM_SZ  /*Size memory used by `lv_mem_alloc` in bytes (>= 2kB)*/
 #  define LV_MEM_ATTR                        /*Complier prefix for big array declaration*/
 #  define LV_MEM_ADR          NYX_LV_MEM_ADR /*Set an address for memory pool instead of allocation it as an array. Can be in external SRAM too.*/
 #  define LV_MEM_AUTO_DEFRAG  1              /*Automatically defrag on free*/
 #else       /*LV_MEM_CUSTOM*/
-#  define LV_MEM_CUSTOM_INCLUDE <mem/heap.h> /*Header for the dynamic memory function*/
-#  define LV_MEM_CUSTOM_ALLOC   malloc       /*Wrapper to malloc*/
-#  define LV_MEM_CUSTOM_FREE    free         /*Wrapper to free*/
+#  define LV_MEM_CUSTOM_INCLUDE   <mem/heap.h>      /*Header for the dynamic memory function*/
+#  define LV_MEM_CUSTOM_POOL      heap_t            /*Optional: Pool type. Functions get a pointer to it as first argument*/
+#  define LV_MEM_CUSTOM_ADR       NYX_LV_MEM_ADR    /*Pool address*/
+#  define LV_MEM_CUSTOM_SIZE      NYX_LV_MEM_SZ     /*Pool size*/
+#  define LV_MEM_CUSTOM_INIT      heap_pool_init    /*Wrapper to pool init*/
+#  define LV_MEM_CUSTOM_ALLOC     heap_pool_alloc   /*Wrapper to malloc*/
+#  define LV_MEM_CUSTOM_FREE      heap_pool_free    /*Wrapper to free*/
+#  define LV_MEM_CUSTOM_RESIZE    heap_pool_realloc /*Optional: Wrapper to realloc*/
+#  define LV_MEM_CUSTOM_MONITOR   heap_pool_monitor /*Optional: Wrapper to pool statistics*/
+#  define LV_MEM_CUSTOM_MONITOR_T heap_monitor_t    /*Pool statistics type*/
 #endif     /*LV_MEM_CUSTOM*/
 
 /* Garbage Collector settings
@@ -91,21 +98,22 @@
 
 /* Use two Virtual Display buffers (VDB) to parallelize rendering and flushing
  * The flushing should use DMA to write the frame buffer in the background */
-#define LV_VDB_DOUBLE       0
+#define LV_VDB_DOUBLE       1
 
 /* Place VDB2 to a specific address (e.g. in external RAM)
  * 0: allocate automatically into RAM
  * LV_VDB_ADR_INV: to replace it later with `lv_vdb_set_adr()`*/
-#define LV_VDB2_ADR         0
+#define LV_VDB2_ADR         NYX_LV_VDB2_ADR
 
 /* Using true double buffering in `disp_drv.disp_flush` you will always get the image of the whole screen.
  * Your only task is to set the rendered image (`color_p` parameter) as frame buffer address or send it to your display.
+ * The flushed area is the bounding box of the refreshed areas.
  * The best if you do in the blank period of you display to avoid tearing effect.
  * Requires:
  * - LV_VDB_SIZE = LV_HOR_RES * LV_VER_RES
  * - LV_VDB_DOUBLE = 1
  */
-#define LV_VDB_TRUE_DOUBLE_BUFFERED 0
+#define LV_VDB_TRUE_DOUBLE_BUFFERED 1
 
 /*=================
    Misc. setting
@@ -202,11 +202,19 @@ static void lv_refr_task(void * param)
 
         /*In true double buffered mode copy the refreshed areas to the new VDB to keep it up to date*/
 #if LV_VDB_TRUE_DOUBLE_BUFFERED
+        /*Report the bounding box of the refreshed areas. The buffer still holds the whole screen*/
         lv_vdb_t * vdb_p = lv_vdb_get();
-        vdb_p->area.x1 = 0;
-        vdb_p->area.x2 = LV_HOR_RES-1;
-        vdb_p->area.y1 = 0;
-        vdb_p->area.y2 = LV_VER_RES - 1;
+        bool area_set = false;
+        uint16_t i;
+        for(i = 0; i < inv_buf_p; i++) {
+            if(inv_buf[i].joined) continue;
+            if(!area_set) {
+                lv_area_copy(&vdb_p->area, &inv_buf[i].area);
+                area_set = true;
+            } else {
+                lv_area_join(&vdb_p->area, &vdb_p->area, &inv_buf[i].area);
+            }
+        }
 
         /*Flush the content of the VDB*/
         lv_vdb_flush();
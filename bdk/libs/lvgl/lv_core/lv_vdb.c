@@ -103,7 +103,7 @@ void lv_vdb_flush(void)
 
     /*Don't start a new flush while the previous is not finished*/
 #if LV_VDB_DOUBLE
-    while(vdb_flushing);
+    while(vdb_flushing) lv_disp_flush_wait();
 #endif  /*LV_VDB_DOUBLE*/
 
     vdb_flushing = true;
@@ -57,6 +57,7 @@ void lv_disp_drv_init(lv_disp_drv_t * driver)
     driver->disp_fill = NULL;
     driver->disp_map = NULL;
     driver->disp_flush = NULL;
+    driver->disp_flush_wait = NULL;
 
 #if USE_LV_GPU
     driver->mem_blend = NULL;
@@ -168,6 +169,15 @@ void lv_disp_flush(int32_t x1, int32_t y1, int32_t x2, int32_t y2, lv_color_t *
     }
 }
 
+/**
+ * Wait for an asynchronous flush of the active display to finish
+ */
+void lv_disp_flush_wait(void)
+{
+    if(active == NULL) return;
+    if(active->driver.disp_flush_wait != NULL) active->driver.disp_flush_wait();
+}
+
 /**
  * Put a color map to a rectangular area on the active display
  * @param x1 left coordinate of the rectangle
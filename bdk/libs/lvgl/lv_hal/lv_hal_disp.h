@@ -35,6 +35,9 @@ typedef struct _disp_drv_t {
     /*Write the internal buffer (VDB) to the display. 'lv_flush_ready()' has to be called when finished*/
     void (*disp_flush)(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const lv_color_t * color_p);
 
+    /*Optional: Wait for an asynchronous flush to finish. 'lv_flush_ready()' has to be called when finished*/
+    void (*disp_flush_wait)(void);
+
     /*Fill an area with a color on the display*/
     void (*disp_fill)(int32_t x1, int32_t y1, int32_t x2, int32_t y2, lv_color_t color);
 
@@ -110,6 +113,11 @@ lv_disp_t * lv_disp_next(lv_disp_t * disp);
  */
 void lv_disp_flush(int32_t x1, int32_t y1, int32_t x2, int32_t y2, lv_color_t *color_p);
 
+/**
+ * Wait for an asynchronous flush of the active display to finish
+ */
+void lv_disp_flush_wait(void);
+
 /**
  * Fill a rectangular area with a color on the active display
  * @param x1 left coordinate of the rectangle
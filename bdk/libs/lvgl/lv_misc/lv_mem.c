@@ -33,6 +33,16 @@
 #include LV_MEM_CUSTOM_INCLUDE
 #endif
 
+#if LV_MEM_CUSTOM != 0 && defined(LV_MEM_CUSTOM_POOL)
+# define MEM_CUSTOM_ALLOC(size)          LV_MEM_CUSTOM_ALLOC(&mem_pool, size)
+# define MEM_CUSTOM_FREE(p)              LV_MEM_CUSTOM_FREE(&mem_pool, p)
+# define MEM_CUSTOM_RESIZE(p, size)      LV_MEM_CUSTOM_RESIZE(&mem_pool, p, size)
+#elif LV_MEM_CUSTOM != 0
+# define MEM_CUSTOM_ALLOC(size)          LV_MEM_CUSTOM_ALLOC(size)
+# define MEM_CUSTOM_FREE(p)              LV_MEM_CUSTOM_FREE(p)
+# define MEM_CUSTOM_RESIZE(p, size)      LV_MEM_CUSTOM_RESIZE(p, size)
+#endif
+
 /*********************
  *      DEFINES
  *********************/
@@ -85,6 +95,8 @@ static void ent_trunc(lv_mem_ent_t * e, uint32_t size);
  **********************/
 #if LV_MEM_CUSTOM == 0
 static uint8_t * work_mem;
+#elif defined(LV_MEM_CUSTOM_POOL)
+static LV_MEM_CUSTOM_POOL mem_pool;
 #endif
 
 static uint32_t zero_mem;       /*Give the address of this variable if 0 byte should be allocated*/
@@ -116,6 +128,8 @@ void lv_mem_init(void)
     full->header.used = 0;
     /*The total mem size id reduced by the first header and the close patterns */
     full->header.d_size = LV_MEM_SIZE - sizeof(lv_mem_header_t);
+#elif defined(LV_MEM_CUSTOM_POOL)
+    LV_MEM_CUSTOM_INIT(&mem_pool, (void *)LV_MEM_CUSTOM_ADR, LV_MEM_CUSTOM_SIZE);
 #endif
 }
 
@@ -156,10 +170,10 @@ void * lv_mem_alloc(uint32_t size)
 
 #else  /*Use custom, user defined malloc function*/
 #if LV_ENABLE_GC == 1 /*gc must not include header*/
-    alloc = LV_MEM_CUSTOM_ALLOC(size);
+    alloc = MEM_CUSTOM_ALLOC(size);
 #else /* LV_ENABLE_GC */
     /*Allocate a header too to store the size*/
-    alloc = LV_MEM_CUSTOM_ALLOC(size + sizeof(lv_mem_header_t));
+    alloc = MEM_CUSTOM_ALLOC(size + sizeof(lv_mem_header_t));
     if(alloc != NULL) {
         ((lv_mem_ent_t *) alloc)->header.d_size = size;
         ((lv_mem_ent_t *) alloc)->header.used = 1;
@@ -214,9 +228,9 @@ void lv_mem_free(const void * data)
 #endif
 #else /*Use custom, user defined free function*/
 #if LV_ENABLE_GC==0
-    LV_MEM_CUSTOM_FREE(e);
+    MEM_CUSTOM_FREE(e);
 #else
-    LV_MEM_CUSTOM_FREE((void*)data);
+    MEM_CUSTOM_FREE((void*)data);
 #endif /*LV_ENABLE_GC*/
 #endif
 }
@@ -258,6 +272,20 @@ void * lv_mem_realloc(void * data_p, uint32_t new_size)
         ent_trunc(e, new_size);
         return &e->first_data;
     }
+#elif defined(LV_MEM_CUSTOM_RESIZE)
+    /*Let the allocator resize in place if possible*/
+    if(data_p != NULL && old_size != 0) {
+        lv_mem_ent_t * e = (lv_mem_ent_t *)((uint8_t *) data_p - sizeof(lv_mem_header_t));
+        e = MEM_CUSTOM_RESIZE(e, new_size + sizeof(lv_mem_header_t));
+        if(e == NULL) {
+            LV_LOG_WARN("Couldn't allocate memory");
+            return NULL;
+        }
+
+        e->header.d_size = new_size;
+        e->header.used = 1;
+        return &e->first_data;
+    }
 #endif
 
     void * new_p;
@@ -362,6 +390,24 @@ void lv_mem_monitor(lv_mem_monitor_t * mon_p)
     mon_p->used_pct = 100 - ((uint64_t)100U * mon_p->free_size) / mon_p->total_size;
     mon_p->frag_pct = (uint32_t)mon_p->free_biggest_size * 100U / mon_p->free_size;
     mon_p->frag_pct = 100 - mon_p->frag_pct;
+#elif defined(LV_MEM_CUSTOM_MONITOR)
+    LV_MEM_CUSTOM_MONITOR_T pool_mon;
+    LV_MEM_CUSTOM_MONITOR(&mem_pool, &pool_mon);
+
+    /*Space above the top of the pool is free too*/
+    uint32_t top_free = LV_MEM_CUSTOM_SIZE - pool_mon.total;
+
+    mon_p->total_size = LV_MEM_CUSTOM_SIZE;
+    mon_p->used_cnt = pool_mon.nodes_used;
+    mon_p->free_cnt = pool_mon.nodes_total - pool_mon.nodes_used + (top_free ? 1 : 0);
+    mon_p->free_size = pool_mon.free_total + top_free;
+    mon_p->free_biggest_size = LV_MATH_MAX(pool_mon.free_largest, top_free);
+    mon_p->used_pct = 100 - ((uint64_t)100U * mon_p->free_size) / mon_p->total_size;
+    mon_p->frag_pct = 0;
+    if(mon_p->free_size) {
+        mon_p->frag_pct = (uint32_t)((uint64_t)mon_p->free_biggest_size * 100U / mon_p->free_size);
+        mon_p->frag_pct = 100 - mon_p->frag_pct;
+    }
 #endif
 }
 
@@ -296,6 +296,45 @@ uint8_t lv_task_get_idle(void)
     return idle_last;
 }
 
+/**
+ * Get the time until the next lv_task is due
+ * @return time in milliseconds until a task has to run (0: a task is due now, UINT32_MAX: no active task)
+ */
+uint32_t lv_task_get_next_run(void)
+{
+    uint32_t next = UINT32_MAX;
+    lv_task_t * task;
+
+    LL_READ(LV_GC_ROOT(_lv_task_ll), task) {
+        /*Tasks are ordered by priority so the rest are turned off too*/
+        if(task->prio == LV_TASK_PRIO_OFF) break;
+
+        uint32_t elp = lv_tick_elaps(task->last_run);
+        if(elp >= task->period) return 0;
+        if(task->period - elp < next) next = task->period - elp;
+    }
+
+    return next;
+}
+
+/**
+ * Check if a one shot lv_task is queued
+ * @return true: an active one shot lv_task waits to run
+ */
+bool lv_task_once_pending(void)
+{
+    lv_task_t * task;
+
+    LL_READ(LV_GC_ROOT(_lv_task_ll), task) {
+        /*Tasks are ordered by priority so the rest are turned off too*/
+        if(task->prio == LV_TASK_PRIO_OFF) break;
+
+        if(task->once) return true;
+    }
+
+    return false;
+}
+
 
 /**********************
  *   STATIC FUNCTIONS
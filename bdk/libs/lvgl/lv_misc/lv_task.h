@@ -138,6 +138,18 @@ void lv_task_enable(bool en);
  */
 uint8_t lv_task_get_idle(void);
 
+/**
+ * Get the time until the next lv_task is due
+ * @return time in milliseconds until a task has to run (0: a task is due now, UINT32_MAX: no active task)
+ */
+uint32_t lv_task_get_next_run(void);
+
+/**
+ * Check if a one shot lv_task is queued
+ * @return true: an active one shot lv_task waits to run
+ */
+bool lv_task_once_pending(void);
+
 /**********************
  *      MACROS
  **********************/
@@ -21,15 +21,107 @@
 
 heap_t _heap;
 
-static void _heap_create(void *start)
+#define HEAP_SMALL_BLOCK_LOG (HEAP_SL_COUNT_LOG + 5) // 32B granularity.
+#define HEAP_SMALL_BLOCK     (1 << HEAP_SMALL_BLOCK_LOG)
+
+static void _heap_create(heap_t *heap, void *start, u32 size)
+{
+	memset(heap, 0, sizeof(heap_t));
+	heap->start = start;
+	heap->end   = size ? start + size : NULL;
+}
+
+#ifndef BDK_MALLOC_NO_DEFRAG
+static inline u32 _heap_fls(u32 val)
+{
+	return 31 - __builtin_clz(val);
+}
+
+static void _heap_mapping(u32 size, u32 *fl, u32 *sl)
+{
+	if (size < HEAP_SMALL_BLOCK)
+	{
+		*fl = 0;
+		*sl = size / (HEAP_SMALL_BLOCK / HEAP_SL_COUNT);
+	}
+	else
+	{
+		u32 msb = _heap_fls(size);
+		*sl = (size >> (msb - HEAP_SL_COUNT_LOG)) ^ HEAP_SL_COUNT;
+		*fl = msb - (HEAP_SMALL_BLOCK_LOG - 1);
+	}
+}
+
+static void _heap_bin_insert(heap_t *heap, hnode_t *node)
+{
+	u32 fl, sl;
+	_heap_mapping(node->size, &fl, &sl);
+
+	node->free_prev = NULL;
+	node->free_next = heap->bins[fl][sl];
+	if (node->free_next)
+		node->free_next->free_prev = node;
+	heap->bins[fl][sl] = node;
+
+	heap->fl_bitmap     |= BIT(fl);
+	heap->sl_bitmap[fl] |= BIT(sl);
+}
+
+static void _heap_bin_remove(heap_t *heap, hnode_t *node)
 {
-	_heap.start = start;
-	_heap.first = NULL;
-	_heap.last = NULL;
+	u32 fl, sl;
+	_heap_mapping(node->size, &fl, &sl);
+
+	if (node->free_next)
+		node->free_next->free_prev = node->free_prev;
+
+	if (node->free_prev)
+		node->free_prev->free_next = node->free_next;
+	else
+	{
+		heap->bins[fl][sl] = node->free_next;
+
+		// Clear bitmaps if bin got empty.
+		if (!node->free_next)
+		{
+			heap->sl_bitmap[fl] &= ~BIT(sl);
+			if (!heap->sl_bitmap[fl])
+				heap->fl_bitmap &= ~BIT(fl);
+		}
+	}
 }
 
+static hnode_t *_heap_bin_find(heap_t *heap, u32 size)
+{
+	u32 fl, sl;
+
+	// Round up to the next bin, so any block in it fits.
+	if (size >= HEAP_SMALL_BLOCK)
+		size += (1 << (_heap_fls(size) - HEAP_SL_COUNT_LOG)) - 1;
+	_heap_mapping(size, &fl, &sl);
+
+	if (fl >= HEAP_FL_COUNT)
+		return NULL;
+
+	// Search current first level, then any larger one.
+	u32 sl_map = heap->sl_bitmap[fl] & (~0U << sl);
+	if (!sl_map)
+	{
+		u32 fl_map = (fl + 1) < HEAP_FL_COUNT ? heap->fl_bitmap & (~0U << (fl + 1)) : 0;
+		if (!fl_map)
+			return NULL;
+
+		fl = __builtin_ctz(fl_map);
+		sl_map = heap->sl_bitmap[fl];
+	}
+	sl = __builtin_ctz(sl_map);
+
+	return heap->bins[fl][sl];
+}
+#endif
+
 // Node info is before node address.
-static void *_heap_alloc(u32 size)
+static void *_heap_alloc(heap_t *heap, u32 size)
 {
 	hnode_t *node, *new_node;
 
@@ -37,109 +129,233 @@ static void *_heap_alloc(u32 size)
 	size = ALIGN(size, sizeof(hnode_t));
 
 	// First allocation.
-	if (!_heap.first)
+	if (!heap->first)
 	{
-		node = (hnode_t *)_heap.start;
+		node = (hnode_t *)heap->start;
+		if (heap->end && ((void *)node + sizeof(hnode_t) + size) > heap->end)
+			return NULL;
+
 		node->used = 1;
 		node->size = size;
 		node->prev = NULL;
 		node->next = NULL;
 
-		_heap.first = node;
-		_heap.last = node;
+		heap->first = node;
+		heap->last = node;
 
 		return (void *)node + sizeof(hnode_t);
 	}
 
-#ifdef BDK_MALLOC_NO_DEFRAG
-	// Get the last allocated block.
-	node = _heap.last;
-#else
-	// Get first block and find the first available one.
-	node = _heap.first;
-	while (true)
+#ifndef BDK_MALLOC_NO_DEFRAG
+	// Get a free block from the bins.
+	node = _heap_bin_find(heap, size);
+	if (node)
 	{
-		// Check if there's available unused node.
-		if (!node->used && (size <= node->size))
+		_heap_bin_remove(heap, node);
+
+		// Size and offset of the new unused node.
+		u32 new_size = node->size - size;
+		new_node = (hnode_t *)((void *)node + sizeof(hnode_t) + size);
+
+		// If there's aligned unused space from the old node,
+		// create a new one and set the leftover size.
+		if (new_size >= (sizeof(hnode_t) << 2))
 		{
-			// Size and offset of the new unused node.
-			u32 new_size = node->size - size;
-			new_node = (hnode_t *)((void *)node + sizeof(hnode_t) + size);
-
-			// If there's aligned unused space from the old node,
-			// create a new one and set the leftover size.
-			if (new_size >= (sizeof(hnode_t) << 2))
-			{
-				new_node->size = new_size - sizeof(hnode_t);
-				new_node->used = 0;
-				new_node->next = node->next;
-
-				// Check that we are not on first node.
-				if (new_node->next)
-					new_node->next->prev = new_node;
-
-				new_node->prev = node;
-				node->next = new_node;
-			}
-			else // Unused node size is just enough.
-				size += new_size;
+			new_node->size = new_size - sizeof(hnode_t);
+			new_node->used = 0;
+			new_node->next = node->next;
 
+			// Free node is never last, since top of heap is dropped on free.
+			new_node->next->prev = new_node;
+
+			new_node->prev = node;
+			node->next = new_node;
 			node->size = size;
-			node->used = 1;
 
-			return (void *)node + sizeof(hnode_t);
+			_heap_bin_insert(heap, new_node);
 		}
 
-		// No unused node found, try the next one.
-		if (node->next)
-			node = node->next;
-		else
-			break;
+		node->used = 1;
+
+		return (void *)node + sizeof(hnode_t);
 	}
 #endif
 
-	// No unused node found, create a new one.
+	// No unused node found, create a new one at the top.
+	node = heap->last;
 	new_node = (hnode_t *)((void *)node + sizeof(hnode_t) + node->size);
+	if (heap->end && ((void *)new_node + sizeof(hnode_t) + size) > heap->end)
+		return NULL;
+
 	new_node->used = 1;
 	new_node->size = size;
 	new_node->prev = node;
 	new_node->next = NULL;
 
 	node->next = new_node;
-	_heap.last = new_node;
+	heap->last = new_node;
 
 	return (void *)new_node + sizeof(hnode_t);
 }
 
-static void _heap_free(void *addr)
+static void _heap_free(heap_t *heap, void *addr)
 {
 	hnode_t *node = (hnode_t *)(addr - sizeof(hnode_t));
 	node->used = 0;
-	node = _heap.first;
 
 #ifndef BDK_MALLOC_NO_DEFRAG
-	// Do simple defragmentation on next blocks.
+	// Merge with next block if free.
+	hnode_t *next = node->next;
+	if (next && !next->used)
+	{
+		_heap_bin_remove(heap, next);
+
+		node->size += next->size + sizeof(hnode_t);
+		node->next = next->next;
+		if (node->next)
+			node->next->prev = node;
+	}
+
+	// Merge with previous block if free.
+	hnode_t *prev = node->prev;
+	if (prev && !prev->used)
+	{
+		_heap_bin_remove(heap, prev);
+
+		prev->size += node->size + sizeof(hnode_t);
+		prev->next = node->next;
+		if (prev->next)
+			prev->next->prev = prev;
+
+		node = prev;
+	}
+
+	// Give block back to the top of the heap if last.
+	if (!node->next)
+	{
+		heap->last = node->prev;
+		if (node->prev)
+			node->prev->next = NULL;
+		else
+			heap->first = NULL;
+	}
+	else
+		_heap_bin_insert(heap, node);
+#endif
+}
+
+static void *_heap_realloc(heap_t *heap, void *addr, u32 size)
+{
+	if (!addr)
+		return _heap_alloc(heap, size);
+
+	hnode_t *node = (hnode_t *)(addr - sizeof(hnode_t));
+	u32 old_size = node->size;
+
+	// Align to cache line size.
+	size = ALIGN(size, sizeof(hnode_t));
+
+	// Resize in place if last, since the top of the heap is free.
+	if (!node->next)
+	{
+		if (heap->end && (addr + size) > heap->end)
+			return NULL;
+
+		node->size = size;
+
+		return addr;
+	}
+
+#ifndef BDK_MALLOC_NO_DEFRAG
+	// Grow in place by merging with the next block if free and big enough.
+	hnode_t *next = node->next;
+	if (size > node->size && !next->used && (node->size + sizeof(hnode_t) + next->size) >= size)
+	{
+		_heap_bin_remove(heap, next);
+
+		node->size += next->size + sizeof(hnode_t);
+		node->next = next->next;
+		if (node->next)
+			node->next->prev = node;
+	}
+
+	if (size <= node->size)
+	{
+		// Give back any aligned unused space. Freeing it merges it with the next block.
+		if ((node->size - size) >= (sizeof(hnode_t) << 2))
+		{
+			hnode_t *new_node = (hnode_t *)(addr + size);
+			new_node->used = 1;
+			new_node->size = node->size - size - sizeof(hnode_t);
+			new_node->next = node->next;
+			new_node->prev = node;
+			if (new_node->next)
+				new_node->next->prev = new_node;
+			else
+				heap->last = new_node;
+
+			node->next = new_node;
+			node->size = size;
+
+			_heap_free(heap, (void *)new_node + sizeof(hnode_t));
+		}
+
+		return addr;
+	}
+#else
+	if (size <= node->size)
+		return addr;
+#endif
+
+	// Relocate.
+	void *buf = _heap_alloc(heap, size);
+	if (!buf)
+		return NULL;
+
+	memcpy(buf, addr, MIN(old_size, size));
+	_heap_free(heap, addr);
+
+	return buf;
+}
+
+static void _heap_monitor(heap_t *heap, heap_monitor_t *mon, bool print_node_stats)
+{
+	u32 count = 0;
+	memset(mon, 0, sizeof(heap_monitor_t));
+
+	hnode_t *node = heap->first;
 	while (node)
 	{
-		if (!node->used)
+		if (node->used)
 		{
-			if (node->prev && !node->prev->used)
-			{
-				node->prev->size += node->size + sizeof(hnode_t);
-				node->prev->next = node->next;
-
-				if (node->next)
-					node->next->prev = node->prev;
-			}
+			mon->nodes_used++;
+			mon->used += node->size + sizeof(hnode_t);
 		}
+		else
+		{
+			mon->total += node->size + sizeof(hnode_t);
+			mon->free_total += node->size;
+			if (node->size > mon->free_largest)
+				mon->free_largest = node->size;
+		}
+
+		if (print_node_stats)
+			gfx_printf("%3d - %d, addr: 0x%08X, size: 0x%X\n",
+				count, node->used, (u32)node + sizeof(hnode_t), node->size);
+
+		count++;
 		node = node->next;
 	}
-#endif
+	mon->total += mon->used;
+	mon->nodes_total = count;
+
+	if (mon->free_total)
+		mon->fragmentation = 100 - (u32)(((u64)mon->free_largest * 100) / mon->free_total);
 }
 
 void heap_init(void *base)
 {
-	_heap_create(base);
+	_heap_create(&_heap, base, 0);
 }
 
 void heap_set(heap_t *heap)
@@ -149,19 +365,19 @@ void heap_set(heap_t *heap)
 
 void *malloc(u32 size)
 {
-	return _heap_alloc(size);
+	return _heap_alloc(&_heap, size);
 }
 
 void *calloc(u32 num, u32 size)
 {
-	void *res = (void *)_heap_alloc(num * size);
+	void *res = (void *)_heap_alloc(&_heap, num * size);
 	memset(res, 0, ALIGN(num * size, sizeof(hnode_t))); // Clear the aligned size.
 	return res;
 }
 
 void *zalloc(u32 size)
 {
-	void *res = (void *)_heap_alloc(size);
+	void *res = (void *)_heap_alloc(&_heap, size);
 	memset(res, 0, ALIGN(size, sizeof(hnode_t))); // Clear the aligned size.
 	return res;
 }
@@ -169,36 +385,36 @@ void *zalloc(u32 size)
 void free(void *buf)
 {
 	if (buf >= _heap.start)
-		_heap_free(buf);
+		_heap_free(&_heap, buf);
 }
 
 void heap_monitor(heap_monitor_t *mon, bool print_node_stats)
 {
-	u32 count = 0;
-	memset(mon, 0, sizeof(heap_monitor_t));
+	_heap_monitor(&_heap, mon, print_node_stats);
+}
 
-	hnode_t *node = _heap.first;
-	while (true)
-	{
-		if (node->used)
-		{
-			mon->nodes_used++;
-			mon->used += node->size + sizeof(hnode_t);
-		}
-		else
-			mon->total += node->size + sizeof(hnode_t);
+void heap_pool_init(heap_t *heap, void *base, u32 size)
+{
+	_heap_create(heap, base, size);
+}
 
-		if (print_node_stats)
-			gfx_printf("%3d - %d, addr: 0x%08X, size: 0x%X\n",
-				count, node->used, (u32)node + sizeof(hnode_t), node->size);
+void *heap_pool_alloc(heap_t *heap, u32 size)
+{
+	return _heap_alloc(heap, size);
+}
 
-		count++;
+void *heap_pool_realloc(heap_t *heap, void *buf, u32 size)
+{
+	return _heap_realloc(heap, buf, size);
+}
 
-		if (node->next)
-			node = node->next;
-		else
-			break;
-	}
-	mon->total += mon->used;
-	mon->nodes_total = count;
+void heap_pool_free(heap_t *heap, void *buf)
+{
+	if (buf >= heap->start)
+		_heap_free(heap, buf);
+}
+
+void heap_pool_monitor(heap_t *heap, heap_monitor_t *mon)
+{
+	_heap_monitor(heap, mon, false);
 }
@@ -20,20 +20,34 @@
 
 #include <utils/types.h>
 
+// Segregated free lists. First level is power of 2, second level splits it in 16.
+#define HEAP_FL_COUNT     24
+#define HEAP_SL_COUNT_LOG 4
+#define HEAP_SL_COUNT     (1 << HEAP_SL_COUNT_LOG)
+
 typedef struct _hnode
 {
 	int used;
 	u32 size;
 	struct _hnode *prev;
 	struct _hnode *next;
-	u32 align[4]; // Align to arch cache line size.
+	struct _hnode *free_prev;
+	struct _hnode *free_next;
+	u32 align[2]; // Align to arch cache line size.
 } hnode_t;
 
+// Shared with modules via bdkParams_t. Keep the first members in place, so older
+// modules that copy it with heap_set() still get a valid start/first/last.
+// Free bins are not synced back, so the caller must not use them after a module run.
 typedef struct _heap
 {
 	void *start;
 	hnode_t *first;
 	hnode_t *last;
+	void *end; // NULL if unbounded.
+	u32 fl_bitmap;
+	u16 sl_bitmap[HEAP_FL_COUNT];
+	hnode_t *bins[HEAP_FL_COUNT][HEAP_SL_COUNT];
 } heap_t;
 
 typedef struct
@@ -42,6 +56,9 @@ typedef struct
 	u32 used;
 	u32 nodes_total;
 	u32 nodes_used;
+	u32 free_total;    // Free space below the top of the heap.
+	u32 free_largest;
+	u32 fragmentation; // Percentage of free space not in the largest free block.
 } heap_monitor_t;
 
 void heap_init(void *base);
@@ -52,4 +69,11 @@ void *zalloc(u32 size);
 void free(void *buf);
 void heap_monitor(heap_monitor_t *mon, bool print_node_stats);
 
+// Separate heap pools.
+void  heap_pool_init(heap_t *heap, void *base, u32 size);
+void *heap_pool_alloc(heap_t *heap, u32 size);
+void *heap_pool_realloc(heap_t *heap, void *buf, u32 size);
+void  heap_pool_free(heap_t *heap, void *buf);
+void  heap_pool_monitor(heap_t *heap, heap_monitor_t *mon);
+
 #endif
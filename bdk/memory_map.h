@@ -62,9 +62,9 @@
 
 // NX BIS driver sector cache.
 #define NX_BIS_CACHE_ADDR  0xC5000000
-#define  NX_BIS_CACHE_SZ   0x10020000 // 256MB.
+#define  NX_BIS_CACHE_SZ   0x10048000 // 256MB.
 #define NX_BIS_LOOKUP_ADDR 0xD6000000
-#define  NX_BIS_LOOKUP_SZ   0xF000000 // 240MB.
+#define  NX_BIS_LOOKUP_SZ      SZ_32K
 
 // L4T Kernel Panic Storage (PSTORE).
 #define PSTORE_ADDR   0xB0000000
@@ -79,6 +79,10 @@
 
 // Nyx buffers.
 #define NYX_STORAGE_ADDR 0xED000000
+
+// SDMMC ADMA2 descriptor tables. One per controller.
+#define SDMMC_ADMA_ADDR    0xEDF00000
+#define  SDMMC_ADMA_SZ        SZ_64K
 #define NYX_RES_ADDR     0xEE000000
 #define  NYX_RES_SZ          SZ_16M
 
@@ -101,6 +105,7 @@
 #define  LOG_FB_SZ         0x334000 // 1280 x 656 x 4.
 #define NYX_FB_ADDRESS   0xF6200000
 #define NYX_FB2_ADDRESS  0xF6600000
+#define NYX_LV_VDB2_ADR  NYX_FB2_ADDRESS // LvGL second VDB. VIC composes directly from VDBs.
 #define  NYX_FB_SZ         0x384000 // 1280 x 720 x 4.
 
 /* OBSOLETE: Very old hwinit based payloads were setting a carveout here. */
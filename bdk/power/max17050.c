@@ -60,71 +60,56 @@ static u16 max17050_get_reg(u8 reg)
 	return data;
 }
 
-int max17050_get_property(enum MAX17050_reg reg, int *value)
+static int _max17050_convert(enum MAX17050_reg reg, u16 data, int *value)
 {
-	u16 data;
-
 	switch (reg)
 	{
 	case MAX17050_Age: // Age (percent). Based on 100% x (FullCAP Register/DesignCap).
-		data = max17050_get_reg(MAX17050_Age);
 		*value = data >> 8; /* Show MSB. 1% increments */
 		break;
 	case MAX17050_Cycles: // Cycle count.
-		*value = max17050_get_reg(MAX17050_Cycles);
+		*value = data;
 		break;
 	case MAX17050_MinVolt: // Voltage max/min
-		data = max17050_get_reg(MAX17050_MinMaxVolt);
 		*value = (data & 0xff) * 20; /* Voltage MIN. Units of 20mV */
 		break;
 	case MAX17050_MaxVolt: // Voltage max/min
-		data = max17050_get_reg(MAX17050_MinMaxVolt);
 		*value = (data >> 8) * 20; /* Voltage MAX. Units of LSB = 20mV */
 		break;
 	case MAX17050_V_empty: // Voltage min design.
-		data = max17050_get_reg(MAX17050_V_empty);
 		*value = (data >> 7) * 10; /* Units of LSB = 10mV */
 		break;
 	case MAX17050_VCELL: // Voltage now.
-		data = max17050_get_reg(MAX17050_VCELL);
 		*value = (data >> 3) * 625 / 1000; /* Units of LSB = 0.625mV */
 		battery_voltage = *value;
 		break;
 	case MAX17050_AvgVCELL: // Voltage avg.
-		data = max17050_get_reg(MAX17050_AvgVCELL);
 		*value = (data >> 3) * 625 / 1000; /* Units of LSB = 0.625mV */
 		break;
 	case MAX17050_OCVInternal: // Voltage ocv.
-		data = max17050_get_reg(MAX17050_OCVInternal);
 		*value = (data >> 3) * 625 / 1000; /* Units of LSB = 0.625mV */
 		break;
 	case MAX17050_RepSOC: // Capacity %.
-		*value = max17050_get_reg(MAX17050_RepSOC);
+		*value = data;
 		break;
 	case MAX17050_DesignCap: // Charge full design.
-		data = max17050_get_reg(MAX17050_DesignCap);
 		*value = data * (BASE_SNS_UOHM / MAX17050_BOARD_SNS_RESISTOR_UOHM) / MAX17050_BOARD_CGAIN;
 		break;
 	case MAX17050_FullCAP: // Charge full.
-		data = max17050_get_reg(MAX17050_FullCAP);
 		*value = data * (BASE_SNS_UOHM / MAX17050_BOARD_SNS_RESISTOR_UOHM) / MAX17050_BOARD_CGAIN;
 		break;
 	case MAX17050_RepCap: // Charge now.
-		data = max17050_get_reg(MAX17050_RepCap);
 		*value = data * (BASE_SNS_UOHM / MAX17050_BOARD_SNS_RESISTOR_UOHM) / MAX17050_BOARD_CGAIN;
 		break;
 	case MAX17050_TEMP: // Temp.
-		data = max17050_get_reg(MAX17050_TEMP);
 		*value = (s16)data;
 		*value = *value * 10 / 256;
 		break;
 	case MAX17050_Current: // Current now.
-		data = max17050_get_reg(MAX17050_Current);
 		*value = (s16)data;
 		*value *= 1562500 / (MAX17050_BOARD_SNS_RESISTOR_UOHM * MAX17050_BOARD_CGAIN);
 		break;
 	case MAX17050_AvgCurrent: // Current avg.
-		data = max17050_get_reg(MAX17050_AvgCurrent);
 		*value = (s16)data;
 		*value *= 1562500 / (MAX17050_BOARD_SNS_RESISTOR_UOHM * MAX17050_BOARD_CGAIN);
 		break;
@@ -134,6 +119,30 @@ int max17050_get_property(enum MAX17050_reg reg, int *value)
 	return 0;
 }
 
+int max17050_get_property(enum MAX17050_reg reg, int *value)
+{
+	// Min and max voltage are both in MinMaxVolt.
+	u8 hw_reg = (reg == MAX17050_MinVolt || reg == MAX17050_MaxVolt) ? MAX17050_MinMaxVolt : reg;
+
+	return _max17050_convert(reg, max17050_get_reg(hw_reg), value);
+}
+
+int max17050_get_properties(enum MAX17050_reg reg, u32 count, int *values)
+{
+	u16 data[16];
+
+	// Burst read consecutive registers. The address auto-increments.
+	if (count > 16 || !i2c_recv_buf_big((u8 *)data, count * 2, I2C_1, MAXIM17050_I2C_ADDR, reg))
+		return -1;
+
+	// Registers without a conversion are returned raw.
+	for (u32 i = 0; i < count; i++)
+		if (_max17050_convert(reg + i, data[i], &values[i]))
+			values[i] = data[i];
+
+	return 0;
+}
+
 static int _max17050_write_verify_reg(u8 reg, u16 value)
 {
 	int retries = 8;
@@ -131,6 +131,7 @@ enum MAX17050_reg {
 };
 
 int  max17050_get_property(enum MAX17050_reg reg, int *value);
+int  max17050_get_properties(enum MAX17050_reg reg, u32 count, int *values);
 int  max17050_fix_configuration();
 void max17050_dump_regs(void *buf);
 u32  max17050_get_cached_batt_volt();
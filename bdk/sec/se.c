@@ -38,34 +38,75 @@ se_ll_t *ll_src_ptr, *ll_dst_ptr; // Must be u32 aligned.
 
 static void _gf256_mul_x(void *block)
 {
-	u8 *pdata = (u8 *)block;
-	u32 carry = 0;
+	u32 *pdata = (u32 *)block;
 
-	for (int i = 0xF; i >= 0; i--)
+	// Big endian 128-bit value. Word 3 holds the least significant bits.
+	u32 w0 = byte_swap_32(pdata[0]);
+	u32 w1 = byte_swap_32(pdata[1]);
+	u32 w2 = byte_swap_32(pdata[2]);
+	u32 w3 = byte_swap_32(pdata[3]);
+	u32 carry = w0 >> 31;
+
+	pdata[0] = byte_swap_32((w0 << 1) | (w1 >> 31));
+	pdata[1] = byte_swap_32((w1 << 1) | (w2 >> 31));
+	pdata[2] = byte_swap_32((w2 << 1) | (w3 >> 31));
+	pdata[3] = byte_swap_32((w3 << 1) ^ (0x87 & -carry));
+}
+
+static void _gf256_mul_xn_le(void *block, u32 n)
+{
+	u32 *pdata = (u32 *)block;
+	u64 lo = ((u64)pdata[1] << 32) | pdata[0];
+	u64 hi = ((u64)pdata[3] << 32) | pdata[2];
+
+	// Multiply by x^n, up to 56 bits at a time so the reduction of the shifted out bits fits in the low word.
+	while (n)
 	{
-		u8 b = pdata[i];
-		pdata[i] = (b << 1) | carry;
-		carry = b >> 7;
+		u32 shift = MIN(n, 56);
+		u64 ovf = hi >> (64 - shift);
+
+		hi = (hi << shift) | (lo >> (64 - shift));
+		lo = (lo << shift) ^ ovf ^ (ovf << 1) ^ (ovf << 2) ^ (ovf << 7);
+
+		n -= shift;
 	}
 
-	if (carry)
-		pdata[0xF] ^= 0x87;
+	pdata[0] = lo;
+	pdata[1] = lo >> 32;
+	pdata[2] = hi;
+	pdata[3] = hi >> 32;
 }
 
-static void _gf256_mul_x_le(void *block)
+static void _gf256_xor_mul_x_le(u32 *pdst, const u32 *psrc, void *block, u32 blocks)
 {
 	u32 *pdata = (u32 *)block;
-	u32 carry = 0;
+	u32 t0 = pdata[0];
+	u32 t1 = pdata[1];
+	u32 t2 = pdata[2];
+	u32 t3 = pdata[3];
 
-	for (u32 i = 0; i < 4; i++)
+	// XOR each 16-byte block with the tweak and advance it, keeping the tweak in registers.
+	for (u32 i = 0; i < blocks; i++)
 	{
-		u32 b = pdata[i];
-		pdata[i] = (b << 1) | carry;
-		carry = b >> 31;
+		pdst[0] = psrc[0] ^ t0;
+		pdst[1] = psrc[1] ^ t1;
+		pdst[2] = psrc[2] ^ t2;
+		pdst[3] = psrc[3] ^ t3;
+
+		u32 carry = t3 >> 31;
+		t3 = (t3 << 1) | (t2 >> 31);
+		t2 = (t2 << 1) | (t1 >> 31);
+		t1 = (t1 << 1) | (t0 >> 31);
+		t0 = (t0 << 1) ^ (0x87 & -carry);
+
+		psrc += 4;
+		pdst += 4;
 	}
 
-	if (carry)
-		pdata[0x0] ^= 0x87;
+	pdata[0] = t0;
+	pdata[1] = t1;
+	pdata[2] = t2;
+	pdata[3] = t3;
 }
 
 static void _se_ll_init(se_ll_t *ll, u32 addr, u32 size)
@@ -427,7 +468,6 @@ int se_aes_xts_crypt_sec_nx(u32 tweak_ks, u32 crypt_ks, u32 enc, u64 sec, u8 *tw
 {
 	u32 *pdst = (u32 *)dst;
 	u32 *psrc = (u32 *)src;
-	u32 *ptweak = (u32 *)tweak;
 
 	if (regen_tweak)
 	{
@@ -440,39 +480,84 @@ int se_aes_xts_crypt_sec_nx(u32 tweak_ks, u32 crypt_ks, u32 enc, u64 sec, u8 *tw
 			return 0;
 	}
 
-	// tweak_exp allows using a saved tweak to reduce _gf256_mul_x_le calls.
-	for (u32 i = 0; i < (tweak_exp << 5); i++)
-		_gf256_mul_x_le(tweak);
+	// tweak_exp allows using a saved tweak to skip fast-forwarding from the sector start.
+	_gf256_mul_xn_le(tweak, tweak_exp << 5);
 
 	u8 orig_tweak[SE_KEY_128_SIZE] __attribute__((aligned(4)));
 	memcpy(orig_tweak, tweak, SE_KEY_128_SIZE);
 
 	// We are assuming a 16 sector aligned size in this implementation.
-	for (u32 i = 0; i < (sec_size >> 4); i++)
+	_gf256_xor_mul_x_le(pdst, psrc, tweak, sec_size >> 4);
+
+	if (!se_aes_crypt_ecb(crypt_ks, enc, dst, sec_size, dst, sec_size))
+		return 0;
+
+	_gf256_xor_mul_x_le(pdst, pdst, orig_tweak, sec_size >> 4);
+
+	return 1;
+}
+
+static void _se_aes_xts_xor_nx(u32 *pdst, u32 *psrc, u32 *tweaks, u32 sec_off, u32 size, u32 sec_size)
+{
+	u8  tweak[SE_KEY_128_SIZE] __attribute__((aligned(4)));
+	u32 blk_off = sec_off >> 4;
+	u32 blks_left = size >> 4;
+
+	while (blks_left)
 	{
-		for (u32 j = 0; j < 4; j++)
-			pdst[j] = psrc[j] ^ ptweak[j];
+		u32 blks = MIN(blks_left, (sec_size >> 4) - blk_off);
 
-		_gf256_mul_x_le(tweak);
-		psrc += 4;
-		pdst += 4;
+		// Fast-forward sector tweak to the first block.
+		memcpy(tweak, tweaks, SE_KEY_128_SIZE);
+		_gf256_mul_xn_le(tweak, blk_off);
+
+		_gf256_xor_mul_x_le(pdst, psrc, tweak, blks);
+
+		psrc += blks * 4;
+		pdst += blks * 4;
+		blks_left -= blks;
+		blk_off = 0;
+		tweaks += 4;
 	}
+}
 
-	if (!se_aes_crypt_ecb(crypt_ks, enc, dst, sec_size, dst, sec_size))
+int se_aes_xts_crypt_multi_nx(u32 tweak_ks, u32 crypt_ks, u32 enc, u64 sec, u32 sec_off, void *dst, void *src, u32 size, u32 sec_size)
+{
+	int res = 0;
+	u32 num_secs = (sec_off + size + sec_size - 1) / sec_size;
+	u32 *tweaks = (u32 *)malloc(num_secs * SE_AES_BLOCK_SIZE);
+	if (!tweaks)
 		return 0;
 
-	pdst = (u32 *)dst;
-	ptweak = (u32 *)orig_tweak;
-	for (u32 i = 0; i < (sec_size >> 4); i++)
+	// Generate all sector tweaks in one go.
+	for (u32 i = 0; i < num_secs; i++)
 	{
-		for (u32 j = 0; j < 4; j++)
-			pdst[j] = pdst[j] ^ ptweak[j];
+		u8 *tweak = (u8 *)&tweaks[i * 4];
+		u64 tweak_sec = sec + i;
 
-		_gf256_mul_x_le(orig_tweak);
-		pdst += 4;
+		memset(tweak, 0, SE_AES_BLOCK_SIZE);
+		for (int j = 0xF; j >= 0x8; j--)
+		{
+			tweak[j] = tweak_sec & 0xFF;
+			tweak_sec >>= 8;
+		}
 	}
+	if (!se_aes_crypt_ecb(tweak_ks, ENCRYPT, tweaks, num_secs * SE_AES_BLOCK_SIZE, tweaks, num_secs * SE_AES_BLOCK_SIZE))
+		goto out;
 
-	return 1;
+	// We are assuming a 16 sector aligned size and offset in this implementation.
+	_se_aes_xts_xor_nx((u32 *)dst, (u32 *)src, tweaks, sec_off, size, sec_size);
+
+	if (!se_aes_crypt_ecb(crypt_ks, enc, dst, size, dst, size))
+		goto out;
+
+	_se_aes_xts_xor_nx((u32 *)dst, (u32 *)dst, tweaks, sec_off, size, sec_size);
+
+	res = 1;
+
+out:
+	free(tweaks);
+	return res;
 }
 
 int se_aes_xts_crypt(u32 tweak_ks, u32 crypt_ks, u32 enc, u64 sec, void *dst, void *src, u32 secsize, u32 num_secs)
@@ -22,6 +22,7 @@
 #include <soc/fuse.h>
 #include <storage/mbr_gpt.h>
 #include <utils/list.h>
+#include <utils/trace.h>
 
 static u16 emmc_errors[3] = { 0 }; // Init and Read/Write errors.
 static u32 emmc_mode = EMMC_MMC_HS400;
@@ -109,12 +110,17 @@ bool emmc_initialize(bool power_cycle)
 	if (power_cycle)
 		emmc_end();
 
+	TRACE_BEGIN(TRACE_EMMC_INIT, 0);
+
 	int res = !emmc_init_retry(false);
 
 	while (true)
 	{
 		if (!res)
+		{
+			TRACE_END(TRACE_EMMC_INIT, 0);
 			return true;
+		}
 		else
 		{
 			emmc_errors[EMMC_ERROR_INIT_FAIL]++;
@@ -128,6 +134,8 @@ bool emmc_initialize(bool power_cycle)
 
 	emmc_end();
 
+	TRACE_END(TRACE_EMMC_INIT, 1);
+
 	return false;
 }
 
@@ -24,6 +24,7 @@
 #include <mem/heap.h>
 #include <sec/se.h>
 #include <storage/emmc.h>
+#include <storage/nx_emmc_bis.h>
 #include <storage/sd.h>
 #include <storage/sdmmc.h>
 #include <utils/types.h>
@@ -31,32 +32,116 @@
 #define BIS_CLUSTER_SECTORS   32
 #define BIS_CLUSTER_SIZE      16384
 #define BIS_CACHE_MAX_ENTRIES 16384
-#define BIS_CACHE_LOOKUP_TBL_EMPTY_ENTRY -1
+#define BIS_CACHE_HASH_SIZE   16384 // Must be power of 2.
+#define BIS_CACHE_INVALID_IDX 0xFFFF
+#define BIS_CACHE_READ_BATCH  16 // Max missing clusters fetched with one command.
 
 typedef struct _cluster_cache_t
 {
 	u32  cluster_idx;            // Index of the cluster in the partition.
+	u16  hash_next;              // Next entry in the same hash bucket.
+	u16  lru_prev;               // Previous (more recently used) entry.
+	u16  lru_next;               // Next (less recently used) entry.
+	u16  rsvd;
 	bool dirty;                  // Has been modified without write-back flag.
 	u8   data[BIS_CLUSTER_SIZE]; // The cached cluster itself. Aligned to 8 bytes for DMA engine.
 } cluster_cache_t;
 
+static_assert(sizeof(cluster_cache_t) == BIS_CLUSTER_SIZE + 16, "BIS cluster cache entry size is wrong!");
+
 typedef struct _bis_cache_t
 {
-	bool full;
 	bool enabled;
 	u32  dirty_cnt;
 	u32  top_idx;
-	u8   dma_buff[BIS_CLUSTER_SIZE]; // Aligned to 8 bytes for DMA engine.
+	u16  lru_head;               // Most recently used entry.
+	u16  lru_tail;               // Least recently used entry. Evicted first.
+	nx_emmc_bis_cache_stats_t stats;
+	u8   dma_buff[BIS_CLUSTER_SIZE] __attribute__((aligned(8))); // Aligned to 8 bytes for DMA engine.
 	cluster_cache_t clusters[];
 } bis_cache_t;
 
+static_assert(sizeof(bis_cache_t) + BIS_CACHE_MAX_ENTRIES * sizeof(cluster_cache_t) <= NX_BIS_CACHE_SZ, "BIS cache doesn't fit!");
+
 static u8  ks_crypt = 0;
 static u8  ks_tweak = 0;
 static u32 emu_offset = 0;
 static emmc_part_t *system_part = NULL;
-static u32 *cache_lookup_tbl = (u32 *)NX_BIS_LOOKUP_ADDR;
+static u16 *cache_hash_tbl = (u16 *)NX_BIS_LOOKUP_ADDR;
 static bis_cache_t *bis_cache = (bis_cache_t *)NX_BIS_CACHE_ADDR;
 
+static u32 _nx_emmc_bis_cache_lookup(u32 cluster)
+{
+	if (!bis_cache->enabled)
+		return BIS_CACHE_INVALID_IDX;
+
+	u32 idx = cache_hash_tbl[cluster & (BIS_CACHE_HASH_SIZE - 1)];
+	while (idx != BIS_CACHE_INVALID_IDX)
+	{
+		if (bis_cache->clusters[idx].cluster_idx == cluster)
+			return idx;
+
+		idx = bis_cache->clusters[idx].hash_next;
+	}
+
+	return BIS_CACHE_INVALID_IDX;
+}
+
+static void _nx_emmc_bis_cache_hash_remove(u32 idx)
+{
+	u16 *link = &cache_hash_tbl[bis_cache->clusters[idx].cluster_idx & (BIS_CACHE_HASH_SIZE - 1)];
+
+	while (*link != BIS_CACHE_INVALID_IDX)
+	{
+		if (*link == idx)
+		{
+			*link = bis_cache->clusters[idx].hash_next;
+			return;
+		}
+
+		link = &bis_cache->clusters[*link].hash_next;
+	}
+}
+
+static void _nx_emmc_bis_cache_lru_unlink(u32 idx)
+{
+	cluster_cache_t *entry = &bis_cache->clusters[idx];
+
+	if (entry->lru_prev != BIS_CACHE_INVALID_IDX)
+		bis_cache->clusters[entry->lru_prev].lru_next = entry->lru_next;
+	else
+		bis_cache->lru_head = entry->lru_next;
+
+	if (entry->lru_next != BIS_CACHE_INVALID_IDX)
+		bis_cache->clusters[entry->lru_next].lru_prev = entry->lru_prev;
+	else
+		bis_cache->lru_tail = entry->lru_prev;
+}
+
+static void _nx_emmc_bis_cache_lru_push(u32 idx)
+{
+	cluster_cache_t *entry = &bis_cache->clusters[idx];
+
+	entry->lru_prev = BIS_CACHE_INVALID_IDX;
+	entry->lru_next = bis_cache->lru_head;
+
+	if (bis_cache->lru_head != BIS_CACHE_INVALID_IDX)
+		bis_cache->clusters[bis_cache->lru_head].lru_prev = idx;
+	else
+		bis_cache->lru_tail = idx;
+
+	bis_cache->lru_head = idx;
+}
+
+static void _nx_emmc_bis_cache_touch(u32 idx)
+{
+	if (bis_cache->lru_head == idx)
+		return;
+
+	_nx_emmc_bis_cache_lru_unlink(idx);
+	_nx_emmc_bis_cache_lru_push(idx);
+}
+
 static int nx_emmc_bis_write_block(u32 sector, u32 count, void *buff, bool flush)
 {
 	if (!system_part)
@@ -67,14 +152,17 @@ static int nx_emmc_bis_write_block(u32 sector, u32 count, void *buff, bool flush
 	u32  cluster = sector / BIS_CLUSTER_SECTORS;
 	u32  aligned_sector = cluster * BIS_CLUSTER_SECTORS;
 	u32  sector_in_cluster = sector % BIS_CLUSTER_SECTORS;
-	u32  lookup_idx = cache_lookup_tbl[cluster];
-	bool is_cached = lookup_idx != (u32)BIS_CACHE_LOOKUP_TBL_EMPTY_ENTRY;
+	u32  lookup_idx = _nx_emmc_bis_cache_lookup(cluster);
+	bool is_cached = lookup_idx != BIS_CACHE_INVALID_IDX;
 
 	// Write to cached cluster.
 	if (is_cached)
 	{
 		if (buff)
+		{
 			memcpy(bis_cache->clusters[lookup_idx].data + sector_in_cluster * EMMC_BLOCKSIZE, buff, count * EMMC_BLOCKSIZE);
+			_nx_emmc_bis_cache_touch(lookup_idx);
+		}
 		else
 			buff = bis_cache->clusters[lookup_idx].data;
 		if (!bis_cache->clusters[lookup_idx].dirty)
@@ -107,6 +195,7 @@ static int nx_emmc_bis_write_block(u32 sector, u32 count, void *buff, bool flush
 	{
 		bis_cache->clusters[lookup_idx].dirty = false;
 		bis_cache->dirty_cnt--;
+		bis_cache->stats.writebacks++;
 	}
 
 	return 0; // Success.
@@ -114,13 +203,13 @@ static int nx_emmc_bis_write_block(u32 sector, u32 count, void *buff, bool flush
 
 static void _nx_emmc_bis_cluster_cache_init(bool enable_cache)
 {
-	u32 cache_lookup_tbl_size = (system_part->lba_end - system_part->lba_start + 1) / BIS_CLUSTER_SECTORS * sizeof(*cache_lookup_tbl);
-
 	// Clear cache header.
 	memset(bis_cache, 0, sizeof(bis_cache_t));
+	bis_cache->lru_head = BIS_CACHE_INVALID_IDX;
+	bis_cache->lru_tail = BIS_CACHE_INVALID_IDX;
 
-	// Clear cluster lookup table.
-	memset(cache_lookup_tbl, BIS_CACHE_LOOKUP_TBL_EMPTY_ENTRY, cache_lookup_tbl_size);
+	// Clear cluster hash table.
+	memset(cache_hash_tbl, 0xFF, BIS_CACHE_HASH_SIZE * sizeof(*cache_hash_tbl));
 
 	// Enable cache.
 	bis_cache->enabled = enable_cache;
@@ -131,117 +220,196 @@ static void _nx_emmc_bis_flush_cache()
 	if (!bis_cache->enabled || !bis_cache->dirty_cnt)
 		return;
 
+	// Write back dirty clusters. Entries stay cached as clean.
 	for (u32 i = 0; i < bis_cache->top_idx && bis_cache->dirty_cnt; i++)
 	{
-		if (bis_cache->clusters[i].dirty) {
+		if (bis_cache->clusters[i].dirty)
 			nx_emmc_bis_write_block(bis_cache->clusters[i].cluster_idx * BIS_CLUSTER_SECTORS, BIS_CLUSTER_SECTORS, NULL, true);
-			bis_cache->dirty_cnt--;
+	}
+}
+
+static u32 _nx_emmc_bis_cache_alloc(u32 cluster)
+{
+	u32 idx;
+
+	if (bis_cache->top_idx < BIS_CACHE_MAX_ENTRIES)
+		idx = bis_cache->top_idx++;
+	else
+	{
+		// Evict least recently used cluster and write it back if dirty.
+		idx = bis_cache->lru_tail;
+		if (bis_cache->clusters[idx].dirty)
+		{
+			if (nx_emmc_bis_write_block(bis_cache->clusters[idx].cluster_idx * BIS_CLUSTER_SECTORS, BIS_CLUSTER_SECTORS, NULL, true))
+				return BIS_CACHE_INVALID_IDX;
 		}
+
+		_nx_emmc_bis_cache_hash_remove(idx);
+		_nx_emmc_bis_cache_lru_unlink(idx);
+		bis_cache->stats.evictions++;
 	}
 
-	_nx_emmc_bis_cluster_cache_init(true);
+	// Set new cached cluster parameters.
+	cluster_cache_t *entry = &bis_cache->clusters[idx];
+	u32 bucket = cluster & (BIS_CACHE_HASH_SIZE - 1);
+	entry->cluster_idx = cluster;
+	entry->dirty = false;
+	entry->hash_next = cache_hash_tbl[bucket];
+	cache_hash_tbl[bucket] = idx;
+	_nx_emmc_bis_cache_lru_push(idx);
+
+	return idx;
 }
 
-static int nx_emmc_bis_read_block_normal(u32 sector, u32 count, void *buff)
+static void _nx_emmc_bis_cache_drop(u32 idx)
 {
-	static u32 prev_cluster = -1;
-	static u32 prev_sector = 0;
-	static u8  tweak[SE_KEY_128_SIZE] __attribute__((aligned(4)));
+	// Unhash entry and make it the first one to be reused.
+	_nx_emmc_bis_cache_hash_remove(idx);
+	_nx_emmc_bis_cache_lru_unlink(idx);
 
-	int  res;
-	bool regen_tweak = true;
-	u32  tweak_exp = 0;
-	u32  cluster = sector / BIS_CLUSTER_SECTORS;
-	u32  sector_in_cluster = sector % BIS_CLUSTER_SECTORS;
+	cluster_cache_t *entry = &bis_cache->clusters[idx];
+	entry->dirty = false;
+	entry->lru_next = BIS_CACHE_INVALID_IDX;
+	entry->lru_prev = bis_cache->lru_tail;
 
-	// If not reading from cache, do a regular read and decrypt.
+	if (bis_cache->lru_tail != BIS_CACHE_INVALID_IDX)
+		bis_cache->clusters[bis_cache->lru_tail].lru_next = idx;
+	else
+		bis_cache->lru_head = idx;
+
+	bis_cache->lru_tail = idx;
+}
+
+static int nx_emmc_bis_read_normal(u32 sector, u32 count, void *buff)
+{
+	int res;
+	u32 cluster = sector / BIS_CLUSTER_SECTORS;
+	u32 sector_in_cluster = sector % BIS_CLUSTER_SECTORS;
+
+	// If not reading from cache, read the whole range directly into the buffer.
 	if (!emu_offset)
-		res = emmc_part_read(system_part, sector, count, bis_cache->dma_buff);
+		res = emmc_part_read(system_part, sector, count, buff);
 	else
-		res = sdmmc_storage_read(&sd_storage, emu_offset + system_part->lba_start + sector, count, bis_cache->dma_buff);
+		res = sdmmc_storage_read(&sd_storage, emu_offset + system_part->lba_start + sector, count, buff);
 	if (!res)
 		return 1; // R/W error.
 
-	if (prev_cluster != cluster) // Sector in different cluster than last read.
+	// Decrypt all clusters in the range with one SE job.
+	if (!se_aes_xts_crypt_multi_nx(ks_tweak, ks_crypt, DECRYPT, cluster, sector_in_cluster * EMMC_BLOCKSIZE,
+								   buff, buff, count * EMMC_BLOCKSIZE, BIS_CLUSTER_SIZE))
+		return 1; // Decryption error.
+
+	return 0; // Success.
+}
+
+static int _nx_emmc_bis_read_sg(u32 sector, u32 count, sdmmc_dma_seg_t *segs, u32 num_segs)
+{
+	// The last LBA is inclusive.
+	if (system_part->lba_start + sector + count - 1 > system_part->lba_end)
+		return 0;
+
+	if (emu_offset)
+		return sdmmc_storage_read_sg(&sd_storage, emu_offset + system_part->lba_start + sector, count, segs, num_segs);
+
+#ifndef BDK_EMUMMC_ENABLE
+	return sdmmc_storage_read_sg(&emmc_storage, system_part->lba_start + sector, count, segs, num_segs);
+#else
+	// File based emuMMC can split the range, so read each segment on its own.
+	for (u32 i = 0; i < num_segs; i++)
 	{
-		prev_cluster = cluster;
-		tweak_exp = sector_in_cluster;
+		u32 seg_sectors = segs[i].size / EMMC_BLOCKSIZE;
+		if (!emmc_part_read(system_part, sector, seg_sectors, segs[i].buf))
+			return 0;
+
+		sector += seg_sectors;
 	}
-	else if (sector > prev_sector) // Sector in same cluster and past last sector.
+
+	return 1;
+#endif
+}
+
+static int _nx_emmc_bis_cache_fill(u32 cluster, u32 num, u32 *idx)
+{
+	u8 cache_tweak[SE_KEY_128_SIZE] __attribute__((aligned(4)));
+	sdmmc_dma_seg_t segs[BIS_CACHE_READ_BATCH];
+	u32 allocated;
+
+	// Get free entries or evict the least recently used ones.
+	for (allocated = 0; allocated < num; allocated++)
 	{
-		// Calculates the new tweak using the saved one, reducing expensive _gf256_mul_x_le calls.
-		tweak_exp = sector - prev_sector - 1;
-		regen_tweak = false;
+		idx[allocated] = _nx_emmc_bis_cache_alloc(cluster + allocated);
+		if (idx[allocated] == BIS_CACHE_INVALID_IDX)
+			goto error; // R/W error.
+
+		segs[allocated].buf  = bis_cache->clusters[idx[allocated]].data;
+		segs[allocated].size = BIS_CLUSTER_SIZE;
 	}
-	else // Sector in same cluster and before or same as last sector.
-		tweak_exp = sector_in_cluster;
 
-	// Maximum one cluster (1 XTS crypto block 16KB).
-	if (!se_aes_xts_crypt_sec_nx(ks_tweak, ks_crypt, DECRYPT, prev_cluster, tweak, regen_tweak, tweak_exp, buff, bis_cache->dma_buff, count * EMMC_BLOCKSIZE))
-		return 1; // R/W error.
+	// Read the whole clusters with one command, directly into the cache entries.
+	if (!_nx_emmc_bis_read_sg(cluster * BIS_CLUSTER_SECTORS, num * BIS_CLUSTER_SECTORS, segs, num))
+		goto error; // R/W error.
 
-	prev_sector = sector + count - 1;
+	// Decrypt clusters.
+	for (u32 i = 0; i < num; i++)
+	{
+		u8 *data = bis_cache->clusters[idx[i]].data;
+		if (!se_aes_xts_crypt_sec_nx(ks_tweak, ks_crypt, DECRYPT, cluster + i, cache_tweak, true, 0, data, data, BIS_CLUSTER_SIZE))
+			goto error; // Decryption error.
+	}
 
 	return 0; // Success.
+
+error:
+	for (u32 i = 0; i < allocated; i++)
+		_nx_emmc_bis_cache_drop(idx[i]);
+
+	return 1;
 }
 
-static int nx_emmc_bis_read_block_cached(u32 sector, u32 count, void *buff)
+static u32 nx_emmc_bis_read_block_cached(u32 sector, u32 count, void *buff)
 {
-	int res;
-	u8  cache_tweak[SE_KEY_128_SIZE] __attribute__((aligned(4)));
+	u8 *buf = (u8 *)buff;
+	u32 idx[BIS_CACHE_READ_BATCH];
 	u32 cluster = sector / BIS_CLUSTER_SECTORS;
-	u32 cluster_sector = cluster * BIS_CLUSTER_SECTORS;
 	u32 sector_in_cluster = sector % BIS_CLUSTER_SECTORS;
-	u32 lookup_idx = cache_lookup_tbl[cluster];
+	u32 lookup_idx = _nx_emmc_bis_cache_lookup(cluster);
 
 	// Read from cached cluster.
-	if (lookup_idx != (u32)BIS_CACHE_LOOKUP_TBL_EMPTY_ENTRY)
+	if (lookup_idx != BIS_CACHE_INVALID_IDX)
 	{
-		memcpy(buff, bis_cache->clusters[lookup_idx].data + sector_in_cluster * EMMC_BLOCKSIZE, count * EMMC_BLOCKSIZE);
+		u32 sct_cnt = MIN(count, BIS_CLUSTER_SECTORS - sector_in_cluster);
 
-		return 0; // Success.
-	}
-
-	// Flush cache if full.
-	if (bis_cache->top_idx >= BIS_CACHE_MAX_ENTRIES)
-		_nx_emmc_bis_flush_cache();
+		memcpy(buf, bis_cache->clusters[lookup_idx].data + sector_in_cluster * EMMC_BLOCKSIZE, sct_cnt * EMMC_BLOCKSIZE);
+		_nx_emmc_bis_cache_touch(lookup_idx);
+		bis_cache->stats.hits++;
 
-	// Set new cached cluster parameters.
-	bis_cache->clusters[bis_cache->top_idx].cluster_idx = cluster;
-	bis_cache->clusters[bis_cache->top_idx].dirty = false;
-	cache_lookup_tbl[cluster] = bis_cache->top_idx;
-
-	// Read the whole cluster the sector resides in.
-	if (!emu_offset)
-		res = emmc_part_read(system_part, cluster_sector, BIS_CLUSTER_SECTORS, bis_cache->dma_buff);
-	else
-		res = sdmmc_storage_read(&sd_storage, emu_offset + system_part->lba_start + cluster_sector, BIS_CLUSTER_SECTORS, bis_cache->dma_buff);
-	if (!res)
-		return 1; // R/W error.
+		return sct_cnt;
+	}
 
-	// Decrypt cluster.
-	if (!se_aes_xts_crypt_sec_nx(ks_tweak, ks_crypt, DECRYPT, cluster, cache_tweak, true, 0, bis_cache->dma_buff, bis_cache->dma_buff, BIS_CLUSTER_SIZE))
-		return 1; // Decryption error.
+	// Also fetch the next clusters of the request that are not cached.
+	u32 clusters = 1;
+	u32 clusters_max = MIN((sector_in_cluster + count + BIS_CLUSTER_SECTORS - 1) / BIS_CLUSTER_SECTORS, BIS_CACHE_READ_BATCH);
+	while (clusters < clusters_max && _nx_emmc_bis_cache_lookup(cluster + clusters) == BIS_CACHE_INVALID_IDX)
+		clusters++;
 
-	// Copy to cluster cache.
-	memcpy(bis_cache->clusters[bis_cache->top_idx].data, bis_cache->dma_buff, BIS_CLUSTER_SIZE);
-	memcpy(buff, bis_cache->dma_buff + sector_in_cluster * EMMC_BLOCKSIZE, count * EMMC_BLOCKSIZE);
+	bis_cache->stats.misses += clusters;
 
-	// Increment cache count.
-	bis_cache->top_idx++;
+	if (_nx_emmc_bis_cache_fill(cluster, clusters, idx))
+		return 0;
 
-	return 0; // Success.
-}
+	// Copy the requested sectors out.
+	u32 sct_done = 0;
+	for (u32 i = 0; i < clusters; i++)
+	{
+		u32 sct_cnt = MIN(count - sct_done, BIS_CLUSTER_SECTORS - sector_in_cluster);
 
-static int nx_emmc_bis_read_block(u32 sector, u32 count, void *buff)
-{
-	if (!system_part)
-		return 3; // Not ready.
+		memcpy(buf + sct_done * EMMC_BLOCKSIZE, bis_cache->clusters[idx[i]].data + sector_in_cluster * EMMC_BLOCKSIZE,
+			sct_cnt * EMMC_BLOCKSIZE);
+		sct_done += sct_cnt;
+		sector_in_cluster = 0;
+	}
 
-	if (bis_cache->enabled)
-		return nx_emmc_bis_read_block_cached(sector, count, buff);
-	else
-		return nx_emmc_bis_read_block_normal(sector, count, buff);
+	return sct_done;
 }
 
 int nx_emmc_bis_read(u32 sector, u32 count, void *buff)
@@ -249,15 +417,18 @@ int nx_emmc_bis_read(u32 sector, u32 count, void *buff)
 	u8 *buf = (u8 *)buff;
 	u32 curr_sct = sector;
 
-	while (count)
-	{
-		// Get sector index in cluster and use it as boundary check.
-		u32 cnt_max = (curr_sct % BIS_CLUSTER_SECTORS);
-		cnt_max = BIS_CLUSTER_SECTORS - cnt_max;
+	if (!system_part)
+		return 0; // Not ready.
 
-		u32 sct_cnt = MIN(count, cnt_max); // Only allow cluster sized access.
+	// Uncached reads are not split into clusters.
+	if (!bis_cache->enabled)
+		return !nx_emmc_bis_read_normal(sector, count, buff);
 
-		if (nx_emmc_bis_read_block(curr_sct, sct_cnt, buf))
+	while (count)
+	{
+		// Reads one cached cluster or a run of missing ones.
+		u32 sct_cnt = nx_emmc_bis_read_block_cached(curr_sct, count, buf);
+		if (!sct_cnt)
 			return 0;
 
 		count    -= sct_cnt;
@@ -318,6 +489,13 @@ void nx_emmc_bis_init(emmc_part_t *part, bool enable_cache, u32 emummc_offset)
 		system_part = NULL;
 }
 
+void nx_emmc_bis_cache_stats(nx_emmc_bis_cache_stats_t *stats)
+{
+	memcpy(stats, &bis_cache->stats, sizeof(nx_emmc_bis_cache_stats_t));
+	stats->cached = bis_cache->top_idx;
+	stats->dirty  = bis_cache->dirty_cnt;
+}
+
 void nx_emmc_bis_end()
 {
 	_nx_emmc_bis_flush_cache();
@@ -21,6 +21,7 @@
 #include <gfx_utils.h>
 #include <libs/fatfs/ff.h>
 #include <mem/heap.h>
+#include <utils/trace.h>
 
 #ifndef BDK_SDMMC_UHS_DDR200_SUPPORT
 #define SD_DEFAULT_SPEED SD_UHS_SDR104
@@ -185,7 +186,11 @@ bool sd_mount()
 	int res = 0;
 
 	if (!sd_init_done)
+	{
+		TRACE_BEGIN(TRACE_SD_INIT, 0);
 		res = !sd_initialize(false);
+		TRACE_END(TRACE_SD_INIT, res);
+	}
 
 	if (res)
 	{
@@ -199,7 +204,11 @@ bool sd_mount()
 	else
 	{
 		if (!sd_mounted)
+		{
+			TRACE_BEGIN(TRACE_SD_MOUNT, 0);
 			res = f_mount(&sd_fs, "0:", 1); // Volume 0 is SD.
+			TRACE_END(TRACE_SD_MOUNT, res);
+		}
 		if (res == FR_OK)
 		{
 			sd_mounted = true;
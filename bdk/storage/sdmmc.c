@@ -188,6 +188,8 @@ int sdmmc_storage_vendor_sandisk_report(sdmmc_storage_t *storage, void *buf)
 	reqbuf.is_write         = 0;
 	reqbuf.is_multi_block   = 0;
 	reqbuf.is_auto_stop_trn = 0;
+	reqbuf.segs             = NULL;
+	reqbuf.num_segs         = 0;
 
 	u32 blkcnt_out;
 	if (!sdmmc_execute_cmd(storage->sdmmc, &cmdbuf, &reqbuf, &blkcnt_out))
@@ -201,9 +203,17 @@ int sdmmc_storage_vendor_sandisk_report(sdmmc_storage_t *storage, void *buf)
 	return 1;
 }
 
-static int _sdmmc_storage_readwrite_ex(sdmmc_storage_t *storage, u32 *blkcnt_out, u32 sector, u32 num_sectors, void *buf, u32 is_write)
+static void _sdmmc_storage_readwrite_abort(sdmmc_storage_t *storage)
 {
 	u32 tmp = 0;
+
+	sdmmc_stop_transmission(storage->sdmmc, &tmp);
+	_sdmmc_storage_get_status(storage, &tmp, 0);
+}
+
+static int _sdmmc_storage_readwrite_ex(sdmmc_storage_t *storage, u32 *blkcnt_out, u32 sector, u32 num_sectors, void *buf,
+	sdmmc_dma_seg_t *segs, u32 num_segs, u32 is_write, bool async)
+{
 	sdmmc_cmd_t cmdbuf;
 	sdmmc_req_t reqbuf;
 
@@ -219,11 +229,18 @@ static int _sdmmc_storage_readwrite_ex(sdmmc_storage_t *storage, u32 *blkcnt_out
 	reqbuf.is_write         = is_write;
 	reqbuf.is_multi_block   = 1;
 	reqbuf.is_auto_stop_trn = 1;
+	reqbuf.segs             = segs;
+	reqbuf.num_segs         = num_segs;
+
+	int res;
+	if (async)
+		res = sdmmc_execute_cmd_async(storage->sdmmc, &cmdbuf, &reqbuf, blkcnt_out);
+	else
+		res = sdmmc_execute_cmd(storage->sdmmc, &cmdbuf, &reqbuf, blkcnt_out);
 
-	if (!sdmmc_execute_cmd(storage->sdmmc, &cmdbuf, &reqbuf, blkcnt_out))
+	if (!res)
 	{
-		sdmmc_stop_transmission(storage->sdmmc, &tmp);
-		_sdmmc_storage_get_status(storage, &tmp, 0);
+		_sdmmc_storage_readwrite_abort(storage);
 
 		return 0;
 	}
@@ -264,7 +281,7 @@ static int _sdmmc_storage_readwrite(sdmmc_storage_t *storage, u32 sector, u32 nu
 		do
 		{
 reinit_try:
-			if (_sdmmc_storage_readwrite_ex(storage, &blkcnt, sct_off, MIN(sct_total, 0xFFFF), bbuf, is_write))
+			if (_sdmmc_storage_readwrite_ex(storage, &blkcnt, sct_off, MIN(sct_total, 0xFFFF), bbuf, NULL, 0, is_write, false))
 				goto out;
 			else
 				retries--;
@@ -334,36 +351,186 @@ out:
 	return 1;
 }
 
-int sdmmc_storage_read(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
+static int _sdmmc_storage_async_issue(sdmmc_storage_async_t *req)
+{
+	u32 sct_left = req->num_sectors - req->sct_off;
+
+	req->blkcnt = 0;
+
+	return _sdmmc_storage_readwrite_ex(req->storage, &req->blkcnt, req->sector + req->sct_off,
+		MIN(sct_left, 0xFFFF), req->buf + SDMMC_DAT_BLOCKSIZE * req->sct_off, NULL, 0, req->is_write, true);
+}
+
+static sdmmc_storage_async_t *_sdmmc_storage_async_start(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf, u32 is_write)
 {
+	sdmmc_storage_async_t *req = &storage->async;
+
+	// Only one transfer can be in flight per controller. Finish previous one first, including error recovery.
+	if (req->status != SDMMC_XFER_DONE)
+		sdmmc_storage_async_wait(req);
+
+	// Exit if not initialized.
+	if (!storage->initialized)
+		return NULL;
+
+	req->storage     = storage;
+	req->buf         = (u8 *)buf;
+	req->sector      = sector;
+	req->num_sectors = num_sectors;
+	req->sct_off     = 0;
+	req->blkcnt      = 0;
+	req->is_write    = is_write;
+	req->recovered   = 0;
+
 	// Ensure that SDMMC has access to buffer and it's SDMMC DMA aligned.
 	if (mc_client_has_access(buf) && !((u32)buf % 8))
-		return _sdmmc_storage_readwrite(storage, sector, num_sectors, buf, 0);
+	{
+		req->status = SDMMC_XFER_BUSY;
+
+		if (!num_sectors)
+			req->status = SDMMC_XFER_DONE;
+		else if (!_sdmmc_storage_async_issue(req))
+			req->status = SDMMC_XFER_ERROR;
 
+		return req;
+	}
+
+	// Bounce buffer is shared between controllers, so do a blocking transfer.
 	if (num_sectors > (SDMMC_UP_BUF_SZ / SDMMC_DAT_BLOCKSIZE))
-		return 0;
+		return NULL;
 
 	u8 *tmp_buf = (u8 *)SDMMC_UPPER_BUFFER;
-	if (_sdmmc_storage_readwrite(storage, sector, num_sectors, tmp_buf, 0))
-	{
+	if (is_write)
+		memcpy(tmp_buf, buf, SDMMC_DAT_BLOCKSIZE * num_sectors);
+
+	int res = _sdmmc_storage_readwrite(storage, sector, num_sectors, tmp_buf, is_write);
+	if (res && !is_write)
 		memcpy(buf, tmp_buf, SDMMC_DAT_BLOCKSIZE * num_sectors);
-		return 1;
+
+	// Storage might have been reinitialized, so set request status after.
+	req->status = res ? SDMMC_XFER_DONE : SDMMC_XFER_ERROR;
+	req->recovered = 1;
+
+	return req;
+}
+
+sdmmc_storage_async_t *sdmmc_storage_read_async(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
+{
+	return _sdmmc_storage_async_start(storage, sector, num_sectors, buf, 0);
+}
+
+sdmmc_storage_async_t *sdmmc_storage_write_async(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
+{
+	return _sdmmc_storage_async_start(storage, sector, num_sectors, buf, 1);
+}
+
+int sdmmc_storage_async_poll(sdmmc_storage_async_t *req)
+{
+	if (req->status != SDMMC_XFER_BUSY)
+		return req->status;
+
+	int res = sdmmc_execute_cmd_poll(req->storage->sdmmc);
+	if (res == SDMMC_XFER_BUSY)
+		return SDMMC_XFER_BUSY;
+
+	if (res == SDMMC_XFER_DONE)
+	{
+		req->sct_off += req->blkcnt;
+
+		// Issue next command if request is bigger than max blocks per command.
+		if (req->sct_off < req->num_sectors)
+		{
+			if (!_sdmmc_storage_async_issue(req))
+				req->status = SDMMC_XFER_ERROR;
+		}
+		else
+			req->status = SDMMC_XFER_DONE;
 	}
-	return 0;
+	else
+	{
+		_sdmmc_storage_readwrite_abort(req->storage);
+		req->status = SDMMC_XFER_ERROR;
+	}
+
+	return req->status;
+}
+
+int sdmmc_storage_async_wait(sdmmc_storage_async_t *req)
+{
+	while (sdmmc_storage_async_poll(req) == SDMMC_XFER_BUSY)
+		;
+
+	// Background transfer failed. Do remaining sectors with full error recovery.
+	if (req->status == SDMMC_XFER_ERROR && !req->recovered)
+	{
+		sd_error_count_increment(SD_ERROR_RW_RETRY);
+		msleep(50);
+
+		int res = _sdmmc_storage_readwrite(req->storage, req->sector + req->sct_off, req->num_sectors - req->sct_off,
+			req->buf + SDMMC_DAT_BLOCKSIZE * req->sct_off, req->is_write);
+
+		// Storage might have been reinitialized, so set request status after.
+		req->status = res ? SDMMC_XFER_DONE : SDMMC_XFER_ERROR;
+		req->recovered = 1;
+	}
+
+	return req->status == SDMMC_XFER_DONE;
+}
+
+int sdmmc_storage_read(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
+{
+	sdmmc_storage_async_t *req = sdmmc_storage_read_async(storage, sector, num_sectors, buf);
+	if (!req)
+		return 0;
+
+	return sdmmc_storage_async_wait(req);
 }
 
 int sdmmc_storage_write(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
 {
-	// Ensure that SDMMC has access to buffer and it's SDMMC DMA aligned.
-	if (mc_client_has_access(buf) && !((u32)buf % 8))
-		return _sdmmc_storage_readwrite(storage, sector, num_sectors, buf, 1);
+	sdmmc_storage_async_t *req = sdmmc_storage_write_async(storage, sector, num_sectors, buf);
+	if (!req)
+		return 0;
 
-	if (num_sectors > (SDMMC_UP_BUF_SZ / SDMMC_DAT_BLOCKSIZE))
+	return sdmmc_storage_async_wait(req);
+}
+
+int sdmmc_storage_read_sg(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, sdmmc_dma_seg_t *segs, u32 num_segs)
+{
+	// Finish any transfer in flight, including error recovery.
+	if (storage->async.status != SDMMC_XFER_DONE)
+		sdmmc_storage_async_wait(&storage->async);
+
+	// Exit if not initialized.
+	if (!storage->initialized)
 		return 0;
 
-	u8 *tmp_buf = (u8 *)SDMMC_UPPER_BUFFER;
-	memcpy(tmp_buf, buf, SDMMC_DAT_BLOCKSIZE * num_sectors);
-	return _sdmmc_storage_readwrite(storage, sector, num_sectors, tmp_buf, 1);
+	// Scatter-gather needs ADMA2, a single command and SDMMC DMA accessible segments.
+	bool sg_supported = storage->sdmmc->adma2 && num_sectors <= 0xFFFF;
+	for (u32 i = 0; i < num_segs && sg_supported; i++)
+		sg_supported = mc_client_has_access(segs[i].buf);
+
+	if (sg_supported)
+	{
+		u32 blkcnt = 0;
+		if (_sdmmc_storage_readwrite_ex(storage, &blkcnt, sector, num_sectors, NULL, segs, num_segs, 0, false))
+			return 1;
+
+		sd_error_count_increment(SD_ERROR_RW_RETRY);
+	}
+
+	// Fallback to reading each segment with full error recovery.
+	for (u32 i = 0; i < num_segs && num_sectors; i++)
+	{
+		u32 seg_sectors = MIN(segs[i].size / SDMMC_DAT_BLOCKSIZE, num_sectors);
+		if (!sdmmc_storage_read(storage, sector, seg_sectors, segs[i].buf))
+			return 0;
+
+		sector += seg_sectors;
+		num_sectors -= seg_sectors;
+	}
+
+	return !num_sectors;
 }
 
 /*
@@ -526,6 +693,8 @@ int mmc_storage_get_ext_csd(sdmmc_storage_t *storage, void *buf)
 	reqbuf.is_write = 0;
 	reqbuf.is_multi_block = 0;
 	reqbuf.is_auto_stop_trn = 0;
+	reqbuf.segs = NULL;
+	reqbuf.num_segs = 0;
 
 	if (!sdmmc_execute_cmd(storage->sdmmc, &cmdbuf, &reqbuf, NULL))
 		return 0;
@@ -1065,6 +1234,8 @@ int sd_storage_get_scr(sdmmc_storage_t *storage, u8 *buf)
 	reqbuf.is_write         = 0;
 	reqbuf.is_multi_block   = 0;
 	reqbuf.is_auto_stop_trn = 0;
+	reqbuf.segs             = NULL;
+	reqbuf.num_segs         = 0;
 
 	if (!_sd_storage_execute_app_cmd(storage, R1_STATE_TRAN, 0, &cmdbuf, &reqbuf, NULL))
 		return 0;
@@ -1096,6 +1267,8 @@ static int _sd_storage_switch_get(sdmmc_storage_t *storage, void *buf)
 	reqbuf.is_write         = 0;
 	reqbuf.is_multi_block   = 0;
 	reqbuf.is_auto_stop_trn = 0;
+	reqbuf.segs             = NULL;
+	reqbuf.num_segs         = 0;
 
 	if (!sdmmc_execute_cmd(storage->sdmmc, &cmdbuf, &reqbuf, NULL))
 		return 0;
@@ -1120,6 +1293,8 @@ static int _sd_storage_switch(sdmmc_storage_t *storage, void *buf, int mode, int
 	reqbuf.is_write         = 0;
 	reqbuf.is_multi_block   = 0;
 	reqbuf.is_auto_stop_trn = 0;
+	reqbuf.segs             = NULL;
+	reqbuf.num_segs         = 0;
 
 	if (!sdmmc_execute_cmd(storage->sdmmc, &cmdbuf, &reqbuf, NULL))
 		return 0;
@@ -1533,6 +1708,8 @@ int sd_storage_get_ssr(sdmmc_storage_t *storage, u8 *buf)
 	reqbuf.is_write         = 0;
 	reqbuf.is_multi_block   = 0;
 	reqbuf.is_auto_stop_trn = 0;
+	reqbuf.segs             = NULL;
+	reqbuf.num_segs         = 0;
 
 	if (!(storage->csd.cmdclass & CCC_APP_SPEC))
 	{
@@ -1782,6 +1959,8 @@ int _gc_storage_custom_cmd(sdmmc_storage_t *storage, void *buf)
 	reqbuf.is_write         = 1;
 	reqbuf.is_multi_block   = 0;
 	reqbuf.is_auto_stop_trn = 0;
+	reqbuf.segs             = NULL;
+	reqbuf.num_segs         = 0;
 
 	if (!sdmmc_execute_cmd(storage->sdmmc, &cmdbuf, &reqbuf, NULL))
 	{
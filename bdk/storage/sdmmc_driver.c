@@ -17,6 +17,7 @@
 
 #include <string.h>
 
+#include <memory_map.h>
 #include <storage/mmc.h>
 #include <storage/sdmmc.h>
 #include <gfx_utils.h>
@@ -858,6 +859,9 @@ static int _sdmmc_enable_internal_clock(sdmmc_t *sdmmc)
 
 	sdmmc->regs->hostctl2  |= SDHCI_ADDRESSING_64BIT_EN;
 	sdmmc->regs->hostctl   &= ~SDHCI_CTRL_DMA_MASK; // Use SDMA. Host V4 enabled so adma address regs in use.
+
+	// Use ADMA2 with 128-bit descriptors (Host V4 with 64bit addressing) if supported.
+	sdmmc->adma2 = !!(sdmmc->regs->capareg & SDHCI_CAP_ADMA2);
 	sdmmc->regs->timeoutcon = (sdmmc->regs->timeoutcon & 0xF0) | 14; // TMCLK * 2^27.
 
 	return 1;
@@ -912,14 +916,14 @@ static int _sdmmc_autocal_config_offset(sdmmc_t *sdmmc, u32 power)
 static void _sdmmc_enable_interrupts(sdmmc_t *sdmmc)
 {
 	sdmmc->regs->norintstsen |= SDHCI_INT_DMA_END | SDHCI_INT_DATA_END | SDHCI_INT_RESPONSE;
-	sdmmc->regs->errintstsen |= SDHCI_ERR_INT_ALL_EXCEPT_ADMA_BUSPWR;
+	sdmmc->regs->errintstsen |= SDHCI_ERR_INT_ALL_EXCEPT_ADMA_BUSPWR | SDHCI_ERR_INT_ADMA;
 	sdmmc->regs->norintsts = sdmmc->regs->norintsts;
 	sdmmc->regs->errintsts = sdmmc->regs->errintsts;
 }
 
 static void _sdmmc_mask_interrupts(sdmmc_t *sdmmc)
 {
-	sdmmc->regs->errintstsen &= ~SDHCI_ERR_INT_ALL_EXCEPT_ADMA_BUSPWR;
+	sdmmc->regs->errintstsen &= ~(SDHCI_ERR_INT_ALL_EXCEPT_ADMA_BUSPWR | SDHCI_ERR_INT_ADMA);
 	sdmmc->regs->norintstsen &= ~(SDHCI_INT_DMA_END | SDHCI_INT_DATA_END | SDHCI_INT_RESPONSE);
 }
 
@@ -1025,27 +1029,109 @@ int sdmmc_stop_transmission(sdmmc_t *sdmmc, u32 *rsp)
 	return result;
 }
 
-static int _sdmmc_config_sdma(sdmmc_t *sdmmc, u32 *blkcnt_out, const sdmmc_req_t *req)
+static int _sdmmc_config_sdma(sdmmc_t *sdmmc, const sdmmc_req_t *req)
 {
-	if (!req->blksize || !req->num_sectors)
+	// SDMA can only do a single buffer.
+	if (req->num_segs > 1)
 		return 0;
 
-	u32 blkcnt = req->num_sectors;
-	if (blkcnt >= 0xFFFF)
-		blkcnt = 0xFFFF;
-	u32 admaaddr = (u32)req->buf;
+	u32 admaaddr = req->num_segs ? (u32)req->segs[0].buf : (u32)req->buf;
 
 	// Check alignment.
 	if (admaaddr & 7)
 		return 0;
 
+	sdmmc->regs->hostctl = (sdmmc->regs->hostctl & ~SDHCI_CTRL_DMA_MASK) | SDHCI_CTRL_SDMA;
+
 	sdmmc->regs->admaaddr = admaaddr;
 	sdmmc->regs->admaaddr_hi = 0;
 
 	sdmmc->dma_addr_next = ALIGN_DOWN((admaaddr + SZ_512K), SZ_512K);
 
 	sdmmc->regs->blksize = req->blksize | (7u << 12); // SDMA DMA 512KB Boundary (Detects A18 carry out).
-	sdmmc->regs->blkcnt  = blkcnt;
+
+	return 1;
+}
+
+static int _sdmmc_config_adma2(sdmmc_t *sdmmc, u32 blkcnt, const sdmmc_req_t *req)
+{
+	sdmmc_adma2_desc_t *desc = (sdmmc_adma2_desc_t *)(SDMMC_ADMA_ADDR + SDMMC_ADMA_SZ * sdmmc->id);
+	const u32 max_desc = SDMMC_ADMA_SZ / sizeof(sdmmc_adma2_desc_t);
+
+	// Use a single segment if no scatter-gather list was provided.
+	const sdmmc_dma_seg_t single_seg = { req->buf, blkcnt * req->blksize };
+	const sdmmc_dma_seg_t *segs = req->num_segs ? req->segs : &single_seg;
+	u32 num_segs = req->num_segs ? req->num_segs : 1;
+
+	u32 size = blkcnt * req->blksize;
+	u32 idx = 0;
+	for (u32 i = 0; i < num_segs && size; i++)
+	{
+		u32 addr = (u32)segs[i].buf;
+		u32 seg_size = MIN(segs[i].size, size);
+
+		// Check alignment.
+		if ((addr & 7) || (seg_size & 7))
+			return 0;
+
+		size -= seg_size;
+
+		// Split segment to max descriptor transfer size.
+		while (seg_size)
+		{
+			if (idx >= max_desc)
+				return 0;
+
+			u32 len = MIN(seg_size, SDMMC_ADMA2_MAX_LEN);
+
+			desc[idx].attr    = SDMMC_ADMA2_ACT_TRAN | SDMMC_ADMA2_VALID;
+			desc[idx].len     = len;
+			desc[idx].addr    = addr;
+			desc[idx].addr_hi = 0;
+			desc[idx].rsvd    = 0;
+
+			addr += len;
+			seg_size -= len;
+			idx++;
+		}
+	}
+
+	// Check that segments cover the whole transfer.
+	if (size || !idx)
+		return 0;
+
+	desc[idx - 1].attr |= SDMMC_ADMA2_END;
+
+	sdmmc->regs->hostctl = (sdmmc->regs->hostctl & ~SDHCI_CTRL_DMA_MASK) | SDHCI_CTRL_ADMA32;
+
+	sdmmc->regs->admaaddr = (u32)desc;
+	sdmmc->regs->admaaddr_hi = 0;
+
+	sdmmc->regs->blksize = req->blksize;
+
+	return 1;
+}
+
+static int _sdmmc_config_dma(sdmmc_t *sdmmc, u32 *blkcnt_out, const sdmmc_req_t *req)
+{
+	if (!req->blksize || !req->num_sectors)
+		return 0;
+
+	u32 blkcnt = req->num_sectors;
+	if (blkcnt >= 0xFFFF)
+		blkcnt = 0xFFFF;
+
+	// ADMA2 does the whole transfer without reprogramming. SDMA needs an update every 512KB.
+	int res;
+	if (sdmmc->adma2)
+		res = _sdmmc_config_adma2(sdmmc, blkcnt, req);
+	else
+		res = _sdmmc_config_sdma(sdmmc, req);
+
+	if (!res)
+		return 0;
+
+	sdmmc->regs->blkcnt = blkcnt;
 
 	if (blkcnt_out)
 		*blkcnt_out = blkcnt;
@@ -1071,51 +1157,56 @@ static int _sdmmc_config_sdma(sdmmc_t *sdmmc, u32 *blkcnt_out, const sdmmc_req_t
 	return 1;
 }
 
-static int _sdmmc_update_sdma(sdmmc_t *sdmmc)
+static int _sdmmc_update_dma(sdmmc_t *sdmmc)
 {
-	u16 blkcnt = 0;
-	do
+	u32 result = SDMMC_MASKINT_MASKED;
+	while (true)
 	{
-		blkcnt = sdmmc->regs->blkcnt;
-		u32 timeout = get_tmr_ms() + 1500;
-		do
-		{
-			u32 result = SDMMC_MASKINT_MASKED;
-			while (true)
-			{
-				u16 intr = 0;
-				result = _sdmmc_check_mask_interrupt(sdmmc, &intr,
-					SDHCI_INT_DATA_END | SDHCI_INT_DMA_END);
-				if (result != SDMMC_MASKINT_MASKED)
-					break;
+		u16 intr = 0;
+		result = _sdmmc_check_mask_interrupt(sdmmc, &intr,
+			SDHCI_INT_DATA_END | SDHCI_INT_DMA_END);
+		if (result != SDMMC_MASKINT_MASKED)
+			break;
 
-				if (intr & SDHCI_INT_DATA_END)
-					return 1; // Transfer complete.
+		if (intr & SDHCI_INT_DATA_END)
+			return SDMMC_XFER_DONE; // Transfer complete.
 
-				if (intr & SDHCI_INT_DMA_END)
-				{
-					// Update DMA.
-					sdmmc->regs->admaaddr = sdmmc->dma_addr_next;
-					sdmmc->regs->admaaddr_hi = 0;
-					sdmmc->dma_addr_next += SZ_512K;
-				}
-			}
+		// Only SDMA stops at boundaries. ADMA2 descriptors do not request an interrupt.
+		if ((intr & SDHCI_INT_DMA_END) && !sdmmc->adma2)
+		{
+			// Update DMA.
+			sdmmc->regs->admaaddr = sdmmc->dma_addr_next;
+			sdmmc->regs->admaaddr_hi = 0;
+			sdmmc->dma_addr_next += SZ_512K;
+		}
+	}
 
-			if (result != SDMMC_MASKINT_NOERROR)
-			{
+	if (result != SDMMC_MASKINT_NOERROR)
+	{
 #ifdef ERROR_EXTRA_PRINTING
-				EPRINTFARGS("SDMMC%d: int error!", sdmmc->id + 1);
+		EPRINTFARGS("SDMMC%d: int error!", sdmmc->id + 1);
 #endif
-				_sdmmc_reset_cmd_data(sdmmc);
+		_sdmmc_reset_cmd_data(sdmmc);
 
-				return 0;
-			}
-		} while (get_tmr_ms() < timeout);
-	} while (sdmmc->regs->blkcnt != blkcnt);
+		return SDMMC_XFER_ERROR;
+	}
 
-	_sdmmc_reset_cmd_data(sdmmc);
+	// Transfer still in progress. Rearm timeout if blocks got transferred.
+	if (get_tmr_ms() > sdmmc->dma_timeout)
+	{
+		u16 blkcnt = sdmmc->regs->blkcnt;
+		if (blkcnt == sdmmc->dma_blkcnt)
+		{
+			_sdmmc_reset_cmd_data(sdmmc);
 
-	return 0;
+			return SDMMC_XFER_ERROR;
+		}
+
+		sdmmc->dma_blkcnt = blkcnt;
+		sdmmc->dma_timeout = get_tmr_ms() + 1500;
+	}
+
+	return SDMMC_XFER_BUSY;
 }
 
 static int _sdmmc_execute_cmd_inner(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out)
@@ -1128,7 +1219,7 @@ static int _sdmmc_execute_cmd_inner(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_
 	bool is_data_present = false;
 	if (req)
 	{
-		if (!_sdmmc_config_sdma(sdmmc, &blkcnt, req))
+		if (!_sdmmc_config_dma(sdmmc, &blkcnt, req))
 		{
 #ifdef ERROR_EXTRA_PRINTING
 			EPRINTFARGS("SDMMC%d: DMA Wrong cfg!", sdmmc->id + 1);
@@ -1172,38 +1263,62 @@ static int _sdmmc_execute_cmd_inner(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_
 		}
 		if (req && result)
 		{
-			result = _sdmmc_update_sdma(sdmmc);
-#ifdef ERROR_EXTRA_PRINTING
-			if (!result)
-				EPRINTFARGS("SDMMC%d: DMA Update failed!", sdmmc->id + 1);
-#endif
+			// Data transfer is now in flight. Completion is handled by _sdmmc_execute_cmd_complete.
+			sdmmc->xfer_active    = 1;
+			sdmmc->xfer_auto_stop = req->is_auto_stop_trn;
+			sdmmc->dma_blkcnt     = sdmmc->regs->blkcnt;
+			sdmmc->dma_timeout    = get_tmr_ms() + 1500;
+
+			if (blkcnt_out)
+				*blkcnt_out = blkcnt;
+
+			return 1;
 		}
 	}
 
 	_sdmmc_mask_interrupts(sdmmc);
 
-	if (result)
+	if (result && cmd->check_busy)
 	{
-		if (req)
-		{
-			// Invalidate cache after transfer.
-			bpmp_mmu_maintenance(BPMP_MMU_MAINT_INVALID_WAY, false);
+		result = _sdmmc_wait_card_busy(sdmmc);
+#ifdef ERROR_EXTRA_PRINTING
+		if (!result)
+			EPRINTFARGS("SDMMC%d: Busy timeout!", sdmmc->id + 1);
+#endif
+	}
 
-			if (blkcnt_out)
-				*blkcnt_out = blkcnt;
+	return result;
+}
 
-			if (req->is_auto_stop_trn)
-				sdmmc->rsp3 = sdmmc->regs->rspreg3;
-		}
+static int _sdmmc_execute_cmd_complete(sdmmc_t *sdmmc)
+{
+	int result = _sdmmc_update_dma(sdmmc);
+	if (result == SDMMC_XFER_BUSY)
+		return SDMMC_XFER_BUSY;
+
+#ifdef ERROR_EXTRA_PRINTING
+	if (result != SDMMC_XFER_DONE)
+		EPRINTFARGS("SDMMC%d: DMA Update failed!", sdmmc->id + 1);
+#endif
+
+	sdmmc->xfer_active = 0;
+
+	_sdmmc_mask_interrupts(sdmmc);
+
+	if (result == SDMMC_XFER_DONE)
+	{
+		// Invalidate cache after transfer.
+		bpmp_mmu_maintenance(BPMP_MMU_MAINT_INVALID_WAY, false);
+
+		if (sdmmc->xfer_auto_stop)
+			sdmmc->rsp3 = sdmmc->regs->rspreg3;
 
-		if (cmd->check_busy || req)
+		if (!_sdmmc_wait_card_busy(sdmmc))
 		{
-			result = _sdmmc_wait_card_busy(sdmmc);
 #ifdef ERROR_EXTRA_PRINTING
-			if (!result)
-				EPRINTFARGS("SDMMC%d: Busy timeout!", sdmmc->id + 1);
+			EPRINTFARGS("SDMMC%d: Busy timeout!", sdmmc->id + 1);
 #endif
-			return result;
+			result = SDMMC_XFER_ERROR;
 		}
 	}
 
@@ -1501,29 +1616,67 @@ void sdmmc_init_cmd(sdmmc_cmd_t *cmdbuf, u16 cmd, u32 arg, u32 rsp_type, u32 che
 	cmdbuf->check_busy = check_busy;
 }
 
-int sdmmc_execute_cmd(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out)
+static void _sdmmc_execute_cmd_end(sdmmc_t *sdmmc)
 {
-	if (!sdmmc->card_clock_enabled)
+	usleep((8 * 1000 + sdmmc->card_clock - 1) / sdmmc->card_clock); // Wait 8 cycles.
+
+	if (sdmmc->xfer_disable_sd_clock)
+		sdmmc->regs->clkcon &= ~SDHCI_CLOCK_CARD_EN;
+}
+
+int sdmmc_execute_cmd_async(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out)
+{
+	if (!sdmmc->card_clock_enabled || sdmmc->xfer_active)
 		return 0;
 
 	// Recalibrate periodically for SDMMC1.
 	if (sdmmc->manual_cal && sdmmc->powersave_enabled)
 		_sdmmc_autocal_execute(sdmmc, sdmmc_get_io_power(sdmmc));
 
-	int should_disable_sd_clock = 0;
+	sdmmc->xfer_disable_sd_clock = 0;
 	if (!(sdmmc->regs->clkcon & SDHCI_CLOCK_CARD_EN))
 	{
-		should_disable_sd_clock = 1;
+		sdmmc->xfer_disable_sd_clock = 1;
 		sdmmc->regs->clkcon |= SDHCI_CLOCK_CARD_EN;
 		_sdmmc_commit_changes(sdmmc);
 		usleep((8 * 1000 + sdmmc->card_clock - 1) / sdmmc->card_clock); // Wait 8 cycles.
 	}
 
 	int result = _sdmmc_execute_cmd_inner(sdmmc, cmd, req, blkcnt_out);
-	usleep((8 * 1000 + sdmmc->card_clock - 1) / sdmmc->card_clock); // Wait 8 cycles.
 
-	if (should_disable_sd_clock)
-		sdmmc->regs->clkcon &= ~SDHCI_CLOCK_CARD_EN;
+	// Finish now if there's no data transfer in flight.
+	if (!sdmmc->xfer_active)
+		_sdmmc_execute_cmd_end(sdmmc);
+
+	return result;
+}
+
+int sdmmc_execute_cmd_poll(sdmmc_t *sdmmc)
+{
+	if (!sdmmc->xfer_active)
+		return SDMMC_XFER_ERROR;
+
+	int result = _sdmmc_execute_cmd_complete(sdmmc);
+	if (result != SDMMC_XFER_BUSY)
+		_sdmmc_execute_cmd_end(sdmmc);
+
+	return result;
+}
+
+int sdmmc_execute_cmd(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out)
+{
+	int result = sdmmc_execute_cmd_async(sdmmc, cmd, req, blkcnt_out);
+
+	// Wait for data transfer to complete.
+	if (result && sdmmc->xfer_active)
+	{
+		do
+		{
+			result = sdmmc_execute_cmd_poll(sdmmc);
+		} while (result == SDMMC_XFER_BUSY);
+
+		result = result == SDMMC_XFER_DONE;
+	}
 
 	return result;
 }
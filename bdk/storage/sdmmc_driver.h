@@ -50,6 +50,11 @@
 #define SDMMC_MASKINT_NOERROR  1
 #define SDMMC_MASKINT_ERROR    2
 
+/*! SDMMC async transfer status. */
+#define SDMMC_XFER_DONE  0
+#define SDMMC_XFER_BUSY  1
+#define SDMMC_XFER_ERROR 2
+
 /*! SDMMC present state. 0x24. */
 #define SDHCI_CMD_INHIBIT      BIT(0)
 #define SDHCI_DATA_INHIBIT     BIT(1)
@@ -238,6 +243,15 @@
 /*! SDMMC max current. 0x4C */
 #define SDHCI_MAX_CURRENT_1_8_V_VDD2_MASK (0xFFU << 0)
 
+/*! SDMMC ADMA2 descriptor attributes. */
+#define SDMMC_ADMA2_VALID    BIT(0)
+#define SDMMC_ADMA2_END      BIT(1)
+#define SDMMC_ADMA2_INT      BIT(2)
+#define SDMMC_ADMA2_ACT_NOP  (0U << 4)
+#define SDMMC_ADMA2_ACT_TRAN (2U << 4)
+#define SDMMC_ADMA2_ACT_LINK (3U << 4)
+#define SDMMC_ADMA2_MAX_LEN  SZ_32K
+
 /*! SD bus speeds. */
 #define UHS_SDR12_BUS_SPEED  0
 #define HIGH_SPEED_BUS_SPEED 1
@@ -291,6 +305,12 @@ typedef struct _sdmmc_t
 	u32 venclkctl_tap;
 	u32 expected_rsp_type;
 	u32 dma_addr_next;
+	u32 dma_blkcnt;
+	u32 dma_timeout;
+	int xfer_active;
+	int xfer_auto_stop;
+	int xfer_disable_sd_clock;
+	int adma2;
 	u32 rsp[4];
 	u32 rsp3;
 	int t210b01;
@@ -305,6 +325,23 @@ typedef struct _sdmmc_cmd_t
 	u32 check_busy;
 } sdmmc_cmd_t;
 
+/*! SDMMC ADMA2 descriptor. 128-bit, since Host V4 and 64bit addressing are enabled. */
+typedef struct _sdmmc_adma2_desc_t
+{
+	u16 attr;
+	u16 len;
+	u32 addr;
+	u32 addr_hi;
+	u32 rsvd;
+} sdmmc_adma2_desc_t;
+
+/*! SDMMC DMA scatter-gather segment. */
+typedef struct _sdmmc_dma_seg_t
+{
+	void *buf;
+	u32 size;
+} sdmmc_dma_seg_t;
+
 /*! SDMMC request. */
 typedef struct _sdmmc_req_t
 {
@@ -314,6 +351,8 @@ typedef struct _sdmmc_req_t
 	int is_write;
 	int is_multi_block;
 	int is_auto_stop_trn;
+	sdmmc_dma_seg_t *segs; // If num_segs is set, it's used instead of buf.
+	u32 num_segs;
 } sdmmc_req_t;
 
 int  sdmmc_get_io_power(sdmmc_t *sdmmc);
@@ -331,6 +370,8 @@ int  sdmmc_init(sdmmc_t *sdmmc, u32 id, u32 power, u32 bus_width, u32 type);
 void sdmmc_end(sdmmc_t *sdmmc);
 void sdmmc_init_cmd(sdmmc_cmd_t *cmdbuf, u16 cmd, u32 arg, u32 rsp_type, u32 check_busy);
 int  sdmmc_execute_cmd(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out);
+int  sdmmc_execute_cmd_async(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out);
+int  sdmmc_execute_cmd_poll(sdmmc_t *sdmmc);
 int  sdmmc_enable_low_voltage(sdmmc_t *sdmmc);
 
 #endif
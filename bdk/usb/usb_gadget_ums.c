@@ -58,7 +58,20 @@
 
 #define UMS_SCSI_TRANSFER_512K (0x80000 >> UMS_DISK_LBA_SHIFT)
 
-#define UMS_EP_OUT_MAX_XFER (USB_EP_BULK_OUT_MAX_XFER)
+#define UMS_EP_OUT_CHUNK (SZ_512K) // Small enough to overlap USB and SDMMC within a command.
+
+// Write-back cache for small writes. Uses the otherwise idle mixed SDMMC buffer.
+#define UMS_WCACHE_ADDR         MIXD_BUF_ALIGNED
+#define UMS_WCACHE_LINE_SECTORS 128 // 64KB.
+#define UMS_WCACHE_LINE_SIZE    (UMS_WCACHE_LINE_SECTORS << UMS_DISK_LBA_SHIFT)
+#define UMS_WCACHE_LINES        64  // 4MB.
+#define UMS_WCACHE_MAX_WRITE    UMS_WCACHE_LINE_SIZE
+
+// Read-ahead windows for sequential reads. Placed after the write-back cache.
+#define UMS_RA_ADDR           (UMS_WCACHE_ADDR + UMS_WCACHE_LINES * UMS_WCACHE_LINE_SIZE)
+#define UMS_RA_WINDOWS        2
+#define UMS_RA_WINDOW_SECTORS 0x2000 // 4MB.
+#define UMS_RA_MIN_SECTORS    0x400  // 512KB. Prefetch grows from that on each sequential read.
 
 // Length of a SCSI Command Data Block.
 #define SCSI_MAX_CMD_SZ 16
@@ -183,6 +196,37 @@ typedef struct _logical_unit_t
 	u32 unit_attention_data;
 } logical_unit_t;
 
+typedef struct _ums_wcache_line_t
+{
+	u32  lba; // Line aligned.
+	u32  age;
+	bool valid;
+	bool dirty;
+} ums_wcache_line_t;
+
+typedef struct _ums_wcache_t
+{
+	bool enabled;
+	u32  tick;
+	ums_wcache_line_t lines[UMS_WCACHE_LINES];
+} ums_wcache_t;
+
+typedef struct _ums_ra_window_t
+{
+	u32  lba;
+	u32  sectors;
+	bool valid;
+} ums_ra_window_t;
+
+typedef struct _ums_ra_t
+{
+	u32 next_lba; // Expected start of the next sequential read.
+	u32 req_idx;  // Window of the pending prefetch.
+	u32 pf_sectors; // Size of the next prefetch.
+	sdmmc_storage_async_t *req;
+	ums_ra_window_t win[UMS_RA_WINDOWS];
+} ums_ra_t;
+
 typedef struct _bulk_ctxt_t {
 	u32  bulk_in;
 	int  bulk_in_status;
@@ -208,6 +252,8 @@ typedef struct _usbd_gadget_ums_t {
 
 	u32  lun_idx; // lun index
 	logical_unit_t lun;
+	ums_wcache_t wcache;
+	ums_ra_t ra;
 
 	enum ums_state state; // For exception handling.
 
@@ -407,6 +453,273 @@ static void _reset_buffer(bulk_ctxt_t *bulk_ctxt, u32 ep)
 		bulk_ctxt->bulk_out_buf = (u8 *)USB_EP_BULK_OUT_BUF_ADDR;
 }
 
+static u8 *_wcache_line_buf(u32 idx)
+{
+	return (u8 *)UMS_WCACHE_ADDR + idx * UMS_WCACHE_LINE_SIZE;
+}
+
+static u32 _wcache_line_sectors(usbd_gadget_ums_t *ums, u32 line_lba)
+{
+	return MIN(UMS_WCACHE_LINE_SECTORS, ums->lun.num_sectors - line_lba);
+}
+
+static int _wcache_flush_line(usbd_gadget_ums_t *ums, u32 idx)
+{
+	ums_wcache_line_t *line = &ums->wcache.lines[idx];
+
+	if (!line->valid || !line->dirty)
+		return 1;
+
+	if (!sdmmc_storage_write(ums->lun.storage, ums->lun.offset + line->lba,
+		_wcache_line_sectors(ums, line->lba), _wcache_line_buf(idx)))
+		return 0;
+
+	line->dirty = false;
+
+	return 1;
+}
+
+static int _wcache_flush(usbd_gadget_ums_t *ums)
+{
+	int res = 1;
+
+	if (!ums->wcache.enabled)
+		return 1;
+
+	for (u32 i = 0; i < UMS_WCACHE_LINES; i++)
+		if (!_wcache_flush_line(ums, i))
+			res = 0;
+
+	return res;
+}
+
+static int _wcache_get_line(usbd_gadget_ums_t *ums, u32 line_lba, bool fill)
+{
+	ums_wcache_line_t *lines = ums->wcache.lines;
+	u32 victim = 0;
+
+	for (u32 i = 0; i < UMS_WCACHE_LINES; i++)
+	{
+		if (lines[i].valid && lines[i].lba == line_lba)
+			return i;
+
+		// Prefer free lines, then the least recently used one.
+		if (lines[victim].valid && (!lines[i].valid || lines[i].age < lines[victim].age))
+			victim = i;
+	}
+
+	// Evict line.
+	if (!_wcache_flush_line(ums, victim))
+		return -1;
+	lines[victim].valid = false;
+
+	// Fill line from storage, if it's not fully overwritten.
+	if (fill && !sdmmc_storage_read(ums->lun.storage, ums->lun.offset + line_lba,
+		_wcache_line_sectors(ums, line_lba), _wcache_line_buf(victim)))
+		return -1;
+
+	lines[victim].lba   = line_lba;
+	lines[victim].valid = true;
+	lines[victim].dirty = false;
+
+	return victim;
+}
+
+static int _wcache_write(usbd_gadget_ums_t *ums, u32 lba, u32 sectors, const u8 *buf)
+{
+	while (sectors)
+	{
+		u32 line_lba = lba & ~(UMS_WCACHE_LINE_SECTORS - 1);
+		u32 sct_off  = lba - line_lba;
+		u32 cnt      = MIN(sectors, UMS_WCACHE_LINE_SECTORS - sct_off);
+
+		int idx = _wcache_get_line(ums, line_lba, cnt < _wcache_line_sectors(ums, line_lba));
+		if (idx < 0)
+			return 0;
+
+		memcpy(_wcache_line_buf(idx) + (sct_off << UMS_DISK_LBA_SHIFT), buf, cnt << UMS_DISK_LBA_SHIFT);
+		ums->wcache.lines[idx].dirty = true;
+		ums->wcache.lines[idx].age   = ++ums->wcache.tick;
+
+		lba     += cnt;
+		sectors -= cnt;
+		buf     += cnt << UMS_DISK_LBA_SHIFT;
+	}
+
+	return 1;
+}
+
+static void _wcache_copy(usbd_gadget_ums_t *ums, u32 lba, u32 sectors, u8 *buf, bool to_cache)
+{
+	if (!ums->wcache.enabled)
+		return;
+
+	// Copy overlapping data from or to cached lines.
+	for (u32 i = 0; i < UMS_WCACHE_LINES; i++)
+	{
+		ums_wcache_line_t *line = &ums->wcache.lines[i];
+		if (!line->valid || (!to_cache && !line->dirty))
+			continue;
+
+		u32 start = MAX(lba, line->lba);
+		u32 end   = MIN(lba + sectors, line->lba + UMS_WCACHE_LINE_SECTORS);
+		if (start >= end)
+			continue;
+
+		u8 *line_data = _wcache_line_buf(i) + ((start - line->lba) << UMS_DISK_LBA_SHIFT);
+		u8 *data      = buf + ((start - lba) << UMS_DISK_LBA_SHIFT);
+		if (to_cache)
+			memcpy(line_data, data, (end - start) << UMS_DISK_LBA_SHIFT);
+		else
+			memcpy(data, line_data, (end - start) << UMS_DISK_LBA_SHIFT);
+	}
+}
+
+static u8 *_ra_window_buf(u32 idx)
+{
+	return (u8 *)UMS_RA_ADDR + idx * (UMS_RA_WINDOW_SECTORS << UMS_DISK_LBA_SHIFT);
+}
+
+static void _ra_wait(usbd_gadget_ums_t *ums)
+{
+	ums_ra_t *ra = &ums->ra;
+
+	if (!ra->req)
+		return;
+
+	ums_ra_window_t *win = &ra->win[ra->req_idx];
+	win->valid = sdmmc_storage_async_wait(ra->req);
+	ra->req = NULL;
+
+	// Get any newer data from the write cache.
+	if (win->valid)
+		_wcache_copy(ums, win->lba, win->sectors, _ra_window_buf(ums->ra.req_idx), false);
+}
+
+static void _ra_invalidate(usbd_gadget_ums_t *ums)
+{
+	_ra_wait(ums);
+
+	for (u32 i = 0; i < UMS_RA_WINDOWS; i++)
+		ums->ra.win[i].valid = false;
+}
+
+static void _ra_prefetch(usbd_gadget_ums_t *ums, u32 lba)
+{
+	ums_ra_t *ra = &ums->ra;
+	u32 pf_lba = lba;
+	int target = -1;
+
+	if (ra->req)
+		return;
+
+	// Prefetch after the window that has the next data, into one that is not in use.
+	for (u32 i = 0; i < UMS_RA_WINDOWS; i++)
+	{
+		ums_ra_window_t *win = &ra->win[i];
+		bool has_next = win->valid && lba >= win->lba && lba < win->lba + win->sectors;
+		bool has_prev = win->valid && lba && (lba - 1) >= win->lba && (lba - 1) < win->lba + win->sectors;
+
+		if (has_next)
+			pf_lba = win->lba + win->sectors;
+		else if (!has_prev)
+			target = i;
+	}
+
+	if (target < 0 || pf_lba >= ums->lun.num_sectors)
+		return;
+
+	// Check if already prefetched.
+	for (u32 i = 0; i < UMS_RA_WINDOWS; i++)
+		if (ra->win[i].valid && ra->win[i].lba == pf_lba)
+			return;
+
+	ums_ra_window_t *win = &ra->win[target];
+	win->lba     = pf_lba;
+	win->sectors = MIN(ra->pf_sectors, ums->lun.num_sectors - pf_lba);
+	win->valid   = false;
+
+	// Grow prefetch while the stream stays sequential.
+	ra->pf_sectors = MIN(ra->pf_sectors * 2, UMS_RA_WINDOW_SECTORS);
+
+	ra->req_idx = target;
+	ra->req = sdmmc_storage_read_async(ums->lun.storage, ums->lun.offset + win->lba, win->sectors, _ra_window_buf(target));
+}
+
+static ums_ra_window_t *_ra_find(usbd_gadget_ums_t *ums, u32 lba, u32 *idx)
+{
+	ums_ra_t *ra = &ums->ra;
+
+	for (u32 i = 0; i < UMS_RA_WINDOWS; i++)
+	{
+		ums_ra_window_t *win = &ra->win[i];
+		if (lba < win->lba || lba >= (win->lba + win->sectors))
+			continue;
+
+		// Wait only if the pending prefetch has the data.
+		if (ra->req && ra->req_idx == i)
+			_ra_wait(ums);
+
+		if (!win->valid)
+			continue;
+
+		*idx = i;
+		return win;
+	}
+
+	return NULL;
+}
+
+static u8 *_scsi_read_data(usbd_gadget_ums_t *ums, u32 lba, u32 amount, u8 *sdmmc_buf)
+{
+	u32 idx;
+	ums_ra_window_t *win = _ra_find(ums, lba, &idx);
+
+	// Serve from a read-ahead window if it has all the data.
+	if (win && (lba + amount) <= (win->lba + win->sectors))
+	{
+		u8 *buf = _ra_window_buf(idx) + ((lba - win->lba) << UMS_DISK_LBA_SHIFT);
+
+		// USB2 needs page aligned buffers.
+		if (!ums->xusb && ((u32)buf % USB_EP_BUFFER_ALIGN))
+		{
+			memcpy(sdmmc_buf, buf, amount << UMS_DISK_LBA_SHIFT);
+			buf = sdmmc_buf;
+		}
+
+		return buf;
+	}
+
+	// Copy the cached prefix of a read that crosses the end of a window and read only the rest.
+	u8 *buf = sdmmc_buf;
+	while (win)
+	{
+		u32 cnt = win->lba + win->sectors - lba;
+		memcpy(buf, _ra_window_buf(idx) + ((lba - win->lba) << UMS_DISK_LBA_SHIFT), cnt << UMS_DISK_LBA_SHIFT);
+		lba    += cnt;
+		amount -= cnt;
+		buf    += cnt << UMS_DISK_LBA_SHIFT;
+
+		win = _ra_find(ums, lba, &idx);
+		if (win && (lba + amount) <= (win->lba + win->sectors))
+		{
+			memcpy(buf, _ra_window_buf(idx) + ((lba - win->lba) << UMS_DISK_LBA_SHIFT), amount << UMS_DISK_LBA_SHIFT);
+
+			return sdmmc_buf;
+		}
+	}
+
+	// Do the SDMMC read and get any newer data from the write cache.
+	// A pending prefetch is small unless the stream was sequential, so waiting for it is short.
+	_ra_wait(ums);
+	if (!sdmmc_storage_read(ums->lun.storage, ums->lun.offset + lba, amount, buf))
+		return NULL;
+
+	_wcache_copy(ums, lba, amount, buf, false);
+
+	return sdmmc_buf;
+}
+
 /*
  * The following are old data based on max 64KB SCSI transfers.
  * The endpoint xfer is actually 41.2 MB/s and SD card max 39.2 MB/s, with higher SCSI
@@ -472,6 +785,12 @@ static int _scsi_read(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 	if (!amount_left)
 		return UMS_RES_IO_ERROR; // No default reply.
 
+	// Check if it continues the previous read. Random reads restart prefetch from its smallest size.
+	bool sequential = lba_offset == ums->ra.next_lba;
+	ums->ra.next_lba = lba_offset + amount_left;
+	if (!sequential)
+		ums->ra.pf_sectors = UMS_RA_MIN_SECTORS;
+
 	// Limit IO transfers based on request for faster concurrent reads.
 	u32 max_io_transfer = (amount_left >= UMS_SCSI_TRANSFER_512K) ?
 						  UMS_DISK_MAX_IO_TRANSFER_64K : UMS_DISK_MAX_IO_TRANSFER_32K;
@@ -494,8 +813,9 @@ static int _scsi_read(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 			break;
 		}
 
-		// Do the SDMMC read.
-		if (!sdmmc_storage_read(ums->lun.storage, ums->lun.offset + lba_offset, amount, sdmmc_buf))
+		// Do the SDMMC read or get the data from read-ahead.
+		u8 *data_buf = _scsi_read_data(ums, lba_offset, amount, sdmmc_buf);
+		if (!data_buf)
 			amount = 0;
 
 		// Wait for the async USB transfer to finish.
@@ -508,7 +828,7 @@ static int _scsi_read(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 
 		bulk_ctxt->bulk_in_length    = amount << UMS_DISK_LBA_SHIFT;
 		bulk_ctxt->bulk_in_buf_state = BUF_STATE_FULL;
-		bulk_ctxt->bulk_in_buf       = sdmmc_buf;
+		bulk_ctxt->bulk_in_buf       = data_buf;
 
 		// If an error occurred, report it and its position.
 		if (!amount)
@@ -522,7 +842,12 @@ static int _scsi_read(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 
 		// Last SDMMC read. Last part will be sent by the finish reply function.
 		if (!amount_left)
+		{
+			// Prefetch the next data of a sequential stream, while the host processes this one.
+			if (sequential)
+				_ra_prefetch(ums, lba_offset);
 			break;
+		}
 
 		// Start the USB transfer.
 		_transfer_start(ums, bulk_ctxt, bulk_ctxt->bulk_in, USB_XFER_START);
@@ -538,10 +863,37 @@ static int _scsi_read(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 /*
  * Writes are another story.
  * Tests showed that big writes are faster than concurrent 32K usb reads + writes.
- * The only thing that can help here is caching the writes. But for the simplicity
- * of this implementation it will not be implemented yet.
+ * So 512KB EP OUT reads are used, alternating between 2 buffers. The SDMMC write
+ * of one chunk runs in the background while the next one is received, even for
+ * the typical 128KB - 1MB host writes.
+ * Small writes (FS metadata updates) can optionally be cached in 64KB lines
+ * and written back on sync, medium removal allow, eject or eviction.
  */
 
+static int _scsi_write_finish(usbd_gadget_ums_t *ums, sdmmc_storage_async_t **req, u32 lba, u32 amount)
+{
+	if (!*req)
+		return 1;
+
+	int res = sdmmc_storage_async_wait(*req);
+	*req = NULL;
+
+	// If an error occurred, report it and its position.
+	if (!res)
+	{
+		ums->set_text(ums->label, "#FFDD00 Error:# SDMMC Write!");
+		ums->lun.sense_data      = SS_WRITE_ERROR;
+		ums->lun.sense_data_info = lba;
+		ums->lun.info_valid      = 1;
+
+		return 0;
+	}
+
+	ums->residue -= amount;
+
+	return 1;
+}
+
 static int _scsi_write(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 {
 	static char txt_buf[256];
@@ -581,6 +933,19 @@ static int _scsi_write(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 		return UMS_RES_INVALID_ARG;
 	}
 
+	// Drop read-ahead data.
+	_ra_invalidate(ums);
+
+	// Small writes go to the write-back cache.
+	bool cached = ums->wcache.enabled && ums->data_size_from_cmnd <= UMS_WCACHE_MAX_WRITE;
+
+	// Use 2 buffers, so the next one is received while the current one is written.
+	u8 *out_bufs[2] = { (u8 *)USB_EP_BULK_OUT_BUF_ADDR, (u8 *)SDXC_BUF_ALIGNED };
+	u32 out_buf_idx = 0;
+	sdmmc_storage_async_t *write_req = NULL;
+	u32 write_lba = 0;
+	u32 write_amount = 0;
+
 	// Carry out the file writes.
 	usb_lba_offset       = lba_offset;
 	amount_left_to_req   = ums->data_size_from_cmnd;
@@ -592,8 +957,8 @@ static int _scsi_write(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 		if (amount_left_to_req > 0)
 		{
 
-			// Limit write to max supported read from EP OUT.
-			amount = MIN(amount_left_to_req, UMS_EP_OUT_MAX_XFER);
+			// Split write in chunks, so the next one is received while the current one is written.
+			amount = MIN(amount_left_to_req, UMS_EP_OUT_CHUNK);
 
 			if (usb_lba_offset >= ums->lun.num_sectors)
 			{
@@ -610,6 +975,7 @@ static int _scsi_write(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 			amount_left_to_req   -= amount;
 
 			bulk_ctxt->bulk_out_length = amount;
+			bulk_ctxt->bulk_out_buf    = out_bufs[out_buf_idx];
 
 			_transfer_out_big_read(ums, bulk_ctxt);
 		}
@@ -649,26 +1015,38 @@ static int _scsi_write(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 			if (amount == 0)
 				goto empty_write;
 
-			// Perform the write.
-			if (!sdmmc_storage_write(ums->lun.storage, ums->lun.offset + lba_offset,
-				amount >> UMS_DISK_LBA_SHIFT, (u8 *)bulk_ctxt->bulk_out_buf))
-				amount = 0;
+			if (cached)
+			{
+				// Perform the cached write.
+				if (!_wcache_write(ums, lba_offset, amount >> UMS_DISK_LBA_SHIFT, bulk_ctxt->bulk_out_buf))
+				{
+					ums->set_text(ums->label, "#FFDD00 Error:# SDMMC Write!");
+					ums->lun.sense_data      = SS_WRITE_ERROR;
+					ums->lun.sense_data_info = lba_offset;
+					ums->lun.info_valid      = 1;
+					break;
+				}
+				ums->residue -= amount;
+			}
+			else
+			{
+				// Wait for the previous write to finish.
+				if (!_scsi_write_finish(ums, &write_req, write_lba, write_amount))
+					break;
+
+				// Keep cached lines coherent and perform the write in the background.
+				_wcache_copy(ums, lba_offset, amount >> UMS_DISK_LBA_SHIFT, bulk_ctxt->bulk_out_buf, true);
+				write_req = sdmmc_storage_write_async(ums->lun.storage, ums->lun.offset + lba_offset,
+					amount >> UMS_DISK_LBA_SHIFT, bulk_ctxt->bulk_out_buf);
+				write_lba    = lba_offset;
+				write_amount = amount;
+				out_buf_idx ^= 1;
+			}
 
 DPRINTF("file write %X @ %X\n", amount, lba_offset);
 
 			lba_offset           += amount >> UMS_DISK_LBA_SHIFT;
 			amount_left_to_write -= amount;
-			ums->residue         -= amount;
-
-			// If an error occurred, report it and its position.
-			if (!amount)
-			{
-				ums->set_text(ums->label, "#FFDD00 Error:# SDMMC Write!");
-				ums->lun.sense_data      = SS_WRITE_ERROR;
-				ums->lun.sense_data_info = lba_offset;
-				ums->lun.info_valid      = 1;
-				break;
-			}
 
  empty_write:
 			// Did the host decide to stop early?
@@ -681,6 +1059,11 @@ DPRINTF("file write %X @ %X\n", amount, lba_offset);
 		}
 	}
 
+	// Wait for the last write to finish.
+	_scsi_write_finish(ums, &write_req, write_lba, write_amount);
+
+	_reset_buffer(bulk_ctxt, bulk_ctxt->bulk_out);
+
 	return UMS_RES_IO_ERROR; // No default reply.
 }
 
@@ -708,6 +1091,8 @@ static int _scsi_verify(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 	if (verification_length == 0)
 		return UMS_RES_IO_ERROR; // No default reply.
 
+	_ra_wait(ums);
+
 	u32 amount;
 	while (verification_length > 0)
 	{
@@ -990,8 +1375,8 @@ static int _scsi_mode_sense(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 		// None of the fields are changeable.
 		if (!changeable_values)
 		{
-			// Write Cache enable, Read Cache not disabled, Multiplication Factor off.
-			buf[2] = 0x04;
+			// Write Cache enable if write-back cache is on, Read Cache not disabled, Multiplication Factor off.
+			buf[2] = ums->wcache.enabled ? 0x04 : 0x00;
 
 			// Multiplication Factor is disabled, so all values below are 1x LBA.
 			put_array_le_to_be16(0xFFFF, &buf[4]);  // Disable Prefetch if >32MB.
@@ -1021,6 +1406,22 @@ static int _scsi_mode_sense(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 	return len;
 }
 
+static int _scsi_synchronize_cache(usbd_gadget_ums_t *ums)
+{
+	_ra_wait(ums);
+
+	// Write back all dirty cached lines.
+	if (!_wcache_flush(ums))
+	{
+		ums->set_text(ums->label, "#FFDD00 Error:# SDMMC Write!");
+		ums->lun.sense_data = SS_WRITE_ERROR;
+
+		return UMS_RES_INVALID_ARG;
+	}
+
+	return UMS_RES_OK;
+}
+
 static int _scsi_start_stop(usbd_gadget_ums_t *ums)
 {
 	int loej, start;
@@ -1064,6 +1465,10 @@ static int _scsi_start_stop(usbd_gadget_ums_t *ums)
 		return UMS_RES_INVALID_ARG;
 	}
 
+	// Write back any cached data before stopping.
+	if (_scsi_synchronize_cache(ums))
+		return UMS_RES_INVALID_ARG;
+
 	if (!loej)
 		return UMS_RES_OK;
 
@@ -1092,9 +1497,12 @@ static int _scsi_prevent_allow_removal(usbd_gadget_ums_t *ums)
 		return UMS_RES_INVALID_ARG;
 	}
 
-	// Notify for possible unmounting?
-	// Normally we sync here but we do synced writes to SDMMC.
-	if (ums->lun.prevent_medium_removal && !prevent) { /* Do nothing */ }
+	// Sync cached writes for possible unmounting.
+	if (ums->lun.prevent_medium_removal && !prevent)
+	{
+		if (_scsi_synchronize_cache(ums))
+			return UMS_RES_INVALID_ARG;
+	}
 
 	ums->lun.prevent_medium_removal = prevent;
 
@@ -1330,7 +1738,7 @@ static int _parse_scsi_cmd(usbd_gadget_ums_t *ums, bulk_ctxt_t *bulk_ctxt)
 		ums->data_size_from_cmnd = 0;
 		reply = _check_scsi_cmd(ums, 10, DATA_DIR_NONE, (0xf<<2) | (3<<7), 1);
 		if (reply == 0)
-			reply = 0; // Don't bother
+			reply = _scsi_synchronize_cache(ums);
 		break;
 
 	case SC_TEST_UNIT_READY:
@@ -1850,6 +2258,11 @@ int usb_device_gadget_ums(usb_ctxt_t *usbs)
 	ums.lun.removable = 1; // Always removable to force OSes to use prevent media removal.
 	ums.lun.unit_attention_data = SS_RESET_OCCURRED;
 
+	// Enable write-back cache if requested.
+	ums.wcache.enabled = usbs->write_cache && !usbs->ro;
+	ums.ra.next_lba = -1;
+	ums.ra.pf_sectors = UMS_RA_MIN_SECTORS;
+
 	// Set system functions
 	ums.label = usbs->label;
 	ums.set_text = usbs->set_text;
@@ -1949,6 +2362,11 @@ int usb_device_gadget_ums(usb_ctxt_t *usbs)
 		_send_status(&ums, &ums.bulk_ctxt);
 	} while (ums.state != UMS_STATE_TERMINATED);
 
+	// Write back any remaining cached data.
+	_ra_wait(&ums);
+	if (!_wcache_flush(&ums))
+		ums.set_text(ums.label, "#FFDD00 Error:# SDMMC Write!");
+
 	if (ums.lun.prevent_medium_removal)
 		ums.set_text(ums.label, "#FFDD00 Error:# Disk unsafely ejected");
 	else
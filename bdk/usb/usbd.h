@@ -190,6 +190,7 @@ typedef struct _usb_ctxt_t
 	u32 offset;
 	u32 sectors;
 	u32 ro;
+	u32 write_cache;
 	void (*system_maintenance)(bool);
 	void *label;
 	void (*set_text)(void *, const char *);
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "trace.h"
+#include <libs/fatfs/ff.h>
+#include <rtc/max77620-rtc.h>
+#include <soc/timer.h>
+#include <storage/sd.h>
+
+// Lives in DRAM, so it can be handed over on chainload. NULL until DRAM is up.
+static trace_buf_t *trace_buf = NULL;
+
+void trace_init(trace_buf_t *buf, bool reset)
+{
+	// Keep previous records only if they are valid.
+	if (reset || buf->magic != TRACE_MAGIC || buf->version != TRACE_VERSION || buf->recs_max != TRACE_RECS_MAX)
+	{
+		buf->magic    = TRACE_MAGIC;
+		buf->version  = TRACE_VERSION;
+		buf->recs_max = TRACE_RECS_MAX;
+		buf->head     = 0;
+	}
+
+	trace_buf = buf;
+}
+
+void trace_record_ts(u32 ts, u32 type, u32 id, u32 arg)
+{
+	if (!trace_buf)
+		return;
+
+	trace_rec_t *rec = &trace_buf->recs[trace_buf->head & (TRACE_RECS_MAX - 1)];
+	rec->ts   = ts;
+	rec->id   = id;
+	rec->type = type;
+	rec->arg  = arg;
+
+	trace_buf->head++;
+}
+
+void trace_record(u32 type, u32 id, u32 arg)
+{
+	trace_record_ts(get_tmr_us(), type, id, arg);
+}
+
+int trace_save(const char *prefix)
+{
+	FILINFO fno;
+	char path[64];
+
+	// Only save if the user created the trace folder.
+	if (!trace_buf || f_stat(TRACE_DIR, &fno))
+		return 1;
+
+	strcpy(path, TRACE_DIR "/");
+	strcat(path, prefix);
+	strcat(path, "_");
+
+	// Create date/time name. Not using s_printf, since hekate doesn't link it.
+	rtc_time_t time;
+	max77620_rtc_get_time_adjusted(&time);
+	itoa(time.year * 10000 + time.month * 100 + time.day, path + strlen(path), 10);
+	strcat(path, "_");
+	u32 pos = strlen(path);
+	itoa(1000000 + time.hour * 10000 + time.min * 100 + time.sec, path + pos, 10);
+	memmove(path + pos, path + pos + 1, 7); // Drop the leading 1 used for zero padding.
+	strcat(path, ".bin");
+
+	return sd_save_to_file(trace_buf, sizeof(trace_buf_t), path);
+}
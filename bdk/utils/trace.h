@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <utils/types.h>
+
+#define TRACE_MAGIC    0x45435254 // "TRCE".
+#define TRACE_VERSION  1
+#define TRACE_RECS_MAX 512 // Power of 2.
+
+#define TRACE_DIR "bootloader/trace"
+
+typedef enum _trace_type_t
+{
+	TRACE_TYPE_BEGIN = 0,
+	TRACE_TYPE_END   = 1,
+	TRACE_TYPE_POINT = 2
+} trace_type_t;
+
+// Event ids. Keep in sync with the names in tools/tracedec.
+typedef enum _trace_id_t
+{
+	TRACE_NONE              = 0,
+
+	// Storage.
+	TRACE_SD_INIT           = 1,
+	TRACE_SD_MOUNT          = 2,
+	TRACE_EMMC_INIT         = 3,
+	TRACE_EMUMMC_INIT       = 4,
+	TRACE_PKG1_READ         = 5,
+	TRACE_PKG2_READ         = 6,
+
+	// Crypto.
+	TRACE_HOS_KEYGEN        = 7,
+	TRACE_PKG1_DECRYPT      = 8,
+	TRACE_PKG2_DECRYPT      = 9,
+	TRACE_PKG2_CACHE_LOAD   = 10,
+	TRACE_PKG2_BUILD        = 11,
+
+	// Decompression.
+	TRACE_KIP_DECOMPRESS    = 12,
+
+	// hekate stages.
+	TRACE_HW_INIT           = 13,
+	TRACE_MINERVA_INIT      = 14,
+	TRACE_AUTO_LAUNCH       = 15,
+	TRACE_INI_PARSE         = 16,
+	TRACE_BOOT_WAIT         = 17,
+	TRACE_HOS_LAUNCH        = 18,
+	TRACE_HOS_CONFIG        = 19,
+	TRACE_PKG2_PATCH        = 20,
+	TRACE_PKG2_CACHE_SAVE   = 21,
+	TRACE_HOS_HANDOFF       = 22, // Last event before SD is unmounted for secmon launch.
+	TRACE_NYX_LOAD          = 23,
+	TRACE_NYX_LAUNCH        = 24,
+
+	// Nyx stages.
+	TRACE_NYX_MAIN          = 25,
+	TRACE_NYX_RES_LOAD      = 26,
+
+	TRACE_ID_MAX
+} trace_id_t;
+
+typedef struct _trace_rec_t
+{
+	u32 ts; // TMR us.
+	u16 id;
+	u8  type;
+	u8  rsvd;
+	u32 arg;
+} trace_rec_t;
+
+typedef struct _trace_buf_t
+{
+	u32 magic;
+	u32 version;
+	u32 recs_max;
+	u32 head; // Total records written. Oldest is at head - recs_max if wrapped.
+	trace_rec_t recs[TRACE_RECS_MAX];
+} trace_buf_t;
+
+void trace_init(trace_buf_t *buf, bool reset);
+void trace_record(u32 type, u32 id, u32 arg);
+void trace_record_ts(u32 ts, u32 type, u32 id, u32 arg);
+int  trace_save(const char *prefix);
+
+#ifdef BDK_TRACE_ENABLE
+#define TRACE_INIT(buf, reset)      trace_init(buf, reset)
+#define TRACE_SAVE(prefix)          trace_save(prefix)
+#define TRACE_BEGIN(id, arg)        trace_record(TRACE_TYPE_BEGIN, id, arg)
+#define TRACE_END(id, arg)          trace_record(TRACE_TYPE_END,   id, arg)
+#define TRACE_POINT(id, arg)        trace_record(TRACE_TYPE_POINT, id, arg)
+#define TRACE_BEGIN_TS(id, arg, ts) trace_record_ts(ts, TRACE_TYPE_BEGIN, id, arg)
+#else
+#define TRACE_INIT(buf, reset)
+#define TRACE_SAVE(prefix)
+#define TRACE_BEGIN(id, arg)
+#define TRACE_END(id, arg)
+#define TRACE_POINT(id, arg)
+#define TRACE_BEGIN_TS(id, arg, ts) (void)(ts)
+#endif
+
+#endif
@@ -19,6 +19,7 @@
 #define _UTIL_H_
 
 #include <utils/types.h>
+#include <utils/trace.h>
 #include <mem/minerva.h>
 
 #define NYX_NEW_INFO 0x3058594E
@@ -73,7 +74,8 @@ typedef struct _nyx_storage_t
 	u32 cfg;
 	u8  irama[0x8000];
 	u8  hekate[0x30000];
-	u8  rsvd[SZ_8M - sizeof(nyx_info_t)];
+	trace_buf_t trace;
+	u8  rsvd[SZ_8M - sizeof(nyx_info_t) - sizeof(trace_buf_t)];
 	nyx_info_t info;
 	mtc_config_t mtc_cfg;
 	emc_table_t mtc_table[11]; // 10 + 1.
@@ -40,6 +40,12 @@ extern hekate_config h_cfg;
 
 #define PKG2_LOAD_ADDR 0xA9800000
 
+#define PKG2_CACHE_MAGIC    0x43324B50 // "PK2C".
+#define PKG2_CACHE_VERSION  1
+#define PKG2_CACHE_SLOTS    4
+#define PKG2_CACHE_MAX_SIZE SZ_32M
+#define PKG2_CACHE_DIR      "bootloader/cache"
+
 #define SECMON_BCT_CFG_ADDR  0x4003D000
 #define SECMON6_BCT_CFG_ADDR 0x4003F800
 
@@ -48,6 +54,18 @@ extern hekate_config h_cfg;
 #define SECMON7_MAILBOX_ADDR 0x40000000
 #define  SECMON_STATE_OFFSET 0xF8
 
+typedef struct _pkg2_cache_hdr_t
+{
+	u32 magic;
+	u32 version;
+	u32 size;
+	u32 hos_revision;
+	int emummc_fs_ver;
+	u32 rsvd[3];
+	u8  key[SE_SHA_256_SIZE];  // Hash of all inputs.
+	u8  hash[SE_SHA_256_SIZE]; // Hash of the built pkg2.
+} pkg2_cache_hdr_t;
+
 typedef enum
 {
 	SECMON_STATE_NOT_READY    = 0,
@@ -750,6 +768,145 @@ static bool _get_fs_exfat_compatible(link_t *info, u32 *hos_revision)
 	return true;
 }
 
+static void _pkg2_cache_key_add(u8 *key, const void *data, u32 size)
+{
+	u8 buf[SE_SHA_256_SIZE * 2];
+
+	// Chain the hash of the input into the key.
+	memcpy(buf, key, SE_SHA_256_SIZE);
+	memset(buf + SE_SHA_256_SIZE, 0, SE_SHA_256_SIZE);
+	if (data && size)
+		se_calc_sha256_oneshot(buf + SE_SHA_256_SIZE, data, size);
+	se_calc_sha256_oneshot(key, buf, sizeof(buf));
+}
+
+static void _pkg2_cache_key_add_file(u8 *key, const char *path)
+{
+	u32 size = 0;
+	void *buf = sd_file_read(path, &size);
+
+	_pkg2_cache_key_add(key, buf, size);
+
+	free(buf);
+}
+
+static void _pkg2_cache_key(launch_ctxt_t *ctxt, u8 kb, bool is_exo, bool emummc_enabled, u8 *key)
+{
+	// Configuration that affects the build.
+	u32 cfg[] = {
+		PKG2_CACHE_VERSION, BL_VER_MJ, BL_VER_MN, BL_VER_HF, BL_VER_RL,
+		kb, is_exo, h_cfg.t210b01, ctxt->pkg1_id->fuses, sd_fs.fs_type,
+		ctxt->stock, ctxt->svcperm, ctxt->debugmode, ctxt->atmosphere,
+		ctxt->secmon != NULL, emummc_enabled
+	};
+
+	memset(key, 0, SE_SHA_256_SIZE);
+	_pkg2_cache_key_add(key, cfg, sizeof(cfg));
+
+	// Build id of this hekate. Also covers the compiled-in kernel/KIP1 patch tables.
+	_pkg2_cache_key_add(key, __DATE__ __TIME__, sizeof(__DATE__ __TIME__));
+	u32 patches_size = pkg2_builtin_patches_serialize(NULL);
+	u8 *patches = (u8 *)malloc(patches_size);
+	if (patches)
+		pkg2_builtin_patches_serialize(patches);
+	_pkg2_cache_key_add(key, patches, patches ? patches_size : 0);
+	free(patches);
+
+	// Package2, kernel, extra KIP1s and patches.
+	_pkg2_cache_key_add(key, ctxt->pkg2, ctxt->pkg2_size);
+	_pkg2_cache_key_add(key, ctxt->kernel, ctxt->kernel_size);
+
+	LIST_FOREACH_ENTRY(merge_kip_t, mki, &ctxt->kip1_list, link)
+		_pkg2_cache_key_add(key, mki->kip1, pkg2_calc_kip1_size((pkg2_kip1_t *)mki->kip1));
+
+	if (ctxt->kip1_patches)
+		_pkg2_cache_key_add(key, ctxt->kip1_patches, strlen(ctxt->kip1_patches));
+	_pkg2_cache_key_add_file(key, "bootloader/patches.ini");
+	if (emummc_enabled)
+		_pkg2_cache_key_add_file(key, "bootloader/sys/emummc.kipm");
+}
+
+static void _pkg2_cache_path(char *path, const u8 *key)
+{
+	// Select slot by key.
+	strcpy(path, PKG2_CACHE_DIR"/pkg2_0.bin");
+	path[sizeof(PKG2_CACHE_DIR"/pkg2_") - 1] += key[0] % PKG2_CACHE_SLOTS;
+}
+
+static bool _pkg2_cache_load(launch_ctxt_t *ctxt, const u8 *key)
+{
+	FIL fp;
+	char path[64];
+	pkg2_cache_hdr_t hdr;
+	u8 hash[SE_SHA_256_SIZE];
+	bool res = false;
+
+	_pkg2_cache_path(path, key);
+	if (f_open(&fp, path, FA_READ) != FR_OK)
+		return false;
+
+	// Check that cache matches all inputs.
+	if (f_read(&fp, &hdr, sizeof(hdr), NULL) != FR_OK)
+		goto out;
+
+	if (hdr.magic != PKG2_CACHE_MAGIC || hdr.version != PKG2_CACHE_VERSION ||
+		memcmp(hdr.key, key, SE_SHA_256_SIZE) ||
+		hdr.size > PKG2_CACHE_MAX_SIZE || f_size(&fp) != (sizeof(hdr) + hdr.size))
+		goto out;
+
+	if (f_read(&fp, (void *)PKG2_LOAD_ADDR, hdr.size, NULL) != FR_OK)
+		goto out;
+
+	// Check integrity.
+	se_calc_sha256_oneshot(hash, (void *)PKG2_LOAD_ADDR, hdr.size);
+	if (memcmp(hash, hdr.hash, SE_SHA_256_SIZE))
+		goto out;
+
+	// Restore state that was set while building.
+	ctxt->exo_ctx.hos_revision = hdr.hos_revision;
+	emu_cfg.fs_ver = hdr.emummc_fs_ver;
+
+	res = true;
+
+out:
+	f_close(&fp);
+
+	return res;
+}
+
+static void _pkg2_cache_save(launch_ctxt_t *ctxt, const u8 *key)
+{
+	FIL fp;
+	char path[64];
+	pkg2_cache_hdr_t hdr = {0};
+
+	// Get size of built pkg2 from its header.
+	hdr.magic         = PKG2_CACHE_MAGIC;
+	hdr.version       = PKG2_CACHE_VERSION;
+	hdr.size          = *(u32 *)(PKG2_LOAD_ADDR + 0x100);
+	hdr.hos_revision  = ctxt->exo_ctx.hos_revision;
+	hdr.emummc_fs_ver = emu_cfg.fs_ver;
+	memcpy(hdr.key, key, SE_SHA_256_SIZE);
+
+	if (hdr.size > PKG2_CACHE_MAX_SIZE)
+		return;
+
+	se_calc_sha256_oneshot(hdr.hash, (void *)PKG2_LOAD_ADDR, hdr.size);
+
+	f_mkdir(PKG2_CACHE_DIR);
+	_pkg2_cache_path(path, key);
+	if (f_open(&fp, path, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+		return;
+
+	bool failed = f_write(&fp, &hdr, sizeof(hdr), NULL) != FR_OK ||
+				  f_write(&fp, (void *)PKG2_LOAD_ADDR, hdr.size, NULL) != FR_OK;
+	f_close(&fp);
+
+	// Do not leave a partial cache.
+	if (failed)
+		f_unlink(path);
+}
+
 int hos_launch(ini_sec_t *cfg)
 {
 	u8 kb;
@@ -760,6 +917,8 @@ int hos_launch(ini_sec_t *cfg)
 	tsec_ctxt_t tsec_ctxt = {0};
 	volatile secmon_mailbox_t *secmon_mailbox;
 
+	TRACE_BEGIN(TRACE_HOS_LAUNCH, 0);
+
 	minerva_change_freq(FREQ_1600);
 	sdram_src_pllc(true);
 	list_init(&ctxt.kip1_list);
@@ -773,7 +932,9 @@ int hos_launch(ini_sec_t *cfg)
 	gfx_puts("Initializing...\n\n");
 
 	// Initialize eMMC/emuMMC.
+	TRACE_BEGIN(TRACE_EMUMMC_INIT, 0);
 	int res = emummc_storage_init_mmc();
+	TRACE_END(TRACE_EMUMMC_INIT, res);
 	if (res)
 	{
 		if (res == 2)
@@ -792,14 +953,20 @@ int hos_launch(ini_sec_t *cfg)
 	}
 
 	// Try to parse config if present.
-	if (ctxt.cfg && !parse_boot_config(&ctxt))
+	TRACE_BEGIN(TRACE_HOS_CONFIG, 0);
+	res = ctxt.cfg && !parse_boot_config(&ctxt);
+	TRACE_END(TRACE_HOS_CONFIG, res);
+	if (res)
 	{
 		_hos_crit_error("Wrong ini cfg or missing/corrupt files!");
 		goto error;
 	}
 
 	// Read package1 and the correct keyblob.
-	if (!_read_emmc_pkg1(&ctxt))
+	TRACE_BEGIN(TRACE_PKG1_READ, 0);
+	res = !_read_emmc_pkg1(&ctxt);
+	TRACE_END(TRACE_PKG1_READ, res);
+	if (res)
 	{
 		// Check if stock is enabled and device can boot in OFW.
 		if (ctxt.stock && (h_cfg.t210b01 || !tools_autorcm_enabled()))
@@ -880,7 +1047,10 @@ int hos_launch(ini_sec_t *cfg)
 	tsec_ctxt.pkg11_off = ctxt.pkg1_id->pkg11_off;
 
 	// Generate keys.
-	if (!hos_keygen(ctxt.keyblob, kb, &tsec_ctxt, ctxt.stock, is_exo))
+	TRACE_BEGIN(TRACE_HOS_KEYGEN, kb);
+	res = !hos_keygen(ctxt.keyblob, kb, &tsec_ctxt, ctxt.stock, is_exo);
+	TRACE_END(TRACE_HOS_KEYGEN, res);
+	if (res)
 		goto error;
 	gfx_puts("Generated keys\n");
 
@@ -890,7 +1060,10 @@ int hos_launch(ini_sec_t *cfg)
 		// Decrypt PK1 or PK11.
 		if (kb <= HOS_KB_VERSION_600 || h_cfg.t210b01)
 		{
-			if (!pkg1_decrypt(ctxt.pkg1_id, ctxt.pkg1))
+			TRACE_BEGIN(TRACE_PKG1_DECRYPT, 0);
+			res = !pkg1_decrypt(ctxt.pkg1_id, ctxt.pkg1);
+			TRACE_END(TRACE_PKG1_DECRYPT, res);
+			if (res)
 			{
 				_hos_crit_error("Pkg1 decryption failed!");
 
@@ -966,7 +1139,9 @@ int hos_launch(ini_sec_t *cfg)
 	gfx_puts("Loaded warmboot and secmon\n");
 
 	// Read package2.
+	TRACE_BEGIN(TRACE_PKG2_READ, 0);
 	u8 *bootConfigBuf = _read_emmc_pkg2(&ctxt);
+	TRACE_END(TRACE_PKG2_READ, ctxt.pkg2_size);
 	if (!bootConfigBuf)
 	{
 		_hos_crit_error("Pkg2 read failed!");
@@ -975,8 +1150,27 @@ int hos_launch(ini_sec_t *cfg)
 
 	gfx_puts("Read pkg2\n");
 
+	// Use the cached build if all inputs are the same.
+	u8 pkg2_cache_key[SE_SHA_256_SIZE];
+	bool pkg2_cached = false;
+	if (!ctxt.pkg2_cache_disable)
+	{
+		TRACE_BEGIN(TRACE_PKG2_CACHE_LOAD, 0);
+		_pkg2_cache_key(&ctxt, kb, is_exo, emummc_enabled, pkg2_cache_key);
+		pkg2_cached = _pkg2_cache_load(&ctxt, pkg2_cache_key);
+		TRACE_END(TRACE_PKG2_CACHE_LOAD, pkg2_cached);
+	}
+
+	if (pkg2_cached)
+	{
+		gfx_puts("Loaded cached pkg2\n");
+		goto pkg2_loaded;
+	}
+
 	// Decrypt package2 and parse KIP1 blobs in INI1 section.
+	TRACE_BEGIN(TRACE_PKG2_DECRYPT, 0);
 	pkg2_hdr_t *pkg2_hdr = pkg2_decrypt(ctxt.pkg2, kb, is_exo);
+	TRACE_END(TRACE_PKG2_DECRYPT, !pkg2_hdr);
 	if (!pkg2_hdr)
 	{
 		_hos_crit_error("Pkg2 decryption failed!\npkg1/pkg2 mismatch or old hekate!");
@@ -1062,7 +1256,9 @@ int hos_launch(ini_sec_t *cfg)
 	}
 
 	// Patch kip1s in memory if needed.
+	TRACE_BEGIN(TRACE_PKG2_PATCH, 0);
 	const char *failed_patch = pkg2_patch_kips(&kip1_info, ctxt.kip1_patches);
+	TRACE_END(TRACE_PKG2_PATCH, failed_patch != NULL);
 	if (failed_patch != NULL)
 	{
 		EHPRINTFARGS("Failed to apply '%s'!", failed_patch);
@@ -1079,12 +1275,27 @@ int hos_launch(ini_sec_t *cfg)
 	}
 
 	// Rebuild and encrypt package2.
+	TRACE_BEGIN(TRACE_PKG2_BUILD, 0);
 	pkg2_build_encrypt((void *)PKG2_LOAD_ADDR, &ctxt, &kip1_info, is_exo);
+	TRACE_END(TRACE_PKG2_BUILD, 0);
 
+	// Save it to cache. Skip if a patch failed to apply.
+	if (!ctxt.pkg2_cache_disable && !failed_patch)
+	{
+		TRACE_BEGIN(TRACE_PKG2_CACHE_SAVE, 0);
+		_pkg2_cache_save(&ctxt, pkg2_cache_key);
+		TRACE_END(TRACE_PKG2_CACHE_SAVE, 0);
+	}
+
+pkg2_loaded:
 	// Configure Exosphere if secmon is replaced.
 	if (is_exo)
 		config_exosphere(&ctxt, warmboot_base);
 
+	// Save boot trace while SD is still available.
+	TRACE_POINT(TRACE_HOS_HANDOFF, pkg2_cached);
+	TRACE_SAVE("hos");
+
 	// Unmount SD card and eMMC.
 	sd_end();
 	emmc_end();
@@ -1092,7 +1303,7 @@ int hos_launch(ini_sec_t *cfg)
 	// Close AHB aperture. Important when stock old secmon is used.
 	mc_disable_ahb_redirect();
 
-	gfx_printf("Rebuilt & loaded pkg2\n\n%kBooting...%k\n", TXT_CLR_GREENISH, TXT_CLR_DEFAULT);
+	gfx_printf("%s & loaded pkg2\n\n%kBooting...%k\n", pkg2_cached ? "Cached" : "Rebuilt", TXT_CLR_GREENISH, TXT_CLR_DEFAULT);
 
 	// Clear pkg1/pkg2 keys.
 	se_aes_key_clear(8);
@@ -1197,6 +1408,8 @@ int hos_launch(ini_sec_t *cfg)
 		bpmp_halt();
 
 error:
+	TRACE_END(TRACE_HOS_LAUNCH, 1);
+
 	_free_launch_components(&ctxt);
 	sdram_src_pllc(false);
 	emmc_end();
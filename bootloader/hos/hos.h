@@ -110,6 +110,7 @@ typedef struct _launch_ctxt_t
 	bool debugmode;
 	bool stock;
 	bool emummc_forced;
+	bool pkg2_cache_disable;
 
 	void *fss0;
 	u32   fss0_hosver;
@@ -188,6 +188,16 @@ static int _config_emummc_forced(launch_ctxt_t *ctxt, const char *value)
 	return 1;
 }
 
+static int _config_pkg2_cache(launch_ctxt_t *ctxt, const char *value)
+{
+	if (*value == '0')
+	{
+		DPRINTF("Disabled pkg2 cache\n");
+		ctxt->pkg2_cache_disable = true;
+	}
+	return 1;
+}
+
 static int _config_atmosphere(launch_ctxt_t *ctxt, const char *value)
 {
 	if (*value == '1')
@@ -299,6 +309,7 @@ static const cfg_handler_t _config_handlers[] = {
 	{ "fss0",             _config_fss },
 	{ "exofatal",         _config_exo_fatal_payload},
 	{ "emummcforce",      _config_emummc_forced },
+	{ "pkg2cache",        _config_pkg2_cache },
 	{ "nouserexceptions", _config_dis_exo_user_exceptions },
 	{ "userpmu",          _config_exo_user_pmu_access },
 	{ "usb3force",        _config_exo_usb3_force },
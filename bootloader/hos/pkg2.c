@@ -66,6 +66,55 @@ void pkg2_get_ids(kip1_id_t **ids, u32 *entries)
 	*entries = _kip_id_sets_cnt;
 }
 
+static u32 _pkg2_patches_put(u8 *buf, u32 pos, const void *data, u32 size)
+{
+	if (buf && size)
+		memcpy(buf + pos, data, size);
+
+	return pos + size;
+}
+
+u32 pkg2_builtin_patches_serialize(u8 *buf)
+{
+	u32 pos = 0;
+
+	// Kernel patchsets.
+	for (u32 i = 0; i < ARRAY_SIZE(_pkg2_kernel_ids); i++)
+	{
+		const kernel_patch_t *kp = _pkg2_kernel_ids[i].kernel_patchset;
+
+		pos = _pkg2_patches_put(buf, pos, _pkg2_kernel_ids[i].hash, sizeof(_pkg2_kernel_ids[0].hash));
+		for (; kp && kp->id != 0xFFFFFFFF; kp++)
+		{
+			pos = _pkg2_patches_put(buf, pos, kp, 3 * sizeof(u32)); // id, off, val.
+			if (kp->id == ATM_ARR_PATCH && kp->ptr)
+				pos = _pkg2_patches_put(buf, pos, kp->ptr, kp->val * sizeof(u32));
+		}
+	}
+
+	// Built-in KIP1 patchsets. External ones are keyed through patches.ini.
+	for (u32 i = 0; i < ARRAY_SIZE(_kip_ids); i++)
+	{
+		pos = _pkg2_patches_put(buf, pos, _kip_ids[i].name, strlen(_kip_ids[i].name));
+		pos = _pkg2_patches_put(buf, pos, _kip_ids[i].hash, sizeof(_kip_ids[0].hash));
+
+		for (const kip1_patchset_t *ps = _kip_ids[i].patchset; ps && ps->name; ps++)
+		{
+			pos = _pkg2_patches_put(buf, pos, ps->name, strlen(ps->name) + 1);
+			for (const kip1_patch_t *kp = ps->patches; kp && kp->length; kp++)
+			{
+				pos = _pkg2_patches_put(buf, pos, kp, 2 * sizeof(u32)); // offset, length.
+				if (kp->src_data && kp->src_data != KIP1_PATCH_SRC_NO_CHECK)
+					pos = _pkg2_patches_put(buf, pos, kp->src_data, kp->length);
+				if (kp->dst_data)
+					pos = _pkg2_patches_put(buf, pos, kp->dst_data, kp->length);
+			}
+		}
+	}
+
+	return pos;
+}
+
 static void parse_external_kip_patches()
 {
 	static bool ext_patches_parsed = false;
@@ -180,7 +229,7 @@ const pkg2_kernel_id_t *pkg2_identify(const u8 *hash)
 	return NULL;
 }
 
-static u32 _pkg2_calc_kip1_size(pkg2_kip1_t *kip1)
+u32 pkg2_calc_kip1_size(pkg2_kip1_t *kip1)
 {
 	u32 size = sizeof(pkg2_kip1_t);
 	for (u32 j = 0; j < KIP1_NUM_SECTIONS; j++)
@@ -259,7 +308,7 @@ bool pkg2_parse_kips(link_t *info, pkg2_hdr_t *pkg2, bool *new_pkg2)
 		pkg2_kip1_t *kip1 = (pkg2_kip1_t *)ptr;
 		pkg2_kip1_info_t *ki = (pkg2_kip1_info_t *)malloc(sizeof(pkg2_kip1_info_t));
 		ki->kip1 = kip1;
-		ki->size = _pkg2_calc_kip1_size(kip1);
+		ki->size = pkg2_calc_kip1_size(kip1);
 		list_append(info, &ki->link);
 		ptr += ki->size;
 DPRINTF(" kip1 %d:%s @ %08X (%08X)\n", i, kip1->name, (u32)kip1, ki->size);
@@ -283,7 +332,7 @@ void pkg2_replace_kip(link_t *info, u64 tid, pkg2_kip1_t *kip1)
 		if (ki->kip1->tid == tid)
 		{
 			ki->kip1 = kip1;
-			ki->size = _pkg2_calc_kip1_size(kip1);
+			ki->size = pkg2_calc_kip1_size(kip1);
 DPRINTF("replaced kip %s (new size %08X)\n", kip1->name, ki->size);
 			return;
 		}
@@ -294,7 +343,7 @@ void pkg2_add_kip(link_t *info, pkg2_kip1_t *kip1)
 {
 	pkg2_kip1_info_t *ki = (pkg2_kip1_info_t *)malloc(sizeof(pkg2_kip1_info_t));
 	ki->kip1 = kip1;
-	ki->size = _pkg2_calc_kip1_size(kip1);
+	ki->size = pkg2_calc_kip1_size(kip1);
 DPRINTF("added kip %s (size %08X)\n", kip1->name, ki->size);
 	list_append(info, &ki->link);
 }
@@ -349,7 +398,10 @@ static int _decompress_kip(pkg2_kip1_info_t *ki, u32 sectsToDecomp)
 		u32 comp_size = hdr.sections[sect_idx].size_comp;
 		u32 output_size = hdr.sections[sect_idx].size_decomp;
 		gfx_printf("Decomping '%s', sect %d, size %d..\n", (char *)hdr.name, sect_idx, comp_size);
-		if (blz_uncompress_srcdest(src_data, comp_size, dst_data, output_size) == 0)
+		TRACE_BEGIN(TRACE_KIP_DECOMPRESS, comp_size);
+		int decomp_res = blz_uncompress_srcdest(src_data, comp_size, dst_data, output_size);
+		TRACE_END(TRACE_KIP_DECOMPRESS, output_size);
+		if (decomp_res == 0)
 		{
 			gfx_con.mute = false;
 			gfx_printf("%kERROR decomping sect %d of '%s'!%k\n", TXT_CLR_ERROR, sect_idx, (char *)hdr.name, TXT_CLR_DEFAULT);
@@ -47,7 +47,7 @@
 /* This sets FAT/FAT32 label. Exactly 11 characters, all caps. */
 
 
-#define FF_USE_FASTSEEK	0
+#define FF_USE_FASTSEEK	1
 /* This option switches fast seek function. (0:Disable or 1:Enable) */
 
 #define FF_FASTFS 0
@@ -247,6 +247,15 @@
 /  buffer in the filesystem object (FATFS) is used for the file data transfer. */
 
 
+#define FF_WIN_CACHE_SLOTS	8
+#define FF_WIN_CACHE_SECTORS	64
+/* FF_WIN_CACHE_SLOTS sets the number of lines in the read-ahead cache behind the
+/  window, which serves FAT, allocation bitmap and directory sectors (0:Disable).
+/  Each line holds FF_WIN_CACHE_SECTORS sectors (power of 2) and the lines are
+/  allocated by ff_memalloc() on the first mount of each volume and kept for
+/  later mounts. Writes update the cached copies. */
+
+
 #define FF_FS_EXFAT		1
 /* This option switches support for exFAT filesystem. (0:Disable or 1:Enable)
 /  To enable exFAT, also LFN needs to be enabled. (FF_USE_LFN >= 1)
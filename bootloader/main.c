@@ -611,7 +611,9 @@ out:
 
 static void _nyx_load_run()
 {
+	TRACE_BEGIN(TRACE_NYX_LOAD, 0);
 	u8 *nyx = sd_file_read("bootloader/sys/nyx.bin", NULL);
+	TRACE_END(TRACE_NYX_LOAD, !nyx);
 	if (!nyx)
 		return;
 
@@ -673,6 +675,9 @@ static void _nyx_load_run()
 	// Some cards (Sandisk U1), do not like a fast power cycle.
 	sdmmc_storage_init_wait_sd();
 
+	// Trace buffer is already in Nyx storage and continues there.
+	TRACE_POINT(TRACE_NYX_LAUNCH, 0);
+
 	void (*nyx_ptr)() = (void *)nyx;
 	(*nyx_ptr)();
 }
@@ -757,6 +762,8 @@ static void _auto_launch()
 	char *bootlogoCustomEntry = NULL;
 	bool  config_entry_found  = false;
 
+	TRACE_BEGIN(TRACE_AUTO_LAUNCH, 0);
+
 	_check_for_updated_bootloader();
 
 	bool boot_from_id = (b_cfg.boot_cfg & BOOT_CFG_FROM_ID) && (b_cfg.boot_cfg & BOOT_CFG_AUTOBOOT_EN);
@@ -773,7 +780,10 @@ static void _auto_launch()
 	emummc_load_cfg();
 
 	// Parse hekate main configuration.
-	if (!ini_parse(&ini_sections, "bootloader/hekate_ipl.ini", false))
+	TRACE_BEGIN(TRACE_INI_PARSE, 0);
+	int ini_res = ini_parse(&ini_sections, "bootloader/hekate_ipl.ini", false);
+	TRACE_END(TRACE_INI_PARSE, !ini_res);
+	if (!ini_res)
 		goto out; // Can't load hekate_ipl.ini.
 
 	// Load configuration.
@@ -961,6 +971,8 @@ skip_list:
 		if (boot_wait > 20)
 			boot_wait = 3;
 
+		TRACE_BEGIN(TRACE_BOOT_WAIT, boot_wait);
+
 		// Render boot logo.
 		if (bootlogoFound)
 		{
@@ -978,6 +990,8 @@ skip_list:
 			if (render_ticker_logo(boot_wait, h_cfg.backlight))
 				goto out;
 		}
+
+		TRACE_END(TRACE_BOOT_WAIT, 0);
 	}
 
 	if (b_cfg.boot_cfg & BOOT_CFG_FROM_LAUNCH)
@@ -1033,6 +1047,9 @@ out:
 	// L4T: Clear custom boot mode flags from PMC_SCRATCH0.
 	PMC(APBDEV_PMC_SCRATCH0) &= ~PMC_SCRATCH0_MODE_CUSTOM_ALL;
 
+	// Nothing was auto launched. Fall back to Nyx.
+	TRACE_END(TRACE_AUTO_LAUNCH, 1);
+
 	_nyx_load_run();
 }
 
@@ -1452,6 +1469,8 @@ extern void pivot_stack(u32 stack_top);
 
 void ipl_main()
 {
+	u32 ipl_start = get_tmr_us();
+
 	// Do initial HW configuration. This is compatible with consecutive reruns without a reset.
 	hw_init();
 
@@ -1461,6 +1480,11 @@ void ipl_main()
 	// Place heap at a place outside of L4T/HOS configuration and binaries.
 	heap_init((void *)IPL_HEAP_START);
 
+	// Start boot tracing. DRAM is now up.
+	TRACE_INIT((trace_buf_t *)&nyx_str->trace, true);
+	TRACE_BEGIN_TS(TRACE_HW_INIT, 0, ipl_start);
+	TRACE_END(TRACE_HW_INIT, 0);
+
 #ifdef DEBUG_UART_PORT
 	uart_send(DEBUG_UART_PORT, (u8 *)"hekate: Hello!\r\n", 16);
 	uart_wait_xfer(DEBUG_UART_PORT, UART_TX_IDLE);
@@ -1497,8 +1521,10 @@ void ipl_main()
 		h_cfg.errors |= ERR_LIBSYS_LP0;
 
 	// Train DRAM and switch to max frequency.
+	TRACE_BEGIN(TRACE_MINERVA_INIT, 0);
 	if (minerva_init()) //!TODO: Add Tegra210B01 support to minerva.
 		h_cfg.errors |= ERR_LIBSYS_MTC;
+	TRACE_END(TRACE_MINERVA_INIT, 0);
 
 	// Disable watchdog protection.
 	watchdog_end();
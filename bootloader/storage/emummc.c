@@ -23,9 +23,24 @@
 #include "../config.h"
 #include <libs/fatfs/ff.h>
 
+#define EMUMMC_FILE_MAP_BOOT0 0
+#define EMUMMC_FILE_MAP_BOOT1 1
+#define EMUMMC_FILE_MAP_GPP   2
+#define EMUMMC_FILE_MAP_MAX   (EMUMMC_FILE_MAP_GPP + 100)
+#define EMUMMC_FILE_MAP_CLMT_SZ SZ_4K
+
+typedef struct _emummc_file_map_t
+{
+	DWORD *clmt;
+	u32 sectors;
+} emummc_file_map_t;
+
 extern hekate_config h_cfg;
 emummc_cfg_t emu_cfg = { 0 };
 
+static emummc_file_map_t *emu_file_maps = NULL;
+static u32 emu_file_maps_cnt = 0;
+
 void emummc_load_cfg()
 {
 	emu_cfg.enabled = 0;
@@ -132,6 +147,166 @@ static int emummc_raw_get_part_off(int part_idx)
 	return 2;
 }
 
+static void _emummc_file_maps_free()
+{
+	if (!emu_file_maps)
+		return;
+
+	for (u32 i = 0; i < emu_file_maps_cnt; i++)
+		free(emu_file_maps[i].clmt);
+
+	free(emu_file_maps);
+	emu_file_maps = NULL;
+	emu_file_maps_cnt = 0;
+}
+
+static int _emummc_file_map_create(emummc_file_map_t *map, const char *path)
+{
+	FIL fp;
+
+	int res = f_open(&fp, path, FA_READ);
+	if (res)
+		return res;
+
+	// Create cluster link map of the file, so it can be accessed without FatFs.
+	fp.cltbl = (DWORD *)malloc(EMUMMC_FILE_MAP_CLMT_SZ);
+	if (!fp.cltbl)
+	{
+		f_close(&fp);
+
+		return FR_NOT_ENOUGH_CORE;
+	}
+
+	fp.cltbl[0] = EMUMMC_FILE_MAP_CLMT_SZ / sizeof(DWORD);
+	res = f_lseek(&fp, CREATE_LINKMAP);
+	if (res)
+	{
+		free(fp.cltbl);
+		f_close(&fp);
+
+		return res;
+	}
+
+	map->clmt = fp.cltbl;
+	map->sectors = f_size(&fp) >> 9;
+	f_close(&fp);
+
+	return FR_OK;
+}
+
+static void _emummc_file_maps_init()
+{
+	char *path = (char *)malloc(0x200);
+	u32 path_len;
+
+	_emummc_file_maps_free();
+	emu_file_maps = (emummc_file_map_t *)zalloc(sizeof(emummc_file_map_t) * EMUMMC_FILE_MAP_MAX);
+	if (!emu_file_maps)
+	{
+		free(path);
+		return;
+	}
+
+	strcpy(path, emu_cfg.path);
+	strcat(path, "/eMMC/");
+	path_len = strlen(path);
+
+	// Map boot partitions and all rawnand parts.
+	for (u32 i = 0; i < EMUMMC_FILE_MAP_MAX; i++)
+	{
+		if (i == EMUMMC_FILE_MAP_BOOT0)
+			strcpy(path + path_len, "BOOT0");
+		else if (i == EMUMMC_FILE_MAP_BOOT1)
+			strcpy(path + path_len, "BOOT1");
+		else
+		{
+			u32 file_part = i - EMUMMC_FILE_MAP_GPP;
+			path[path_len] = '0';
+			itoa(file_part, path + path_len + (file_part < 10 ? 1 : 0), 10);
+		}
+
+		int res = _emummc_file_map_create(&emu_file_maps[i], path);
+		if (res == FR_NO_FILE && i > EMUMMC_FILE_MAP_GPP)
+			break; // No more rawnand parts.
+
+		// Fall back to FatFs access if any map failed, e.g. CLMT too small for a fragmented part.
+		if (res)
+		{
+			_emummc_file_maps_free();
+			break;
+		}
+
+		emu_file_maps_cnt++;
+	}
+
+	free(path);
+
+	// Fall back to FatFs access if boot partitions or first rawnand part are missing.
+	if (emu_file_maps_cnt <= EMUMMC_FILE_MAP_GPP)
+		_emummc_file_maps_free();
+}
+
+static int _emummc_file_map_rw(u32 sector, u32 num_sectors, void *buf, bool is_write)
+{
+	u8 *pbuf = (u8 *)buf;
+	u32 csize = sd_fs.csize;
+
+	while (num_sectors)
+	{
+		u32 map_idx;
+		u32 file_sector;
+
+		if (!emu_cfg.active_part)
+		{
+			map_idx = EMUMMC_FILE_MAP_GPP + sector / emu_cfg.file_based_part_size;
+			file_sector = sector % emu_cfg.file_based_part_size;
+		}
+		else
+		{
+			map_idx = emu_cfg.active_part == 1 ? EMUMMC_FILE_MAP_BOOT0 : EMUMMC_FILE_MAP_BOOT1;
+			file_sector = sector;
+		}
+
+		if (map_idx >= emu_file_maps_cnt || file_sector >= emu_file_maps[map_idx].sectors)
+			return 0;
+
+		// Find the fragment that holds the sector.
+		DWORD *tbl = emu_file_maps[map_idx].clmt + 1;
+		u32 clst_off = file_sector / csize;
+		u32 ncl;
+		while ((ncl = *tbl++))
+		{
+			if (clst_off < ncl)
+				break;
+
+			clst_off -= ncl;
+			tbl++;
+		}
+		if (!ncl)
+			return 0;
+
+		// Access up to the end of the fragment or file.
+		u32 sct_in_clst = file_sector % csize;
+		u32 lba = sd_fs.database + (*tbl - 2 + clst_off) * csize + sct_in_clst;
+		u32 cnt = MIN(num_sectors, (ncl - clst_off) * csize - sct_in_clst);
+		cnt = MIN(cnt, emu_file_maps[map_idx].sectors - file_sector);
+
+		int res;
+		if (!is_write)
+			res = sdmmc_storage_read(&sd_storage, lba, cnt, pbuf);
+		else
+			res = sdmmc_storage_write(&sd_storage, lba, cnt, pbuf);
+		if (!res)
+			return 0;
+
+		sector      += cnt;
+		num_sectors -= cnt;
+		pbuf        += cnt << 9;
+	}
+
+	return 1;
+}
+
 int emummc_storage_init_mmc()
 {
 	FILINFO fno;
@@ -166,6 +341,8 @@ int emummc_storage_init_mmc()
 			goto out;
 		}
 		emu_cfg.file_based_part_size = fno.fsize >> 9;
+
+		_emummc_file_maps_init();
 	}
 
 	return 0;
@@ -176,6 +353,8 @@ out:
 
 int emummc_storage_end()
 {
+	_emummc_file_maps_free();
+
 	if (!emu_cfg.enabled || h_cfg.emummc_force_disable)
 		emmc_end();
 	else
@@ -195,6 +374,8 @@ int emummc_storage_read(u32 sector, u32 num_sectors, void *buf)
 		sector += emummc_raw_get_part_off(emu_cfg.active_part) * 0x2000;
 		return sdmmc_storage_read(&sd_storage, sector, num_sectors, buf);
 	}
+	else if (emu_file_maps)
+		return _emummc_file_map_rw(sector, num_sectors, buf, false);
 	else
 	{
 		if (!emu_cfg.active_part)
@@ -240,6 +421,8 @@ int emummc_storage_write(u32 sector, u32 num_sectors, void *buf)
 		sector += emummc_raw_get_part_off(emu_cfg.active_part) * 0x2000;
 		return sdmmc_storage_write(&sd_storage, sector, num_sectors, buf);
 	}
+	else if (emu_file_maps)
+		return _emummc_file_map_rw(sector, num_sectors, buf, true);
 	else
 	{
 		if (!emu_cfg.active_part)
@@ -21,7 +21,11 @@
 #include "payload_01.h"
 
 #include <memory_map.h>
+#ifdef LDR_COMPR_LZ4
+#include <libs/compr/lz4.h>
+#else
 #include <libs/compr/lz.h>
+#endif
 #include <soc/clock.h>
 #include <soc/t210.h>
 
@@ -29,6 +33,11 @@
 #define IPL_RELOC_TOP  0x40038000
 #define IPL_PATCHED_RELOC_SZ 0x94
 
+// Uncompressed payload size, split in half by the lz77 tool. Only used to bound LZ4 output.
+#ifndef IPL_UNC_SIZE
+#define IPL_UNC_SIZE 0
+#endif
+
 boot_cfg_t __attribute__((section ("._boot_cfg"))) b_cfg;
 const volatile ipl_ver_meta_t __attribute__((section ("._ipl_version"))) ipl_ver = {
 	.magic = BL_MAGIC,
@@ -57,6 +66,18 @@ const char __attribute__((section ("._octopus"))) octopus[] =
 	"      `--'`   ) )    .-'.'      '.'.  | (\n"
 	"             (/`    ( (`          ) )  '-;   [switchbrew]\n";
 
+static u32 _payload_uncompress(const u8 *src, u8 *dst, u32 size, u32 dst_size)
+{
+#ifdef LDR_COMPR_LZ4
+	int res = LZ4_decompress_safe((const char *)src, (char *)dst, size, dst_size);
+
+	return res > 0 ? res : 0;
+#else
+	(void)dst_size;
+	return LZ_Uncompress(src, dst, size);
+#endif
+}
+
 void loader_main()
 {
 	// Preliminary BPMP clocks init.
@@ -94,12 +115,12 @@ void loader_main()
 	// Set source address of the first part.
 	u8 *src_addr = (void *)(IPL_RELOC_TOP - payload_size);
 	// Uncompress first part.
-	u32 dst_pos = LZ_Uncompress((const u8 *)src_addr, (u8 *)IPL_LOAD_ADDR, sizeof(payload_00));
+	u32 dst_pos = _payload_uncompress((const u8 *)src_addr, (u8 *)IPL_LOAD_ADDR, sizeof(payload_00), IPL_UNC_SIZE / 2);
 
 	// Set source address of the second part. Includes compiler alignment.
 	src_addr += (u32)payload_01 - (u32)payload_00;
 	// Uncompress second part.
-	LZ_Uncompress((const u8 *)src_addr, (u8 *)IPL_LOAD_ADDR + dst_pos, sizeof(payload_01));
+	_payload_uncompress((const u8 *)src_addr, (u8 *)IPL_LOAD_ADDR + dst_pos, sizeof(payload_01), IPL_UNC_SIZE - (IPL_UNC_SIZE / 2));
 
 	// Copy over boot configuration storage.
 	memcpy((u8 *)(IPL_LOAD_ADDR + IPL_PATCHED_RELOC_SZ), &b_cfg, sizeof(boot_cfg_t));
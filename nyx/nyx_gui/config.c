@@ -60,6 +60,9 @@ void set_nyx_default_configuration()
 	n_cfg.jc_disable     = 0;
 	n_cfg.jc_force_right = 0;
 	n_cfg.bpmp_clock     = 0;
+	n_cfg.sparse_backup  = 0;
+	n_cfg.compress_backup = 0;
+	n_cfg.ums_write_cache = 0;
 }
 
 int create_config_entry()
@@ -242,6 +245,18 @@ int create_nyx_config_entry(bool force_unmount)
 	itoa(n_cfg.bpmp_clock, lbuf, 10);
 	f_puts(lbuf, &fp);
 
+	f_puts("\nsparsebackup=", &fp);
+	itoa(n_cfg.sparse_backup, lbuf, 10);
+	f_puts(lbuf, &fp);
+
+	f_puts("\ncompressbackup=", &fp);
+	itoa(n_cfg.compress_backup, lbuf, 10);
+	f_puts(lbuf, &fp);
+
+	f_puts("\numswritecache=", &fp);
+	itoa(n_cfg.ums_write_cache, lbuf, 10);
+	f_puts(lbuf, &fp);
+
 	f_puts("\n", &fp);
 
 	f_close(&fp);
@@ -54,6 +54,9 @@ typedef struct _nyx_config
 	u32 jc_disable;
 	u32 jc_force_right;
 	u32 bpmp_clock;
+	u32 sparse_backup;
+	u32 compress_backup;
+	u32 ums_write_cache;
 } nyx_config;
 
 void set_default_configuration();
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2018-2024 CTCaer
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <utils/sprintf.h>
+#include <utils/types.h>
+
+#include "fe_bench.h"
+
+// Read tests run on the raw storage. Sequential tests wrap inside the span.
+const bench_test_t bench_read_suite[] = {
+	{ "Seq 16MiB Read",  BENCH_OP_READ,  false, false, 0x8000, 0x200000 }, // 1GB.
+	{ "Seq 4KiB Read",   BENCH_OP_READ,  false, false, 8,      0x100000 }, // 512MB.
+	{ "Rand 4KiB Read",  BENCH_OP_READ,  true,  false, 8,      0x100000 }, // 512MB.
+	{ "Rand 64KiB Read", BENCH_OP_READ,  true,  false, 128,    0x100000 }, // 512MB.
+	{ "Seq 4MiB Sync",   BENCH_OP_READ,  false, false, 0x2000, 0x80000, BENCH_IO_SYNC  }, // 256MB.
+	{ "Seq 4MiB Async",  BENCH_OP_READ,  false, false, 0x2000, 0x80000, BENCH_IO_ASYNC }, // 256MB.
+};
+const u32 bench_read_suite_cnt = sizeof(bench_read_suite) / sizeof(bench_test_t);
+
+// Write tests must only target scratch space.
+const bench_test_t bench_write_suite[] = {
+	{ "Seq AU Write",     BENCH_OP_WRITE, false, true,  0x2000, 0x80000 }, // 256MB in 4MB blocks.
+	{ "Rand 4KiB Write",  BENCH_OP_WRITE, true,  false, 8,      0x8000  }, // 16MB.
+	{ "Rand 64KiB Write", BENCH_OP_WRITE, true,  false, 128,    0x20000 }, // 64MB.
+	{ "Mixed 4KiB 70/30", BENCH_OP_MIXED, true,  false, 8,      0x8000  }, // 16MB.
+};
+const u32 bench_write_suite_cnt = sizeof(bench_write_suite) / sizeof(bench_test_t);
+
+static u32 _bench_hist_bin(u32 lat)
+{
+	if (lat < BIT(BENCH_HIST_SUB_BITS))
+		return lat;
+
+	u32 msb = 31 - __builtin_clz(lat);
+	u32 sub = (lat >> (msb - BENCH_HIST_SUB_BITS)) & (BIT(BENCH_HIST_SUB_BITS) - 1);
+
+	return ((msb - BENCH_HIST_SUB_BITS + 1) << BENCH_HIST_SUB_BITS) | sub;
+}
+
+static u32 _bench_hist_bin_max(u32 bin)
+{
+	if (bin < BIT(BENCH_HIST_SUB_BITS))
+		return bin;
+
+	u32 shift = (bin >> BENCH_HIST_SUB_BITS) - 1;
+	u32 base  = (BIT(BENCH_HIST_SUB_BITS) | (bin & (BIT(BENCH_HIST_SUB_BITS) - 1))) << shift;
+
+	return base + BIT(shift) - 1;
+}
+
+u32 bench_hist_percentile(const bench_result_t *res, u32 permille)
+{
+	if (!res->ops)
+		return 0;
+
+	u32 target = ((u64)res->ops * permille + 999) / 1000;
+	u32 count = 0;
+
+	for (u32 bin = 0; bin < BENCH_HIST_BINS; bin++)
+	{
+		count += res->hist[bin];
+		if (count >= target)
+			return MIN(_bench_hist_bin_max(bin), res->lat_max_us);
+	}
+
+	return res->lat_max_us;
+}
+
+// Keeps the checksum from being optimized out.
+static volatile u32 _bench_sum;
+
+static u32 _bench_checksum(const u32 *buf, u32 num_sectors)
+{
+	u32 sum = 0;
+	for (u32 i = 0; i < num_sectors * 512 / sizeof(u32); i++)
+		sum += buf[i];
+
+	return sum;
+}
+
+static u32 _bench_sector(bench_io_t *io, const bench_test_t *test, u32 base, u32 slots, u32 align, u32 seq_slots, u32 op_idx)
+{
+	if (test->random)
+		return base + (io->rand(io->ctx) % slots) * align;
+
+	return base + (op_idx % seq_slots) * test->block_sct;
+}
+
+int bench_run(bench_io_t *io, const bench_test_t *test, u32 offset, u32 span, bench_result_t *res)
+{
+	u32 block = test->block_sct;
+	u32 align = (test->au_align && io->au_sct) ? io->au_sct : block;
+
+	memset(res, 0, sizeof(bench_result_t));
+	res->name       = test->name;
+	res->op         = test->op;
+	res->offset     = offset;
+	res->block_sct  = block;
+	res->lat_min_us = 0xFFFFFFFF;
+
+	// Checksum modes double buffer, so the next block can be read while the current one is checksummed.
+	bool async = test->io_mode == BENCH_IO_ASYNC;
+	u32 buf_sct = test->io_mode != BENCH_IO_PLAIN ? io->buf_sct / 2 : io->buf_sct;
+	if (async && (test->op != BENCH_OP_READ || !io->read_async || !io->wait))
+		return BENCH_ERR_IO;
+
+	// Align the first I/O on the physical sector.
+	u32 adj = (align - (io->lba_base + offset) % align) % align;
+	if (block > buf_sct || span < adj + block)
+		return BENCH_ERR_IO;
+
+	u32 slots = (span - adj - block) / align + 1; // Aligned I/O start positions.
+	u32 seq_slots = (span - adj) / block;         // Sequential blocks before wrapping.
+	u32 ops = test->total_sct / block;
+
+	// Fill write data with noise so controllers can't compress it.
+	if (test->op != BENCH_OP_READ)
+		for (u32 i = 0; i < block * 512 / sizeof(u32); i++)
+			((u32 *)io->buf)[i] = io->rand(io->ctx);
+
+	u32 sum = 0;
+	u32 buf_idx = 0;
+	bool pending = false;
+	u32 next = _bench_sector(io, test, offset + adj, slots, align, seq_slots, 0);
+	for (u32 op_idx = 0; op_idx < ops; op_idx++)
+	{
+		u8 *buf = io->buf + buf_idx * buf_sct * 512;
+		u32 sector = next;
+		if (op_idx + 1 < ops)
+			next = _bench_sector(io, test, offset + adj, slots, align, seq_slots, op_idx + 1);
+
+		bool write = test->op == BENCH_OP_WRITE || (test->op == BENCH_OP_MIXED && (io->rand(io->ctx) % 10) < 3);
+
+		// Latency of checksum modes is the time per block, including the checksum.
+		u32 lat = io->get_us();
+		int ok;
+		if (async)
+		{
+			// First block is not prefetched.
+			ok = pending ? io->wait(io->ctx) : io->read(io->ctx, sector, block, buf);
+			pending = false;
+
+			// Read next block in the background while current one is checksummed.
+			if (ok && op_idx + 1 < ops)
+			{
+				ok = io->read_async(io->ctx, next, block, io->buf + (buf_idx ^ 1) * buf_sct * 512);
+				pending = ok;
+			}
+		}
+		else
+			ok = write ? io->write(io->ctx, sector, block, buf) : io->read(io->ctx, sector, block, buf);
+
+		if (ok && test->io_mode != BENCH_IO_PLAIN)
+		{
+			sum += _bench_checksum((const u32 *)buf, block);
+			buf_idx ^= 1;
+		}
+		lat = io->get_us() - lat;
+
+		if (!ok)
+			return BENCH_ERR_IO;
+
+		res->time_us += lat;
+		res->ops++;
+		res->sectors += block;
+		res->hist[_bench_hist_bin(lat)]++;
+		res->lat_min_us = MIN(res->lat_min_us, lat);
+		res->lat_max_us = MAX(res->lat_max_us, lat);
+
+		if (io->progress && io->progress(io->ctx, (op_idx + 1) * 100 / ops))
+		{
+			if (pending)
+				io->wait(io->ctx);
+
+			return BENCH_ERR_ABORT;
+		}
+	}
+	_bench_sum = sum;
+
+	if (res->time_us)
+	{
+		res->rate_kibs = (u64)res->sectors * 1000000 / 2 / res->time_us;
+		res->iops      = (u64)res->ops * 1000000 / res->time_us;
+	}
+	res->lat_p50_us = bench_hist_percentile(res, 500);
+	res->lat_p99_us = bench_hist_percentile(res, 990);
+
+	return 0;
+}
+
+static const char *_bench_op_name(u32 op)
+{
+	switch (op)
+	{
+	case BENCH_OP_WRITE:
+		return "write";
+	case BENCH_OP_MIXED:
+		return "mixed";
+	default:
+		return "read";
+	}
+}
+
+void bench_export_csv(char *out, const char *storage, const bench_result_t *res, u32 count)
+{
+	strcpy(out, "storage,test,op,offset,block_bytes,ops,bytes,time_us,rate_kibs,iops,"
+		"lat_min_us,lat_p50_us,lat_p99_us,lat_max_us\n");
+
+	for (u32 i = 0; i < count; i++, res++)
+	{
+		s_printf(out + strlen(out), "%s,%s,%s,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n",
+			storage, res->name, _bench_op_name(res->op), res->offset, res->block_sct * 512,
+			res->ops, res->sectors * 512, (u32)res->time_us, res->rate_kibs, res->iops,
+			res->lat_min_us, res->lat_p50_us, res->lat_p99_us, res->lat_max_us);
+	}
+}
+
+void bench_export_json(char *out, const char *storage, const char *id, const bench_result_t *res, u32 count)
+{
+	s_printf(out, "{\n  \"storage\": \"%s\",\n  \"id\": \"%s\",\n  \"results\": [\n", storage, id);
+
+	for (u32 i = 0; i < count; i++, res++)
+	{
+		s_printf(out + strlen(out),
+			"    { \"test\": \"%s\", \"op\": \"%s\", \"offset\": %d, \"block_bytes\": %d,"
+			" \"ops\": %d, \"bytes\": %d, \"time_us\": %d, \"rate_kibs\": %d, \"iops\": %d,"
+			" \"lat_us\": { \"min\": %d, \"p50\": %d, \"p99\": %d, \"max\": %d }, \"hist\": [",
+			res->name, _bench_op_name(res->op), res->offset, res->block_sct * 512,
+			res->ops, res->sectors * 512, (u32)res->time_us, res->rate_kibs, res->iops,
+			res->lat_min_us, res->lat_p50_us, res->lat_p99_us, res->lat_max_us);
+
+		// Sparse histogram as [max_us, count] pairs.
+		bool first = true;
+		for (u32 bin = 0; bin < BENCH_HIST_BINS; bin++)
+		{
+			if (!res->hist[bin])
+				continue;
+
+			s_printf(out + strlen(out), "%s[%d, %d]", first ? "" : ", ", _bench_hist_bin_max(bin), res->hist[bin]);
+			first = false;
+		}
+
+		s_printf(out + strlen(out), "] }%s\n", (i + 1 < count) ? "," : "");
+	}
+
+	strcat(out, "  ]\n}\n");
+}
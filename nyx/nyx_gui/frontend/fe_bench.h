@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2018-2024 CTCaer
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FE_BENCH_H_
+#define _FE_BENCH_H_
+
+#include <utils/types.h>
+
+// Latency histogram. Exact under 8 us, then 8 bins per power of 2 (12.5% resolution).
+#define BENCH_HIST_SUB_BITS 3
+#define BENCH_HIST_BINS     (32 << BENCH_HIST_SUB_BITS)
+
+#define BENCH_ERR_IO    1
+#define BENCH_ERR_ABORT -1
+
+typedef enum _bench_op_t
+{
+	BENCH_OP_READ  = 0,
+	BENCH_OP_WRITE = 1,
+	BENCH_OP_MIXED = 2  // 70% reads, 30% writes.
+} bench_op_t;
+
+typedef enum _bench_io_mode_t
+{
+	BENCH_IO_PLAIN = 0,
+	BENCH_IO_SYNC  = 1, // Checksum each block after it's read.
+	BENCH_IO_ASYNC = 2  // Checksum each block while the next one is read. Reads only.
+} bench_io_mode_t;
+
+typedef struct _bench_test_t
+{
+	const char *name;
+	u32  op;
+	bool random;
+	bool au_align;  // Align to the SD allocation unit instead of the block size.
+	u32  block_sct; // Sectors per I/O.
+	u32  total_sct; // Sectors transferred in total.
+	u32  io_mode;
+} bench_test_t;
+
+typedef struct _bench_result_t
+{
+	const char *name;
+	u32 op;
+	u32 offset;    // First sector of the tested area.
+	u32 block_sct;
+	u32 ops;
+	u32 sectors;
+	u64 time_us;   // Time spent in I/O only.
+	u32 rate_kibs;
+	u32 iops;
+	u32 lat_min_us;
+	u32 lat_p50_us;
+	u32 lat_p99_us;
+	u32 lat_max_us;
+	u32 hist[BENCH_HIST_BINS];
+} bench_result_t;
+
+typedef struct _bench_io_t
+{
+	void *ctx;
+	int  (*read)(void *ctx, u32 sector, u32 num_sectors, void *buf);  // 1 on success.
+	int  (*write)(void *ctx, u32 sector, u32 num_sectors, void *buf); // 1 on success.
+	int  (*read_async)(void *ctx, u32 sector, u32 num_sectors, void *buf); // 1 on success. Optional.
+	int  (*wait)(void *ctx); // Waits for the pending async read. 1 on success.
+	u32  (*rand)(void *ctx);
+	int  (*progress)(void *ctx, u32 pct); // Non zero aborts.
+	u32  (*get_us)();
+	u8  *buf;
+	u32  buf_sct;  // Must fit the biggest block. Twice that for checksum modes.
+	u32  lba_base; // Physical sector of sector 0. Used for alignment.
+	u32  au_sct;   // SD allocation unit in sectors. 0 if unknown.
+} bench_io_t;
+
+extern const bench_test_t bench_read_suite[];
+extern const u32 bench_read_suite_cnt;
+extern const bench_test_t bench_write_suite[];
+extern const u32 bench_write_suite_cnt;
+
+int  bench_run(bench_io_t *io, const bench_test_t *test, u32 offset, u32 span, bench_result_t *res);
+u32  bench_hist_percentile(const bench_result_t *res, u32 permille);
+void bench_export_csv(char *out, const char *storage, const bench_result_t *res, u32 count);
+void bench_export_json(char *out, const char *storage, const char *id, const bench_result_t *res, u32 count);
+
+#endif
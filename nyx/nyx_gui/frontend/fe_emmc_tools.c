@@ -27,12 +27,60 @@
 #include "fe_emmc_tools.h"
 #include "fe_emummc_tools.h"
 #include "../config.h"
+#include "../hos/hos.h"
+#include <libs/compr/lz4.h>
 #include <libs/fatfs/ff.h>
 
 #define NUM_SECTORS_PER_ITER 8192 // 4MB Cache.
 #define OUT_FILENAME_SZ 128
 #define HASH_FILENAME_SZ (OUT_FILENAME_SZ + 11) // 11 == strlen(".sha256sums")
 
+#define SPARSE_MAGIC     0x5053584E // "NXSP".
+#define SPARSE_VERSION   1
+#define SPARSE_GAP_MERGE 0x800 // Merge allocated runs with gaps up to 1MB.
+
+typedef struct _sparse_extent_t
+{
+	u32 lba;     // Partition relative.
+	u32 sectors;
+} sparse_extent_t;
+
+typedef struct _sparse_hdr_t
+{
+	u32 magic;
+	u32 version;
+	u32 total_sectors; // Partition size.
+	u32 data_sectors;
+	u32 num_extents;   // Extent table follows header.
+	u32 data_offset;   // Extent data start in sectors.
+	u8  rsvd[0x1E8];
+} sparse_hdr_t;
+
+#define LZ4B_MAGIC       0x5A4C584E // "NXLZ".
+#define LZ4B_VERSION     1
+#define LZ4B_EXT         ".nxlz"
+#define LZ4B_CBUF_OFFSET (2 * NUM_SECTORS_PER_ITER * EMMC_BLOCKSIZE) // Fits LZ4_COMPRESSBOUND(4MB).
+
+typedef struct _lz4_blk_t
+{
+	u64 offset;  // Byte offset in file.
+	u32 size;    // Stored size. Equal to raw size if uncompressed.
+	u32 sectors; // Raw size.
+	u8  sha256[SE_SHA_256_SIZE]; // Hash of raw data.
+} lz4_blk_t;
+
+typedef struct _lz4_hdr_t
+{
+	u32 magic;
+	u32 version;
+	u32 total_sectors; // Partition size.
+	u32 blk_sectors;
+	u32 num_blocks;
+	u32 index_offset;  // Block index start in sectors.
+	u32 data_offset;   // Block data start in sectors.
+	u8  rsvd[0x1E4];
+} lz4_hdr_t;
+
 extern nyx_config n_cfg;
 
 extern char *emmcsn_path_impl(char *path, char *sub_dir, char *filename, sdmmc_storage_t *storage);
@@ -137,27 +185,29 @@ static void _update_filename(char *outFilename, u32 sdPathLen, u32 currPartIdx)
 		itoa(currPartIdx, &outFilename[sdPathLen], 10);
 }
 
-static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32 lba_curr, const char *outFilename, const emmc_part_t *part)
+static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32 lba_curr, const char *outFilename, const emmc_part_t *part, const u8 *inline_hashes)
 {
 	FIL fp;
 	FIL hashFp;
 	u8 sparseShouldVerify = 4;
 	u32 prevPct = 200;
 	u32 sdFileSector = 0;
+	u32 chunk = 0;
 	int res = 0;
 	static const char hexa[] = "0123456789abcdef";
 	DWORD *clmt = NULL;
+	bool hash_file = n_cfg.verification == 3 || inline_hashes;
 
 	u8 hashEm[SE_SHA_256_SIZE];
 	u8 hashSd[SE_SHA_256_SIZE];
 
 	if (f_open(&fp, outFilename, FA_READ) == FR_OK)
 	{
-		if (n_cfg.verification == 3)
+		if (hash_file)
 		{
 			char hashFilename[HASH_FILENAME_SZ];
 			strncpy(hashFilename, outFilename, OUT_FILENAME_SZ - 1);
-			strcat(hashFilename, ".sha256sums");
+			strcat(hashFilename, inline_hashes ? ".sha256" : ".sha256sums");
 
 			res = f_open(&hashFp, hashFilename, FA_CREATE_ALWAYS | FA_WRITE);
 			if (res)
@@ -184,8 +234,11 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 
 		u32 totalSectorsVer = (u32)((u64)f_size(&fp) >> (u64)9);
 
-		u8 *bufEm = (u8 *)EMMC_BUF_ALIGNED;
+		// Use 2 eMMC buffers, so the next chunk is read while the current one is hashed and compared.
+		u8 *bufEms[2] = { (u8 *)EMMC_BUF_ALIGNED, (u8 *)EMMC_BUF_ALIGNED + NUM_SECTORS_PER_ITER * EMMC_BLOCKSIZE };
 		u8 *bufSd = (u8 *)SDXC_BUF_ALIGNED;
+		u32 buf_idx = 0;
+		sdmmc_storage_async_t *read_req = NULL;
 
 		u32 pct = (u64)((u64)(lba_curr - part->lba_start) * 100u) / (u64)(part->lba_end - part->lba_start);
 		lv_bar_set_value(gui->bar, pct);
@@ -205,29 +258,51 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 			// Check every time or every 4.
 			// Every 4 protects from fake sd, sector corruption and frequent I/O corruption.
 			// Full provides all that, plus protection from extremely rare I/O corruption.
-			if ((n_cfg.verification >= 2) || !(sparseShouldVerify % 4))
+			// Inline verification has the eMMC hashes of all chunks from the backup pass.
+			if (inline_hashes || (n_cfg.verification >= 2) || !(sparseShouldVerify % 4))
 			{
-				if (!sdmmc_storage_read(storage, lba_curr, num, bufEm))
+				if (inline_hashes)
+					memcpy(hashEm, inline_hashes + chunk * SE_SHA_256_SIZE, SE_SHA_256_SIZE);
+				else
 				{
-					s_printf(gui->txt_buf,
-						"\n#FF0000 Failed to read %d blocks (@LBA %08X),#\n"
-						"#FF0000 from eMMC! Verification failed..#\n",
-						num, lba_curr);
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
-					manual_system_maintenance(true);
+					u8 *bufEm = bufEms[buf_idx];
 
-					free(clmt);
-					f_close(&fp);
-					if (n_cfg.verification == 3)
-						f_close(&hashFp);
+					int res_read;
+					if (read_req)
+						res_read = sdmmc_storage_async_wait(read_req);
+					else
+						res_read = sdmmc_storage_read(storage, lba_curr, num, bufEm);
+					read_req = NULL;
 
-					return 1;
+					if (!res_read)
+					{
+						s_printf(gui->txt_buf,
+							"\n#FF0000 Failed to read %d blocks (@LBA %08X),#\n"
+							"#FF0000 from eMMC! Verification failed..#\n",
+							num, lba_curr);
+						lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+						manual_system_maintenance(true);
+
+						res = 1;
+						goto out;
+					}
+					manual_system_maintenance(false);
+
+					// Hash eMMC chunk in the background.
+					se_calc_sha256(hashEm, NULL, bufEm, num << 9, 0, SHA_INIT_HASH, false);
+
+					// Start reading the next chunk to be verified, while the SD one is read.
+					u32 num_next = MIN(totalSectorsVer - num, NUM_SECTORS_PER_ITER);
+					if (num_next && ((n_cfg.verification >= 2) || !((sparseShouldVerify + 1) % 4)))
+						read_req = sdmmc_storage_read_async(storage, lba_curr + num, num_next, bufEms[buf_idx ^ 1]);
+					buf_idx ^= 1;
 				}
-				manual_system_maintenance(false);
-				se_calc_sha256(hashEm, NULL, bufEm, num << 9, 0, SHA_INIT_HASH, false);
 
 				f_lseek(&fp, (u64)sdFileSector << (u64)9);
-				if (f_read_fast(&fp, bufSd, num << 9))
+				res = f_read_fast(&fp, bufSd, num << 9);
+				if (!inline_hashes)
+					se_calc_sha256_finalize(hashEm, NULL);
+				if (res)
 				{
 					s_printf(gui->txt_buf,
 						"\n#FF0000 Failed to read %d blocks (@LBA %08X),#\n"
@@ -236,15 +311,10 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
 					manual_system_maintenance(true);
 
-					free(clmt);
-					f_close(&fp);
-					if (n_cfg.verification == 3)
-						f_close(&hashFp);
-
-					return 1;
+					res = 1;
+					goto out;
 				}
 				manual_system_maintenance(false);
-				se_calc_sha256_finalize(hashEm, NULL);
 				se_calc_sha256_oneshot(hashSd, bufSd, num << 9);
 				res = memcmp(hashEm, hashSd, SE_SHA_256_SIZE / 2);
 
@@ -257,15 +327,11 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
 					manual_system_maintenance(true);
 
-					free(clmt);
-					f_close(&fp);
-					if (n_cfg.verification == 3)
-						f_close(&hashFp);
-
-					return 1;
+					res = 1;
+					goto out;
 				}
 
-				if (n_cfg.verification == 3)
+				if (hash_file)
 				{
 					// Transform computed hash to readable hexadecimal
 					char hashStr[SE_SHA_256_SIZE * 2 + 1];
@@ -298,6 +364,7 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 			totalSectorsVer -= num;
 			sdFileSector += num;
 			sparseShouldVerify++;
+			chunk++;
 
 			// Check for cancellation combo.
 			if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
@@ -308,23 +375,28 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 
 				msleep(1000);
 
-				free(clmt);
-				f_close(&fp);
-				f_close(&hashFp);
-
-				return 0;
+				res = 0;
+				goto out;
 			}
 		}
-		free(clmt);
-		f_close(&fp);
-		f_close(&hashFp);
 
 		lv_bar_set_value(gui->bar, pct);
 		s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
 		lv_label_set_text(gui->label_pct, gui->txt_buf);
 		manual_system_maintenance(true);
 
-		return 0;
+		res = 0;
+
+out:
+		if (read_req)
+			sdmmc_storage_async_wait(read_req);
+
+		free(clmt);
+		f_close(&fp);
+		if (hash_file)
+			f_close(&hashFp);
+
+		return res;
 	}
 	else
 	{
@@ -338,58 +410,130 @@ static int _dump_emmc_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, u32
 
 bool partial_sd_full_unmount = false;
 
-static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part, sdmmc_storage_t *storage, emmc_part_t *part)
+static int _lz4_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, const char *filename, const emmc_part_t *part,
+	const lz4_blk_t *index, u32 num_blocks, bool from_emmc)
 {
-	static const u32 FAT32_FILESIZE_LIMIT = 0xFFFFFFFF;
-	static const u32 SECTORS_TO_MIB_COEFF = 11;
-
-	partial_sd_full_unmount = false;
-
-	u32 multipartSplitSize = (1u << 31);
-	u32 lba_end = part->lba_end;
-	u32 totalSectors = part->lba_end - part->lba_start + 1;
-	u32 currPartIdx = 0;
-	u32 numSplitParts = 0;
-	u32 maxSplitParts = 0;
-	bool isSmallSdCard = false;
-	bool partialDumpInProgress = false;
+	FIL fp;
 	int res = 0;
-	char *outFilename = sd_path;
-	u32 sdPathLen = strlen(sd_path);
+	u32 prevPct = 200;
+	u8 hash[SE_SHA_256_SIZE];
+	u8 *buf  = (u8 *)MIXD_BUF_ALIGNED;
+	u8 *cbuf = (u8 *)MIXD_BUF_ALIGNED + LZ4B_CBUF_OFFSET;
 
-	u32 sector_start = 0, part_idx = 0;
-	u32 sector_size = totalSectors;
-	u32 sd_sector_off = 0;
+	if (!from_emmc && f_open(&fp, filename, FA_READ))
+	{
+		s_printf(gui->txt_buf, "\n#FFDD00 File not found or could not be loaded!#\n#FFDD00 Verification failed..#\n");
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
 
-	FIL partialIdxFp;
-	char partialIdxFilename[12];
-	strcpy(partialIdxFilename, "partial.idx");
+		return 1;
+	}
 
-	if (gui->raw_emummc)
+	lv_bar_set_value(gui->bar, 0);
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_BG, gui->bar_teal_bg);
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_INDIC, gui->bar_teal_ind);
+	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 0%");
+	manual_system_maintenance(true);
+
+	for (u32 i = 0; i < num_blocks; i++)
 	{
-		_get_valid_partition(&sector_start, &sector_size, &part_idx, true);
-		if (!part_idx || !sector_size)
+		u32 lba = part->lba_start + i * NUM_SECTORS_PER_ITER;
+		u32 raw_size = index[i].sectors << 9;
+
+		if (from_emmc)
 		{
-			s_printf(gui->txt_buf, "\n#FFDD00 Failed to find a partition...#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			if (!sdmmc_storage_read(storage, lba, index[i].sectors, buf))
+			{
+				s_printf(gui->txt_buf,
+					"\n#FF0000 Failed to read %d blocks (@LBA %08X),#\n"
+					"#FF0000 from eMMC! Verification failed..#\n",
+					index[i].sectors, lba);
+				res = 1;
+				break;
+			}
+		}
+		else
+		{
+			// Uncompressed blocks are stored as is.
+			u8 *dst = index[i].size == raw_size ? buf : cbuf;
+			if (f_lseek(&fp, index[i].offset) || f_read(&fp, dst, index[i].size, NULL) ||
+				(dst == cbuf && LZ4_decompress_safe((const char *)cbuf, (char *)buf, index[i].size, raw_size) != (int)raw_size))
+			{
+				s_printf(gui->txt_buf,
+					"\n#FF0000 Failed to read %d blocks (@LBA %08X),#\n"
+					"#FF0000 from SD card! Verification failed..#\n",
+					index[i].sectors, lba);
+				res = 1;
+				break;
+			}
+		}
+
+		se_calc_sha256_oneshot(hash, buf, raw_size);
+		if (memcmp(hash, index[i].sha256, SE_SHA_256_SIZE))
+		{
+			s_printf(gui->txt_buf, "\n#FF0000 Hash mismatch (@LBA %08X)!#\n#FF0000 Verification failed..#\n", lba);
+			res = 1;
+			break;
+		}
+
+		u32 pct = (u64)((u64)(i + 1) * 100u) / (u64)num_blocks;
+		if (pct != prevPct)
+		{
+			lv_bar_set_value(gui->bar, pct);
+			s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
+			lv_label_set_text(gui->label_pct, gui->txt_buf);
 			manual_system_maintenance(true);
 
-			return 0;
+			prevPct = pct;
 		}
-		sd_sector_off = sector_start + (0x2000 * active_part);
-		if (active_part == 2)
+
+		// Check for cancellation combo.
+		if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
 		{
-			// Set new total sectors and lba end sector for percentage calculations.
-			totalSectors = sector_size;
-			lba_end = sector_size + part->lba_start - 1;
+			s_printf(gui->txt_buf, "#FFDD00 Verification was cancelled!#\n");
+			res = 1;
+			msleep(1000);
+			break;
 		}
 	}
 
-	s_printf(gui->txt_buf, "#96FF00 SD Card free space:# %d MiB\n#96FF00 Total backup size:# %d MiB\n\n",
+	if (res)
+	{
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+	}
+
+	if (!from_emmc)
+		f_close(&fp);
+
+	return res;
+}
+
+static int _dump_emmc_part_lz4(emmc_tool_gui_t *gui, char *sd_path, sdmmc_storage_t *storage, emmc_part_t *part)
+{
+	static const u32 FAT32_FILESIZE_LIMIT = 0xFFFFFFFF;
+	static const u32 SECTORS_TO_MIB_COEFF = 11;
+
+	u32 totalSectors = part->lba_end - part->lba_start + 1;
+	u32 num_blocks = (totalSectors + NUM_SECTORS_PER_ITER - 1) / NUM_SECTORS_PER_ITER;
+	u32 index_sectors = (num_blocks * sizeof(lz4_blk_t) + EMMC_BLOCKSIZE - 1) / EMMC_BLOCKSIZE;
+	u32 data_offset = 1 + index_sectors;
+	int res = 0;
+
+	// Incompressible blocks are stored raw. If the worst case can't fit in a FAT32 file, use the split raw backup.
+	if (sd_fs.fs_type != FS_EXFAT && (((u64)totalSectors + data_offset) << 9) > FAT32_FILESIZE_LIMIT)
+	{
+		s_printf(gui->txt_buf, "\n#FFDD00 Compressed backup may exceed 4GB on FAT32.#\n#FFDD00 Using split raw backup...#\n");
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		return -1;
+	}
+
+	s_printf(gui->txt_buf, "#96FF00 SD Card free space:# %d MiB\n#96FF00 Total backup size:# %d MiB (LZ4)\n\n",
 		(u32)(sd_fs.free_clst * sd_fs.csize >> SECTORS_TO_MIB_COEFF),
 		totalSectors >> SECTORS_TO_MIB_COEFF);
 	lv_label_ins_text(gui->label_info, LV_LABEL_POS_LAST, gui->txt_buf);
-	manual_system_maintenance(true);
 
 	lv_bar_set_value(gui->bar, 0);
 	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 0%");
@@ -397,74 +541,36 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 	lv_bar_set_style(gui->bar, LV_BAR_STYLE_INDIC, gui->bar_white_ind);
 	manual_system_maintenance(true);
 
-	// 1GB parts for sd cards 8GB and less.
-	if ((sd_storage.csd.capacity >> (20 - sd_storage.csd.read_blkbits)) <= 8192)
-		multipartSplitSize = (1u << 30);
-	// Maximum parts fitting the free space available.
-	maxSplitParts = (sd_fs.free_clst * sd_fs.csize) / (multipartSplitSize / EMMC_BLOCKSIZE);
-
-	// Check if the USER partition or the RAW eMMC fits the sd card free space.
-	if (totalSectors > (sd_fs.free_clst * sd_fs.csize))
+	// Header and block index must always fit.
+	u32 free_sectors = sd_fs.free_clst * sd_fs.csize;
+	if (data_offset > free_sectors)
 	{
-		isSmallSdCard = true;
-
-		s_printf(gui->txt_buf, "\n#FFBA00 Free space is smaller than backup size.#\n");
+		s_printf(gui->txt_buf, "\n#FFDD00 Not enough free space for backup!#\n");
 		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
 		manual_system_maintenance(true);
 
-		if (!maxSplitParts)
-		{
-			s_printf(gui->txt_buf, "#FFDD00 Not enough free space for Partial Backup!#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
-			manual_system_maintenance(true);
-
-			return 0;
-		}
+		return 0;
 	}
-	// Check if we are continuing a previous raw eMMC or USER partition backup in progress.
-	if (f_open(&partialIdxFp, partialIdxFilename, FA_READ) == FR_OK && totalSectors > (FAT32_FILESIZE_LIMIT / EMMC_BLOCKSIZE))
+
+	// Compressed size is not known beforehand, so let user decide if raw size doesn't fit.
+	if ((u64)totalSectors + data_offset > free_sectors)
 	{
-		s_printf(gui->txt_buf, "\n#AEFD14 Partial Backup in progress. Continuing...#\n");
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		lv_obj_t *warn_mbox_bg = create_mbox_text(
+			"#FFDD00 Free space is smaller than uncompressed size!#\n"
+			"#FFDD00 Backup will fail if it doesn't compress enough.#\n\n"
+			"Press #FF8000 POWER# to Continue.\nPress #FF8000 VOL# to abort.", false);
 		manual_system_maintenance(true);
 
-		partialDumpInProgress = true;
-		// Force partial dumping, even if the card is larger.
-		isSmallSdCard = true;
-
-		f_read(&partialIdxFp, &currPartIdx, 4, NULL);
-		f_close(&partialIdxFp);
-
-		if (!maxSplitParts)
+		if (!(btn_wait() & BTN_POWER))
 		{
-			s_printf(gui->txt_buf, "\n#FFDD00 Not enough free space for Partial Backup!#\n");
-			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
-			manual_system_maintenance(true);
-
+			lv_obj_del(warn_mbox_bg);
 			return 0;
 		}
-
-		// Increase maxSplitParts to accommodate previously backed up parts.
-		maxSplitParts += currPartIdx;
-	}
-	else if (isSmallSdCard)
-	{
-		s_printf(gui->txt_buf, "\n#FFBA00 Partial Backup enabled (%d MiB parts)...#\n", multipartSplitSize >> 20);
-		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
-		manual_system_maintenance(true);
+		lv_obj_del(warn_mbox_bg);
 	}
 
-	// Check if filesystem is FAT32 or the free space is smaller and backup in parts.
-	if (((sd_fs.fs_type != FS_EXFAT) && totalSectors > (FAT32_FILESIZE_LIMIT / EMMC_BLOCKSIZE)) || isSmallSdCard)
-	{
-		u32 multipartSplitSectors = multipartSplitSize / EMMC_BLOCKSIZE;
-		numSplitParts = (totalSectors + multipartSplitSectors - 1) / multipartSplitSectors;
-
-		outFilename[sdPathLen++] = '.';
-
-		// Continue from where we left, if Partial Backup in progress.
-		_update_filename(outFilename, sdPathLen, partialDumpInProgress ? currPartIdx : 0);
-	}
+	char *outFilename = sd_path;
+	strcat(outFilename, LZ4B_EXT);
 
 	FIL fp;
 	if (!f_open(&fp, outFilename, FA_READ))
@@ -499,133 +605,1050 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 		return 0;
 	}
 
-	u8 *buf = (u8 *)MIXD_BUF_ALIGNED;
+	// Reserve header and block index. Both are written when the backup is done.
+	// Blocks are compressed independently, so restore can seek to any of them.
+	u8 *hdr_buf = (u8 *)zalloc(data_offset << 9);
+	void *lz4_state = malloc(LZ4_sizeofState());
+	if (!hdr_buf || !lz4_state)
+	{
+		s_printf(gui->txt_buf, "\n#FF0000 Out of memory!#\n");
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
 
-	u32 lba_curr = part->lba_start;
-	u32 lbaStartPart = part->lba_start;
-	u32 bytesWritten = 0;
-	u32 prevPct = 200;
-	int retryCount = 0;
-	DWORD *clmt = NULL;
+		f_close(&fp);
+		free(lz4_state);
+		free(hdr_buf);
+		f_unlink(outFilename);
 
-	// Continue from where we left, if Partial Backup in progress.
-	if (partialDumpInProgress)
-	{
-		lba_curr += currPartIdx * (multipartSplitSize / EMMC_BLOCKSIZE);
-		totalSectors -= currPartIdx * (multipartSplitSize / EMMC_BLOCKSIZE);
-		lbaStartPart = lba_curr; // Update the start LBA for verification.
+		return 0;
 	}
-	u64 totalSize = (u64)((u64)totalSectors << 9);
-	if (!isSmallSdCard && (sd_fs.fs_type == FS_EXFAT || totalSize <= FAT32_FILESIZE_LIMIT))
-		clmt = f_expand_cltbl(&fp, SZ_4M, totalSize);
-	else
-		clmt = f_expand_cltbl(&fp, SZ_4M, MIN(totalSize, multipartSplitSize));
+	lz4_hdr_t *hdr = (lz4_hdr_t *)hdr_buf;
+	lz4_blk_t *index = (lz4_blk_t *)(hdr_buf + EMMC_BLOCKSIZE);
+	res = f_write(&fp, hdr_buf, data_offset << 9, NULL);
 
-	u32 num = 0;
-	u32 pct = 0;
+	// Use 2 buffers, so eMMC reads can run in the background while the previous chunk is compressed and written to SD.
+	u8 *bufs[2] = { (u8 *)MIXD_BUF_ALIGNED, (u8 *)MIXD_BUF_ALIGNED + NUM_SECTORS_PER_ITER * EMMC_BLOCKSIZE };
+	u8 *cbuf = (u8 *)MIXD_BUF_ALIGNED + LZ4B_CBUF_OFFSET;
+	u32 buf_idx = 0;
+	sdmmc_storage_async_t *read_req = NULL;
+
+	u32 lba_curr = part->lba_start;
+	u32 prevPct = 200;
+	u64 comprSize = 0;
 
 	lv_obj_set_opa_scale(gui->bar, LV_OPA_COVER);
 	lv_obj_set_opa_scale(gui->label_pct, LV_OPA_COVER);
-	while (totalSectors > 0)
+	for (u32 i = 0; i < num_blocks && !res; i++)
 	{
-		if (numSplitParts != 0 && bytesWritten >= multipartSplitSize)
+		u32 num = MIN(totalSectors - i * NUM_SECTORS_PER_ITER, NUM_SECTORS_PER_ITER);
+		u32 raw_size = num << 9;
+		u8 *buf = bufs[buf_idx];
+
+		int res_read;
+		if (read_req)
+			res_read = sdmmc_storage_async_wait(read_req);
+		else
+			res_read = sdmmc_storage_read(storage, lba_curr, num, buf);
+		read_req = NULL;
+
+		int retryCount = 0;
+		while (!res_read)
 		{
-			f_close(&fp);
-			free(clmt);
-			memset(&fp, 0, sizeof(fp));
-			currPartIdx++;
+			s_printf(gui->txt_buf,
+				"\n#FFDD00 Error reading %d blocks @ LBA %08X,#\n"
+				"#FFDD00 from eMMC (try %d). #",
+				num, lba_curr, ++retryCount);
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
 
-			if (n_cfg.verification && !gui->raw_emummc)
+			msleep(150);
+			if (retryCount >= 3)
 			{
-				// Verify part.
-				if (_dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part))
-				{
-					s_printf(gui->txt_buf, "#FFDD00 Please try again...#\n");
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
-					manual_system_maintenance(true);
+				s_printf(gui->txt_buf, "#FF0000 Aborting...#\nPlease try again...\n");
+				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				manual_system_maintenance(true);
 
-					return 0;
-				}
+				goto error;
+			}
+
+			s_printf(gui->txt_buf, "#FFDD00 Retrying...#\n");
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			res_read = sdmmc_storage_read(storage, lba_curr, num, buf);
+		}
+		manual_system_maintenance(false);
+
+		// Hash block in the background while it's compressed.
+		se_calc_sha256(index[i].sha256, NULL, buf, raw_size, 0, SHA_INIT_HASH, false);
+
+		// Start reading next chunk from eMMC while current one is compressed and written to SD.
+		u32 num_next = MIN(totalSectors - i * NUM_SECTORS_PER_ITER - num, NUM_SECTORS_PER_ITER);
+		if (num_next)
+			read_req = sdmmc_storage_read_async(storage, lba_curr + num, num_next, bufs[buf_idx ^ 1]);
+
+		// Store block uncompressed if it doesn't shrink.
+		int comp = LZ4_compress_fast_extState(lz4_state, (const char *)buf, (char *)cbuf, raw_size, LZ4_COMPRESSBOUND(raw_size), 1);
+		u8 *data = cbuf;
+		u32 size = comp;
+		if (comp <= 0 || (u32)comp >= raw_size)
+		{
+			data = buf;
+			size = raw_size;
+		}
+
+		se_calc_sha256_finalize(index[i].sha256, NULL);
+
+		if (sd_fs.fs_type != FS_EXFAT && (u64)f_tell(&fp) + size > FAT32_FILESIZE_LIMIT)
+		{
+			s_printf(gui->txt_buf, "\n#FFDD00 Compressed backup exceeds 4GB!#\n#FFDD00 Use exFAT or disable compression.#\n");
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			goto error;
+		}
+
+		index[i].offset = f_tell(&fp);
+		index[i].size = size;
+		index[i].sectors = num;
+
+		UINT bw = 0;
+		res = f_write(&fp, data, size, &bw);
+		if (!res && bw != size)
+			res = FR_DENIED; // SD card is full.
+
+		manual_system_maintenance(false);
+
+		comprSize += size;
+		lba_curr += num;
+		buf_idx ^= 1;
+
+		u32 pct = (u64)((u64)(i + 1) * 100u) / (u64)num_blocks;
+		if (pct != prevPct)
+		{
+			lv_bar_set_value(gui->bar, pct);
+			s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
+			lv_label_set_text(gui->label_pct, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			prevPct = pct;
+		}
+
+		// Check for cancellation combo.
+		if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
+		{
+			s_printf(gui->txt_buf, "\n#FFDD00 The backup was cancelled!#\n");
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			msleep(1500);
+
+			goto error;
+		}
+	}
+
+	// Finalize header and block index.
+	if (!res)
+	{
+		hdr->magic = LZ4B_MAGIC;
+		hdr->version = LZ4B_VERSION;
+		hdr->total_sectors = totalSectors;
+		hdr->blk_sectors = NUM_SECTORS_PER_ITER;
+		hdr->num_blocks = num_blocks;
+		hdr->index_offset = 1;
+		hdr->data_offset = data_offset;
+
+		res = f_lseek(&fp, 0);
+		if (!res)
+			res = f_write(&fp, hdr_buf, data_offset << 9, NULL);
+	}
+
+	if (res)
+	{
+		s_printf(gui->txt_buf, "\n#FF0000 Fatal error (%d) when writing to SD Card#\nPlease try again...\n", res);
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		goto error;
+	}
+
+	lv_bar_set_value(gui->bar, 100);
+	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
+
+	s_printf(gui->txt_buf, "\n#96FF00 Compressed to:# %d MiB (%d%%)\n",
+		(u32)(comprSize >> 20), (u32)((comprSize * 100) / ((u64)totalSectors << 9)));
+	lv_label_ins_text(gui->label_info, LV_LABEL_POS_LAST, gui->txt_buf);
+	manual_system_maintenance(true);
+
+	// Backup operation ended successfully.
+	f_close(&fp);
+	free(lz4_state);
+
+	if (n_cfg.verification)
+	{
+		if (_lz4_verify(gui, storage, outFilename, part, index, num_blocks, false))
+		{
+			s_printf(gui->txt_buf, "\n#FFDD00 Please try again...#\n");
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			free(hdr_buf);
+
+			return 0;
+		}
+		lv_bar_set_value(gui->bar, 100);
+		lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
+		manual_system_maintenance(true);
+	}
+
+	free(hdr_buf);
+
+	return 1;
+
+error:
+	if (read_req)
+		sdmmc_storage_async_wait(read_req);
+
+	f_close(&fp);
+	free(lz4_state);
+	free(hdr_buf);
+	f_unlink(outFilename);
+
+	return 0;
+}
+
+static int _dump_write_poll(FIL *fp, const u8 *buf, u32 size, sdmmc_storage_async_t *read_req)
+{
+	// Write in chunks of whole clusters and poll the background eMMC read in between.
+	// In SDMA mode the read stops at every 512KB boundary until it's polled.
+	u32 chunk = MAX(SZ_512K, sd_fs.csize * EMMC_BLOCKSIZE);
+	while (size)
+	{
+		u32 len = (size > chunk) ? chunk : size;
+		int res = f_write_fast(fp, buf, len);
+		if (res)
+			return res;
+
+		if (read_req)
+			sdmmc_storage_async_poll(read_req);
+
+		buf  += len;
+		size -= len;
+	}
+
+	return 0;
+}
+
+static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part, sdmmc_storage_t *storage, emmc_part_t *part)
+{
+	static const u32 FAT32_FILESIZE_LIMIT = 0xFFFFFFFF;
+	static const u32 SECTORS_TO_MIB_COEFF = 11;
+
+	partial_sd_full_unmount = false;
+
+	u32 multipartSplitSize = (1u << 31);
+	u32 lba_end = part->lba_end;
+	u32 totalSectors = part->lba_end - part->lba_start + 1;
+	u32 currPartIdx = 0;
+	u32 numSplitParts = 0;
+	u32 maxSplitParts = 0;
+	bool isSmallSdCard = false;
+	bool partialDumpInProgress = false;
+	int res = 0;
+	char *outFilename = sd_path;
+	u32 sdPathLen = strlen(sd_path);
+
+	u32 sector_start = 0, part_idx = 0;
+	u32 sector_size = totalSectors;
+	u32 sd_sector_off = 0;
+
+	FIL partialIdxFp;
+	char partialIdxFilename[12];
+	strcpy(partialIdxFilename, "partial.idx");
+
+	// Compressed backups are single files, so partial backups don't apply.
+	if (n_cfg.compress_backup && !gui->raw_emummc)
+	{
+		res = _dump_emmc_part_lz4(gui, sd_path, storage, part);
+		if (res >= 0)
+			return res;
+		res = 0;
+	}
+
+	if (gui->raw_emummc)
+	{
+		_get_valid_partition(&sector_start, &sector_size, &part_idx, true);
+		if (!part_idx || !sector_size)
+		{
+			s_printf(gui->txt_buf, "\n#FFDD00 Failed to find a partition...#\n");
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			return 0;
+		}
+		sd_sector_off = sector_start + (0x2000 * active_part);
+		if (active_part == 2)
+		{
+			// Set new total sectors and lba end sector for percentage calculations.
+			totalSectors = sector_size;
+			lba_end = sector_size + part->lba_start - 1;
+		}
+	}
+
+	s_printf(gui->txt_buf, "#96FF00 SD Card free space:# %d MiB\n#96FF00 Total backup size:# %d MiB\n\n",
+		(u32)(sd_fs.free_clst * sd_fs.csize >> SECTORS_TO_MIB_COEFF),
+		totalSectors >> SECTORS_TO_MIB_COEFF);
+	lv_label_ins_text(gui->label_info, LV_LABEL_POS_LAST, gui->txt_buf);
+	manual_system_maintenance(true);
+
+	lv_bar_set_value(gui->bar, 0);
+	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 0%");
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_BG, lv_theme_get_current()->bar.bg);
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_INDIC, gui->bar_white_ind);
+	manual_system_maintenance(true);
+
+	// 1GB parts for sd cards 8GB and less.
+	if ((sd_storage.csd.capacity >> (20 - sd_storage.csd.read_blkbits)) <= 8192)
+		multipartSplitSize = (1u << 30);
+	// Maximum parts fitting the free space available.
+	maxSplitParts = (sd_fs.free_clst * sd_fs.csize) / (multipartSplitSize / EMMC_BLOCKSIZE);
+
+	// Check if the USER partition or the RAW eMMC fits the sd card free space.
+	if (totalSectors > (sd_fs.free_clst * sd_fs.csize))
+	{
+		isSmallSdCard = true;
+
+		s_printf(gui->txt_buf, "\n#FFBA00 Free space is smaller than backup size.#\n");
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		if (!maxSplitParts)
+		{
+			s_printf(gui->txt_buf, "#FFDD00 Not enough free space for Partial Backup!#\n");
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			return 0;
+		}
+	}
+	// Check if we are continuing a previous raw eMMC or USER partition backup in progress.
+	if (f_open(&partialIdxFp, partialIdxFilename, FA_READ) == FR_OK && totalSectors > (FAT32_FILESIZE_LIMIT / EMMC_BLOCKSIZE))
+	{
+		s_printf(gui->txt_buf, "\n#AEFD14 Partial Backup in progress. Continuing...#\n");
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		partialDumpInProgress = true;
+		// Force partial dumping, even if the card is larger.
+		isSmallSdCard = true;
+
+		f_read(&partialIdxFp, &currPartIdx, 4, NULL);
+		f_close(&partialIdxFp);
+
+		if (!maxSplitParts)
+		{
+			s_printf(gui->txt_buf, "\n#FFDD00 Not enough free space for Partial Backup!#\n");
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			return 0;
+		}
+
+		// Increase maxSplitParts to accommodate previously backed up parts.
+		maxSplitParts += currPartIdx;
+	}
+	else if (isSmallSdCard)
+	{
+		s_printf(gui->txt_buf, "\n#FFBA00 Partial Backup enabled (%d MiB parts)...#\n", multipartSplitSize >> 20);
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+	}
+
+	// Check if filesystem is FAT32 or the free space is smaller and backup in parts.
+	if (((sd_fs.fs_type != FS_EXFAT) && totalSectors > (FAT32_FILESIZE_LIMIT / EMMC_BLOCKSIZE)) || isSmallSdCard)
+	{
+		u32 multipartSplitSectors = multipartSplitSize / EMMC_BLOCKSIZE;
+		numSplitParts = (totalSectors + multipartSplitSectors - 1) / multipartSplitSectors;
+
+		outFilename[sdPathLen++] = '.';
+
+		// Continue from where we left, if Partial Backup in progress.
+		_update_filename(outFilename, sdPathLen, partialDumpInProgress ? currPartIdx : 0);
+	}
+
+	FIL fp;
+	if (!f_open(&fp, outFilename, FA_READ))
+	{
+		f_close(&fp);
+
+		lv_obj_t *warn_mbox_bg = create_mbox_text(
+			"#FFDD00 An existing backup has been detected!#\n\n"
+			"Press #FF8000 POWER# to Continue.\nPress #FF8000 VOL# to abort.", false);
+		manual_system_maintenance(true);
+
+		if (!(btn_wait() & BTN_POWER))
+		{
+			lv_obj_del(warn_mbox_bg);
+			return 0;
+		}
+		lv_obj_del(warn_mbox_bg);
+	}
+
+	s_printf(gui->txt_buf, "#96FF00 Filepath:#\n%s\n#96FF00 Filename:# #FF8000 %s#",
+		gui->base_path, outFilename + strlen(gui->base_path));
+	lv_label_ins_text(gui->label_info, LV_LABEL_POS_LAST, gui->txt_buf);
+	manual_system_maintenance(true);
+
+	res = f_open(&fp, outFilename, FA_CREATE_ALWAYS | FA_WRITE);
+	if (res)
+	{
+		s_printf(gui->txt_buf, "\n#FF0000 Error (%d) while creating#\n#FFDD00 %s#\n", res, outFilename);
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		return 0;
+	}
+
+	// Use 2 buffers, so eMMC reads can run in the background while the previous chunk is written to SD.
+	u8 *bufs[2] = { (u8 *)MIXD_BUF_ALIGNED, (u8 *)MIXD_BUF_ALIGNED + NUM_SECTORS_PER_ITER * EMMC_BLOCKSIZE };
+	u32 buf_idx = 0;
+	sdmmc_storage_async_t *read_req = NULL;
+
+	u32 lba_curr = part->lba_start;
+	u32 lbaStartPart = part->lba_start;
+	u32 bytesWritten = 0;
+	u32 prevPct = 200;
+	int retryCount = 0;
+	DWORD *clmt = NULL;
+
+	// Inline verification hashes eMMC data during backup, so verification only reads the SD card.
+	u8 *inline_hashes = NULL;
+	u32 inline_chunk = 0;
+	if (n_cfg.verification == 4 && !gui->raw_emummc)
+		inline_hashes = (u8 *)malloc(((totalSectors + NUM_SECTORS_PER_ITER - 1) / NUM_SECTORS_PER_ITER) * SE_SHA_256_SIZE);
+
+	// Continue from where we left, if Partial Backup in progress.
+	if (partialDumpInProgress)
+	{
+		lba_curr += currPartIdx * (multipartSplitSize / EMMC_BLOCKSIZE);
+		totalSectors -= currPartIdx * (multipartSplitSize / EMMC_BLOCKSIZE);
+		lbaStartPart = lba_curr; // Update the start LBA for verification.
+	}
+	u64 totalSize = (u64)((u64)totalSectors << 9);
+	if (!isSmallSdCard && (sd_fs.fs_type == FS_EXFAT || totalSize <= FAT32_FILESIZE_LIMIT))
+		clmt = f_expand_cltbl(&fp, SZ_4M, totalSize);
+	else
+		clmt = f_expand_cltbl(&fp, SZ_4M, MIN(totalSize, multipartSplitSize));
+
+	u32 num = 0;
+	u32 pct = 0;
+
+	lv_obj_set_opa_scale(gui->bar, LV_OPA_COVER);
+	lv_obj_set_opa_scale(gui->label_pct, LV_OPA_COVER);
+	while (totalSectors > 0)
+	{
+		if (numSplitParts != 0 && bytesWritten >= multipartSplitSize)
+		{
+			f_close(&fp);
+			free(clmt);
+			memset(&fp, 0, sizeof(fp));
+			currPartIdx++;
+
+			if (n_cfg.verification && !gui->raw_emummc)
+			{
+				// Verify part.
+				if (_dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part, inline_hashes))
+				{
+					s_printf(gui->txt_buf, "#FFDD00 Please try again...#\n");
+					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+					manual_system_maintenance(true);
+
+					free(inline_hashes);
+
+					return 0;
+				}
 				lv_bar_set_style(gui->bar, LV_BAR_STYLE_BG, lv_theme_get_current()->bar.bg);
 				lv_bar_set_style(gui->bar, LV_BAR_STYLE_INDIC, gui->bar_white_ind);
 			}
+			inline_chunk = 0;
+
+			_update_filename(outFilename, sdPathLen, currPartIdx);
+
+			// Always create partial.idx before next part, in case a fatal error occurs.
+			if (isSmallSdCard)
+			{
+				// Create partial backup index file.
+				if (f_open(&partialIdxFp, partialIdxFilename, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK)
+				{
+					f_write(&partialIdxFp, &currPartIdx, 4, NULL);
+					f_close(&partialIdxFp);
+				}
+				else
+				{
+					s_printf(gui->txt_buf, "\n#FF0000 Error creating partial.idx file!#\n");
+					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+					manual_system_maintenance(true);
+
+					free(inline_hashes);
+
+					return 0;
+				}
+
+				// More parts to backup that do not currently fit the sd card free space or fatal error.
+				if (currPartIdx >= maxSplitParts)
+				{
+					create_mbox_text(
+						"#96FF00 Partial Backup in progress!#\n\n"
+						"#96FF00 1.# Press OK to unmount SD Card.\n"
+						"#96FF00 2.# Remove SD Card and move files to free space.\n"
+						"#FFDD00 Don\'t move the partial.idx file!#\n"
+						"#96FF00 3.# Re-insert SD Card.\n"
+						"#96FF00 4.# Select the SAME option again to continue.", true);
+
+					partial_sd_full_unmount = true;
+
+					free(inline_hashes);
+
+					return 1;
+				}
+			}
+
+			// Create next part.
+			s_printf(gui->txt_buf, "%s#", outFilename + strlen(gui->base_path));
+			lv_label_cut_text(gui->label_info,
+				strlen(lv_label_get_text(gui->label_info)) - strlen(outFilename + strlen(gui->base_path)) - 1,
+				strlen(outFilename + strlen(gui->base_path)) + 1);
+			lv_label_ins_text(gui->label_info, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+			lbaStartPart = lba_curr;
+			res = f_open(&fp, outFilename, FA_CREATE_ALWAYS | FA_WRITE);
+			if (res)
+			{
+				s_printf(gui->txt_buf, "\n#FF0000 Error (%d) while creating#\n#FFDD00 %s#\n", res, outFilename);
+				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				manual_system_maintenance(true);
+
+				free(inline_hashes);
+
+				return 0;
+			}
+
+			bytesWritten = 0;
+
+			totalSize = (u64)((u64)totalSectors << 9);
+			clmt = f_expand_cltbl(&fp, SZ_4M, MIN(totalSize, multipartSplitSize));
+		}
+
+		retryCount = 0;
+		num = MIN(totalSectors, NUM_SECTORS_PER_ITER);
+		u8 *buf = bufs[buf_idx];
+
+		int res_read;
+		if (read_req)
+			res_read = !sdmmc_storage_async_wait(read_req);
+		else if (!gui->raw_emummc)
+			res_read = !sdmmc_storage_read(storage, lba_curr, num, buf);
+		else
+			res_read = !sdmmc_storage_read(&sd_storage, lba_curr + sd_sector_off, num, buf);
+		read_req = NULL;
+
+		while (res_read)
+		{
+			s_printf(gui->txt_buf,
+				"\n#FFDD00 Error reading %d blocks @ LBA %08X,#\n"
+				"#FFDD00 from eMMC (try %d). #",
+				num, lba_curr, ++retryCount);
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			msleep(150);
+			if (retryCount >= 3)
+			{
+				s_printf(gui->txt_buf, "#FF0000 Aborting...#\nPlease try again...\n");
+				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				manual_system_maintenance(true);
+
+				f_close(&fp);
+				free(clmt);
+				free(inline_hashes);
+				f_unlink(outFilename);
+
+				return 0;
+			}
+			else
+			{
+				s_printf(gui->txt_buf, "#FFDD00 Retrying...#\n");
+				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+				manual_system_maintenance(true);
+			}
+		}
+		manual_system_maintenance(false);
+
+		// Hash chunk in the background while it's written to SD.
+		if (inline_hashes)
+			se_calc_sha256(inline_hashes + inline_chunk * SE_SHA_256_SIZE, NULL, buf, num << 9, 0, SHA_INIT_HASH, false);
+
+		// Start reading next chunk from eMMC while current one is written to SD. Not possible if it's on a new part.
+		u32 num_next = MIN(totalSectors - num, NUM_SECTORS_PER_ITER);
+		if (!gui->raw_emummc && num_next && (!numSplitParts || (bytesWritten + num * EMMC_BLOCKSIZE) < multipartSplitSize))
+			read_req = sdmmc_storage_read_async(storage, lba_curr + num, num_next, bufs[buf_idx ^ 1]);
+
+		res = _dump_write_poll(&fp, buf, EMMC_BLOCKSIZE * num, read_req);
+
+		if (inline_hashes)
+			se_calc_sha256_finalize(inline_hashes + inline_chunk++ * SE_SHA_256_SIZE, NULL);
+
+		if (res)
+		{
+			s_printf(gui->txt_buf, "\n#FF0000 Fatal error (%d) when writing to SD Card#\nPlease try again...\n", res);
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			if (read_req)
+				sdmmc_storage_async_wait(read_req);
+
+			f_close(&fp);
+			free(clmt);
+			free(inline_hashes);
+			f_unlink(outFilename);
+
+			return 0;
+		}
+
+		manual_system_maintenance(false);
+
+		pct = (u64)((u64)(lba_curr - part->lba_start) * 100u) / (u64)(lba_end - part->lba_start);
+		if (pct != prevPct)
+		{
+			lv_bar_set_value(gui->bar, pct);
+			s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
+			lv_label_set_text(gui->label_pct, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			prevPct = pct;
+		}
+
+		lba_curr += num;
+		totalSectors -= num;
+		bytesWritten += num * EMMC_BLOCKSIZE;
+		buf_idx ^= 1;
+
+		// Force a flush after a lot of data if not splitting.
+		if (numSplitParts == 0 && bytesWritten >= multipartSplitSize)
+		{
+			f_sync(&fp);
+			bytesWritten = 0;
+		}
+
+		// Check for cancellation combo.
+		if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
+		{
+			s_printf(gui->txt_buf, "\n#FFDD00 The backup was cancelled!#\n");
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
 
-			_update_filename(outFilename, sdPathLen, currPartIdx);
+			if (read_req)
+				sdmmc_storage_async_wait(read_req);
 
-			// Always create partial.idx before next part, in case a fatal error occurs.
-			if (isSmallSdCard)
-			{
-				// Create partial backup index file.
-				if (f_open(&partialIdxFp, partialIdxFilename, FA_CREATE_ALWAYS | FA_WRITE) == FR_OK)
-				{
-					f_write(&partialIdxFp, &currPartIdx, 4, NULL);
-					f_close(&partialIdxFp);
-				}
-				else
-				{
-					s_printf(gui->txt_buf, "\n#FF0000 Error creating partial.idx file!#\n");
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
-					manual_system_maintenance(true);
+			msleep(1500);
 
-					return 0;
-				}
+			f_close(&fp);
+			free(clmt);
+			free(inline_hashes);
+			f_unlink(outFilename);
 
-				// More parts to backup that do not currently fit the sd card free space or fatal error.
-				if (currPartIdx >= maxSplitParts)
-				{
-					create_mbox_text(
-						"#96FF00 Partial Backup in progress!#\n\n"
-						"#96FF00 1.# Press OK to unmount SD Card.\n"
-						"#96FF00 2.# Remove SD Card and move files to free space.\n"
-						"#FFDD00 Don\'t move the partial.idx file!#\n"
-						"#96FF00 3.# Re-insert SD Card.\n"
-						"#96FF00 4.# Select the SAME option again to continue.", true);
+			return 0;
+		}
+	}
+	lv_bar_set_value(gui->bar, 100);
+	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
+	manual_system_maintenance(true);
 
-					partial_sd_full_unmount = true;
+	// Backup operation ended successfully.
+	f_close(&fp);
+	free(clmt);
 
-					return 1;
-				}
+	if (n_cfg.verification && !gui->raw_emummc)
+	{
+		// Verify last part or single file backup.
+		if (_dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part, inline_hashes))
+		{
+			s_printf(gui->txt_buf, "\n#FFDD00 Please try again...#\n");
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			free(inline_hashes);
+
+			return 0;
+		}
+		lv_bar_set_value(gui->bar, 100);
+		lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
+		manual_system_maintenance(true);
+	}
+
+	// Remove partial backup index file if no fatal errors occurred.
+	if (isSmallSdCard)
+	{
+		f_unlink(partialIdxFilename);
+
+		create_mbox_text(
+			"#96FF00 Partial Backup done!#\n\n"
+			"You can now join the files if needed\nand get the complete eMMC RAW GPP backup.", true);
+
+		partial_sd_full_unmount = true;
+	}
+
+	free(inline_hashes);
+
+	return 1;
+}
+
+static sparse_extent_t *_sparse_build_extents(emmc_part_t *part, u32 total_sectors, u32 *num_extents, u32 *data_sectors, bool *no_mem)
+{
+	sparse_extent_t *extents = NULL;
+	FATFS *bis_fs = (FATFS *)zalloc(sizeof(FATFS));
+
+	*no_mem = !bis_fs;
+	if (!bis_fs)
+		return NULL;
+
+	// Mount the decrypted partition to get its FAT layout.
+	nx_emmc_bis_init(part, false, 0);
+	if (f_mount(bis_fs, "bis:", 1) || bis_fs->fs_type != FS_FAT32)
+		goto out;
+
+	u32 csize    = bis_fs->csize;
+	u32 clusters = bis_fs->n_fatent;
+	u32 database = bis_fs->database;
+
+	// Worst case is every other cluster allocated, since smaller gaps get merged.
+	extents = (sparse_extent_t *)malloc((clusters / 2 + 2) * sizeof(sparse_extent_t));
+	if (!extents)
+	{
+		*no_mem = true;
+		goto out;
+	}
+
+	// Always keep boot sectors, FATs and everything else before the data area.
+	u32 idx = 0;
+	extents[0].lba = 0;
+	extents[0].sectors = database;
+
+	u32 *fat = (u32 *)MIXD_BUF_ALIGNED;
+	u32 fat_sct = 0;
+	while (fat_sct < bis_fs->fsize)
+	{
+		u32 num = MIN(bis_fs->fsize - fat_sct, NUM_SECTORS_PER_ITER);
+		if (!nx_emmc_bis_read(bis_fs->fatbase + fat_sct, num, fat))
+		{
+			free(extents);
+			extents = NULL;
+			goto out;
+		}
+
+		// Every non zero FAT entry is an allocated cluster.
+		u32 clst = fat_sct * (EMMC_BLOCKSIZE / sizeof(u32));
+		u32 entries = num * (EMMC_BLOCKSIZE / sizeof(u32));
+		for (u32 i = 0; i < entries && clst < clusters; i++, clst++)
+		{
+			if (clst < 2 || !(fat[i] & 0x0FFFFFFF))
+				continue;
+
+			u32 lba = database + (clst - 2) * csize;
+			u32 ext_end = extents[idx].lba + extents[idx].sectors;
+			if (lba - ext_end <= SPARSE_GAP_MERGE)
+				extents[idx].sectors = lba + csize - extents[idx].lba;
+			else
+			{
+				idx++;
+				extents[idx].lba = lba;
+				extents[idx].sectors = csize;
 			}
+		}
 
-			// Create next part.
-			s_printf(gui->txt_buf, "%s#", outFilename + strlen(gui->base_path));
-			lv_label_cut_text(gui->label_info,
-				strlen(lv_label_get_text(gui->label_info)) - strlen(outFilename + strlen(gui->base_path)) - 1,
-				strlen(outFilename + strlen(gui->base_path)) + 1);
-			lv_label_ins_text(gui->label_info, LV_LABEL_POS_LAST, gui->txt_buf);
+		fat_sct += num;
+	}
+
+	// Clamp last extent to partition size.
+	if (extents[idx].lba + extents[idx].sectors > total_sectors)
+		extents[idx].sectors = total_sectors - extents[idx].lba;
+
+	*num_extents = idx + 1;
+	*data_sectors = 0;
+	for (u32 i = 0; i < *num_extents; i++)
+		*data_sectors += extents[i].sectors;
+
+out:
+	f_mount(NULL, "bis:", 1);
+	nx_emmc_bis_end();
+	free(bis_fs);
+
+	return extents;
+}
+
+static u32 _sparse_next_chunk(const sparse_extent_t *extents, u32 num_extents, u32 *ext_idx, u32 *ext_off, u32 *lba)
+{
+	// Skip finished extents.
+	while (*ext_idx < num_extents && *ext_off >= extents[*ext_idx].sectors)
+	{
+		(*ext_idx)++;
+		*ext_off = 0;
+	}
+
+	if (*ext_idx >= num_extents)
+		return 0;
+
+	u32 num = MIN(extents[*ext_idx].sectors - *ext_off, NUM_SECTORS_PER_ITER);
+	*lba = extents[*ext_idx].lba + *ext_off;
+	*ext_off += num;
+
+	return num;
+}
+
+static int _sparse_verify(emmc_tool_gui_t *gui, sdmmc_storage_t *storage, const char *filename, const emmc_part_t *part,
+	const sparse_extent_t *extents, u32 num_extents, u32 data_offset, u32 data_sectors)
+{
+	FIL fp;
+	int res = 0;
+	u32 prevPct = 200;
+	u32 sectors_done = 0;
+	u8 *bufEm = (u8 *)EMMC_BUF_ALIGNED;
+	u8 *bufSd = (u8 *)SDXC_BUF_ALIGNED;
+
+	if (f_open(&fp, filename, FA_READ))
+	{
+		s_printf(gui->txt_buf, "\n#FFDD00 File not found or could not be loaded!#\n#FFDD00 Verification failed..#\n");
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		return 1;
+	}
+
+	lv_bar_set_value(gui->bar, 0);
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_BG, gui->bar_teal_bg);
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_INDIC, gui->bar_teal_ind);
+	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 0%");
+	manual_system_maintenance(true);
+
+	f_lseek(&fp, (u64)data_offset << 9);
+
+	u32 ext_idx = 0, ext_off = 0, lba = 0;
+	u32 num = _sparse_next_chunk(extents, num_extents, &ext_idx, &ext_off, &lba);
+	while (num)
+	{
+		if (!sdmmc_storage_read(storage, part->lba_start + lba, num, bufEm))
+		{
+			s_printf(gui->txt_buf,
+				"\n#FF0000 Failed to read %d blocks (@LBA %08X),#\n"
+				"#FF0000 from eMMC! Verification failed..#\n",
+				num, part->lba_start + lba);
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
 			manual_system_maintenance(true);
-			lbaStartPart = lba_curr;
-			res = f_open(&fp, outFilename, FA_CREATE_ALWAYS | FA_WRITE);
-			if (res)
-			{
-				s_printf(gui->txt_buf, "\n#FF0000 Error (%d) while creating#\n#FFDD00 %s#\n", res, outFilename);
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
-				manual_system_maintenance(true);
 
-				return 0;
-			}
+			res = 1;
+			break;
+		}
+
+		if (f_read(&fp, bufSd, num << 9, NULL))
+		{
+			s_printf(gui->txt_buf,
+				"\n#FF0000 Failed to read %d blocks (@LBA %08X),#\n"
+				"#FF0000 from SD card! Verification failed..#\n",
+				num, part->lba_start + lba);
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			res = 1;
+			break;
+		}
+
+		if (memcmp(bufEm, bufSd, num << 9))
+		{
+			s_printf(gui->txt_buf, "\n#FF0000 Data mismatch (@LBA %08X)!#\n#FF0000 Verification failed..#\n",
+				part->lba_start + lba);
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			res = 1;
+			break;
+		}
+
+		sectors_done += num;
+		u32 pct = (u64)((u64)sectors_done * 100u) / (u64)data_sectors;
+		if (pct != prevPct)
+		{
+			lv_bar_set_value(gui->bar, pct);
+			s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
+			lv_label_set_text(gui->label_pct, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			prevPct = pct;
+		}
+
+		// Check for cancellation combo.
+		if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
+		{
+			s_printf(gui->txt_buf, "#FFDD00 Verification was cancelled!#\n");
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			msleep(1000);
+
+			res = 1;
+			break;
+		}
+
+		num = _sparse_next_chunk(extents, num_extents, &ext_idx, &ext_off, &lba);
+	}
+
+	f_close(&fp);
+
+	return res;
+}
+
+static int _dump_emmc_part_sparse(emmc_tool_gui_t *gui, char *sd_path, sdmmc_storage_t *storage, emmc_part_t *part)
+{
+	static const u32 FAT32_FILESIZE_LIMIT = 0xFFFFFFFF;
+	static const u32 SECTORS_TO_MIB_COEFF = 11;
+
+	u32 totalSectors = part->lba_end - part->lba_start + 1;
+	u32 num_extents = 0;
+	u32 data_sectors = 0;
+	int res = 0;
+
+	bool no_mem;
+	sparse_extent_t *extents = _sparse_build_extents(part, totalSectors, &num_extents, &data_sectors, &no_mem);
+	if (no_mem)
+	{
+		s_printf(gui->txt_buf, "\n#FF0000 Out of memory!#\n");
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		return 0;
+	}
+
+	if (!extents)
+	{
+		s_printf(gui->txt_buf, "\n#FFBA00 No FAT32 found, doing a full backup...#\n");
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		return -1;
+	}
+
+	u32 table_sectors = (num_extents * sizeof(sparse_extent_t) + EMMC_BLOCKSIZE - 1) / EMMC_BLOCKSIZE;
+	u32 data_offset = 1 + table_sectors;
+	u32 fileSectors = data_offset + data_sectors;
+	u64 totalSize = (u64)((u64)fileSectors << 9);
+
+	// Sparse images are never split. Do a full backup if it doesn't fit in one file.
+	if ((sd_fs.fs_type != FS_EXFAT && totalSize > FAT32_FILESIZE_LIMIT) || fileSectors > (sd_fs.free_clst * sd_fs.csize))
+	{
+		s_printf(gui->txt_buf, "\n#FFBA00 Sparse image can't fit, doing a full backup...#\n");
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		free(extents);
+
+		return -1;
+	}
+
+	s_printf(gui->txt_buf, "#96FF00 SD Card free space:# %d MiB\n#96FF00 Sparse backup size:# %d MiB (of %d MiB)\n\n",
+		(u32)(sd_fs.free_clst * sd_fs.csize >> SECTORS_TO_MIB_COEFF),
+		fileSectors >> SECTORS_TO_MIB_COEFF, totalSectors >> SECTORS_TO_MIB_COEFF);
+	lv_label_ins_text(gui->label_info, LV_LABEL_POS_LAST, gui->txt_buf);
+
+	lv_bar_set_value(gui->bar, 0);
+	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 0%");
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_BG, lv_theme_get_current()->bar.bg);
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_INDIC, gui->bar_white_ind);
+	manual_system_maintenance(true);
+
+	char *outFilename = sd_path;
+	strcat(outFilename, ".sparse");
+
+	FIL fp;
+	if (!f_open(&fp, outFilename, FA_READ))
+	{
+		f_close(&fp);
+
+		lv_obj_t *warn_mbox_bg = create_mbox_text(
+			"#FFDD00 An existing backup has been detected!#\n\n"
+			"Press #FF8000 POWER# to Continue.\nPress #FF8000 VOL# to abort.", false);
+		manual_system_maintenance(true);
+
+		if (!(btn_wait() & BTN_POWER))
+		{
+			lv_obj_del(warn_mbox_bg);
+			free(extents);
+			return 0;
+		}
+		lv_obj_del(warn_mbox_bg);
+	}
+
+	s_printf(gui->txt_buf, "#96FF00 Filepath:#\n%s\n#96FF00 Filename:# #FF8000 %s#",
+		gui->base_path, outFilename + strlen(gui->base_path));
+	lv_label_ins_text(gui->label_info, LV_LABEL_POS_LAST, gui->txt_buf);
+	manual_system_maintenance(true);
+
+	res = f_open(&fp, outFilename, FA_CREATE_ALWAYS | FA_WRITE);
+	if (res)
+	{
+		s_printf(gui->txt_buf, "\n#FF0000 Error (%d) while creating#\n#FFDD00 %s#\n", res, outFilename);
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
 
-			bytesWritten = 0;
+		free(extents);
+		return 0;
+	}
 
-			totalSize = (u64)((u64)totalSectors << 9);
-			clmt = f_expand_cltbl(&fp, SZ_4M, MIN(totalSize, multipartSplitSize));
-		}
+	DWORD *clmt = f_expand_cltbl(&fp, SZ_4M, totalSize);
+
+	// Write header and extent table.
+	u8 *hdr_buf = (u8 *)zalloc(data_offset << 9);
+	sparse_hdr_t *hdr = (sparse_hdr_t *)hdr_buf;
+	hdr->magic = SPARSE_MAGIC;
+	hdr->version = SPARSE_VERSION;
+	hdr->total_sectors = totalSectors;
+	hdr->data_sectors = data_sectors;
+	hdr->num_extents = num_extents;
+	hdr->data_offset = data_offset;
+	memcpy(hdr_buf + EMMC_BLOCKSIZE, extents, num_extents * sizeof(sparse_extent_t));
+	res = f_write(&fp, hdr_buf, data_offset << 9, NULL);
+	free(hdr_buf);
+
+	// Use 2 buffers, so eMMC reads can run in the background while the previous chunk is written to SD.
+	u8 *bufs[2] = { (u8 *)MIXD_BUF_ALIGNED, (u8 *)MIXD_BUF_ALIGNED + NUM_SECTORS_PER_ITER * EMMC_BLOCKSIZE };
+	u32 buf_idx = 0;
+	sdmmc_storage_async_t *read_req = NULL;
+
+	u32 ext_idx = 0, ext_off = 0;
+	u32 lba = 0, lba_next = 0;
+	u32 sectors_done = 0;
+	u32 prevPct = 200;
+	u32 num = res ? 0 : _sparse_next_chunk(extents, num_extents, &ext_idx, &ext_off, &lba);
 
-		retryCount = 0;
-		num = MIN(totalSectors, NUM_SECTORS_PER_ITER);
+	lv_obj_set_opa_scale(gui->bar, LV_OPA_COVER);
+	lv_obj_set_opa_scale(gui->label_pct, LV_OPA_COVER);
+	while (num)
+	{
+		u8 *buf = bufs[buf_idx];
 
+		// Data is kept encrypted, so restoring doesn't need BIS keys.
 		int res_read;
-		if (!gui->raw_emummc)
-			res_read = !sdmmc_storage_read(storage, lba_curr, num, buf);
+		if (read_req)
+			res_read = sdmmc_storage_async_wait(read_req);
 		else
-			res_read = !sdmmc_storage_read(&sd_storage, lba_curr + sd_sector_off, num, buf);
+			res_read = sdmmc_storage_read(storage, part->lba_start + lba, num, buf);
+		read_req = NULL;
 
-		while (res_read)
+		int retryCount = 0;
+		while (!res_read)
 		{
 			s_printf(gui->txt_buf,
 				"\n#FFDD00 Error reading %d blocks @ LBA %08X,#\n"
 				"#FFDD00 from eMMC (try %d). #",
-				num, lba_curr, ++retryCount);
+				num, part->lba_start + lba, ++retryCount);
 			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
 			manual_system_maintenance(true);
 
@@ -636,39 +1659,30 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
 				manual_system_maintenance(true);
 
-				f_close(&fp);
-				free(clmt);
-				f_unlink(outFilename);
-
-				return 0;
-			}
-			else
-			{
-				s_printf(gui->txt_buf, "#FFDD00 Retrying...#\n");
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
-				manual_system_maintenance(true);
+				goto error;
 			}
-		}
-		manual_system_maintenance(false);
 
-		res = f_write_fast(&fp, buf, EMMC_BLOCKSIZE * num);
-
-		if (res)
-		{
-			s_printf(gui->txt_buf, "\n#FF0000 Fatal error (%d) when writing to SD Card#\nPlease try again...\n", res);
+			s_printf(gui->txt_buf, "#FFDD00 Retrying...#\n");
 			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
 			manual_system_maintenance(true);
 
-			f_close(&fp);
-			free(clmt);
-			f_unlink(outFilename);
-
-			return 0;
+			res_read = sdmmc_storage_read(storage, part->lba_start + lba, num, buf);
 		}
+		manual_system_maintenance(false);
+
+		// Start reading next chunk from eMMC while current one is written to SD.
+		u32 num_next = _sparse_next_chunk(extents, num_extents, &ext_idx, &ext_off, &lba_next);
+		if (num_next)
+			read_req = sdmmc_storage_read_async(storage, part->lba_start + lba_next, num_next, bufs[buf_idx ^ 1]);
+
+		res = f_write(&fp, buf, num << 9, NULL);
+		if (res)
+			break;
 
 		manual_system_maintenance(false);
 
-		pct = (u64)((u64)(lba_curr - part->lba_start) * 100u) / (u64)(lba_end - part->lba_start);
+		sectors_done += num;
+		u32 pct = (u64)((u64)sectors_done * 100u) / (u64)data_sectors;
 		if (pct != prevPct)
 		{
 			lv_bar_set_value(gui->bar, pct);
@@ -679,17 +1693,6 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 			prevPct = pct;
 		}
 
-		lba_curr += num;
-		totalSectors -= num;
-		bytesWritten += num * EMMC_BLOCKSIZE;
-
-		// Force a flush after a lot of data if not splitting.
-		if (numSplitParts == 0 && bytesWritten >= multipartSplitSize)
-		{
-			f_sync(&fp);
-			bytesWritten = 0;
-		}
-
 		// Check for cancellation combo.
 		if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
 		{
@@ -699,13 +1702,23 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 
 			msleep(1500);
 
-			f_close(&fp);
-			free(clmt);
-			f_unlink(outFilename);
-
-			return 0;
+			goto error;
 		}
+
+		lba = lba_next;
+		num = num_next;
+		buf_idx ^= 1;
+	}
+
+	if (res)
+	{
+		s_printf(gui->txt_buf, "\n#FF0000 Fatal error (%d) when writing to SD Card#\nPlease try again...\n", res);
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		goto error;
 	}
+
 	lv_bar_set_value(gui->bar, 100);
 	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
 	manual_system_maintenance(true);
@@ -714,15 +1727,16 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 	f_close(&fp);
 	free(clmt);
 
-	if (n_cfg.verification && !gui->raw_emummc)
+	if (n_cfg.verification)
 	{
-		// Verify last part or single file backup.
-		if (_dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part))
+		if (_sparse_verify(gui, storage, outFilename, part, extents, num_extents, data_offset, data_sectors))
 		{
 			s_printf(gui->txt_buf, "\n#FFDD00 Please try again...#\n");
 			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
 			manual_system_maintenance(true);
 
+			free(extents);
+
 			return 0;
 		}
 		lv_bar_set_value(gui->bar, 100);
@@ -730,19 +1744,20 @@ static int _dump_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part,
 		manual_system_maintenance(true);
 	}
 
-	// Remove partial backup index file if no fatal errors occurred.
-	if (isSmallSdCard)
-	{
-		f_unlink(partialIdxFilename);
+	free(extents);
 
-		create_mbox_text(
-			"#96FF00 Partial Backup done!#\n\n"
-			"You can now join the files if needed\nand get the complete eMMC RAW GPP backup.", true);
+	return 1;
 
-		partial_sd_full_unmount = true;
-	}
+error:
+	if (read_req)
+		sdmmc_storage_async_wait(read_req);
 
-	return 1;
+	f_close(&fp);
+	free(clmt);
+	free(extents);
+	f_unlink(outFilename);
+
+	return 0;
 }
 
 void dump_emmc_selected(emmcPartType_t dumpType, emmc_tool_gui_t *gui)
@@ -842,102 +1857,377 @@ void dump_emmc_selected(emmcPartType_t dumpType, emmc_tool_gui_t *gui)
 			gui->base_path = (char *)malloc(strlen(sdPath) + 1);
 			strcpy(gui->base_path, sdPath);
 
+			// Sparse backups need BIS keys to parse the FAT of SYSTEM/USER.
+			bool sparse_backup = n_cfg.sparse_backup && !gui->raw_emummc;
+			if (sparse_backup)
+				hos_bis_keygen();
+
 			LIST_INIT(gpt);
 			emmc_gpt_parse(&gpt);
 			LIST_FOREACH_ENTRY(emmc_part_t, part, &gpt, link)
 			{
-				if ((dumpType & PART_USER) == 0 && !strcmp(part->name, "USER"))
-					continue;
-				if ((dumpType & PART_SYSTEM) == 0 && strcmp(part->name, "USER"))
-					continue;
+				if ((dumpType & PART_USER) == 0 && !strcmp(part->name, "USER"))
+					continue;
+				if ((dumpType & PART_SYSTEM) == 0 && strcmp(part->name, "USER"))
+					continue;
+
+				s_printf(txt_buf, "#00DDFF %02d: %s#\n#00DDFF Range: 0x%08X - 0x%08X#\n\n",
+					i, part->name, part->lba_start, part->lba_end);
+				lv_label_set_text(gui->label_info, txt_buf);
+				s_printf(txt_buf, "%02d: %s... ", i, part->name);
+				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+				manual_system_maintenance(true);
+				i++;
+
+				emmcsn_path_impl(sdPath, "/partitions", part->name, &emmc_storage);
+				res = -1;
+				if (sparse_backup && (!strcmp(part->name, "SYSTEM") || !strcmp(part->name, "USER")))
+					res = _dump_emmc_part_sparse(gui, sdPath, &emmc_storage, part);
+				if (res < 0)
+				{
+					emmcsn_path_impl(sdPath, "/partitions", part->name, &emmc_storage);
+					res = _dump_emmc_part(gui, sdPath, 0, &emmc_storage, part);
+				}
+				// If a part failed, don't continue.
+				if (!res)
+				{
+					s_printf(txt_buf, "#FFDD00 Failed!#\n");
+					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+					break;
+				}
+				else
+					s_printf(txt_buf, "Done!\n");
+
+				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+				manual_system_maintenance(true);
+			}
+			emmc_gpt_free(&gpt);
+
+			if (sparse_backup)
+				hos_bis_keys_clear();
+		}
+
+		if (dumpType & PART_RAW)
+		{
+			// Get GP partition size dynamically.
+			const u32 RAW_AREA_NUM_SECTORS = emmc_storage.sec_cnt;
+
+			emmc_part_t rawPart;
+			memset(&rawPart, 0, sizeof(rawPart));
+			rawPart.lba_start = 0;
+			rawPart.lba_end = RAW_AREA_NUM_SECTORS - 1;
+			strcpy(rawPart.name, "rawnand.bin");
+			{
+				s_printf(txt_buf, "#00DDFF %02d: %s#\n#00DDFF Range: 0x%08X - 0x%08X#\n\n",
+					i, rawPart.name, rawPart.lba_start, rawPart.lba_end);
+				lv_label_set_text(gui->label_info, txt_buf);
+				s_printf(txt_buf, "%02d: %s... ", i, rawPart.name);
+				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+				manual_system_maintenance(true);
+
+				i++;
+
+				// Set filename to backup/{emmc_sn}/rawnand.bin or backup/{emmc_sn}/emummc/rawnand.bin.
+				if (!gui->raw_emummc)
+					emmcsn_path_impl(sdPath, "",        rawPart.name, &emmc_storage);
+				else
+					emmcsn_path_impl(sdPath, "/emummc", rawPart.name, &emmc_storage);
+
+				res = _dump_emmc_part(gui, sdPath, 2, &emmc_storage, &rawPart);
+
+				if (!res)
+					s_printf(txt_buf, "#FFDD00 Failed!#\n");
+				else
+					s_printf(txt_buf, "Done!\n");
+
+				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+				manual_system_maintenance(true);
+			}
+		}
+	}
+
+	timer = get_tmr_s() - timer;
+	emmc_end();
+
+	if (res && n_cfg.verification && !gui->raw_emummc)
+		s_printf(txt_buf, "Time taken: %dm %ds.\n#96FF00 Finished and verified!#", timer / 60, timer % 60);
+	else if (res)
+		s_printf(txt_buf, "Time taken: %dm %ds.\nFinished!", timer / 60, timer % 60);
+	else
+		s_printf(txt_buf, "Time taken: %dm %ds.", timer / 60, timer % 60);
+
+	lv_label_set_text(gui->label_finish, txt_buf);
+
+out:
+	free(txt_buf);
+	free(gui->base_path);
+	if (!partial_sd_full_unmount)
+		sd_unmount();
+	else
+	{
+		partial_sd_full_unmount = false;
+		sd_end();
+	}
+}
+
+static bool _raw_backup_is_newer(const char *sd_path, const FILINFO *fno_backup)
+{
+	char path[OUT_FILENAME_SZ];
+	FILINFO fno;
+
+	// Check the single file and then the first part file.
+	strcpy(path, sd_path);
+	if (f_stat(path, &fno))
+	{
+		u32 path_len = strlen(path);
+		path[path_len++] = '.';
+		_update_filename(path, path_len, 0);
+		if (f_stat(path, &fno))
+			return false;
+	}
+
+	return (((u32)fno.fdate << 16) | fno.ftime) > (((u32)fno_backup->fdate << 16) | fno_backup->ftime);
+}
+
+static int _restore_emmc_part_lz4(emmc_tool_gui_t *gui, char *sd_path, sdmmc_storage_t *storage, emmc_part_t *part)
+{
+	static const u32 SECTORS_TO_MIB_COEFF = 11;
+
+	u32 totalSectors = part->lba_end - part->lba_start + 1;
+	lz4_blk_t *index = NULL;
+	sdmmc_storage_async_t *write_req = NULL;
+	int res = 0;
+
+	char inFilename[OUT_FILENAME_SZ];
+	strcpy(inFilename, sd_path);
+	strcat(inFilename, LZ4B_EXT);
+
+	FIL fp;
+	FILINFO fno;
+	if (f_stat(inFilename, &fno))
+		return -1;
+
+	// Don't let a stale compressed backup take priority over a newer raw one.
+	if (_raw_backup_is_newer(sd_path, &fno))
+	{
+		s_printf(gui->txt_buf, "\n#FFDD00 Raw backup is newer than compressed one. Using raw...#\n");
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		return -1;
+	}
+
+	if (f_open(&fp, inFilename, FA_READ))
+		return -1;
+
+	s_printf(gui->txt_buf, "#96FF00 Filepath:#\n%s\n#96FF00 Filename:# #FF8000 %s#",
+		gui->base_path, inFilename + strlen(gui->base_path));
+	lv_label_ins_text(gui->label_info, LV_LABEL_POS_LAST, gui->txt_buf);
+	manual_system_maintenance(true);
+
+	lz4_hdr_t hdr;
+	if (f_read(&fp, &hdr, sizeof(lz4_hdr_t), NULL) || hdr.magic != LZ4B_MAGIC || hdr.version != LZ4B_VERSION ||
+		hdr.blk_sectors != NUM_SECTORS_PER_ITER ||
+		hdr.num_blocks != (hdr.total_sectors + NUM_SECTORS_PER_ITER - 1) / NUM_SECTORS_PER_ITER)
+	{
+		s_printf(gui->txt_buf, "\n#FFDD00 Invalid or incomplete compressed backup!#\n");
+		goto invalid;
+	}
+
+	if (hdr.total_sectors != totalSectors)
+	{
+		s_printf(gui->txt_buf, "\n#FFDD00 Compressed backup size doesn't match#\n#FFDD00 eMMC's selected part size!#\n");
+		goto invalid;
+	}
+
+	// Load and validate the block index.
+	u32 index_size = hdr.num_blocks * sizeof(lz4_blk_t);
+	index = (lz4_blk_t *)malloc(index_size);
+	if (!index)
+	{
+		s_printf(gui->txt_buf, "\n#FF0000 Out of memory!#\n");
+		goto error;
+	}
+	if (f_lseek(&fp, (u64)hdr.index_offset << 9) || f_read(&fp, index, index_size, NULL))
+	{
+		s_printf(gui->txt_buf, "\n#FFDD00 Invalid or incomplete compressed backup!#\n");
+		goto invalid;
+	}
+
+	u64 comprSize = 0;
+	for (u32 i = 0; i < hdr.num_blocks; i++)
+	{
+		u32 sectors = MIN(totalSectors - i * NUM_SECTORS_PER_ITER, NUM_SECTORS_PER_ITER);
+		if (index[i].sectors != sectors || !index[i].size || index[i].size > (sectors << 9) ||
+			index[i].offset < ((u64)hdr.data_offset << 9) || index[i].offset + index[i].size > f_size(&fp))
+		{
+			s_printf(gui->txt_buf, "\n#FFDD00 Invalid or incomplete compressed backup!#\n");
+			goto invalid;
+		}
+		comprSize += index[i].size;
+	}
+
+	s_printf(gui->txt_buf, "\n\nTotal restore size: %d MiB (%d MiB LZ4).\n",
+		totalSectors >> SECTORS_TO_MIB_COEFF, (u32)(comprSize >> 20));
+	lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+
+	lv_bar_set_value(gui->bar, 0);
+	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 0%");
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_BG, lv_theme_get_current()->bar.bg);
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_INDIC, gui->bar_white_ind);
+	manual_system_maintenance(true);
+
+	// Use 2 buffers, so eMMC writes can run in the background while the next block is read and decompressed.
+	u8 *bufs[2] = { (u8 *)MIXD_BUF_ALIGNED, (u8 *)MIXD_BUF_ALIGNED + NUM_SECTORS_PER_ITER * EMMC_BLOCKSIZE };
+	u8 *cbuf = (u8 *)MIXD_BUF_ALIGNED + LZ4B_CBUF_OFFSET;
+	u32 buf_idx = 0;
+	u32 prevPct = 200;
+
+	lv_obj_set_opa_scale(gui->bar, LV_OPA_COVER);
+	lv_obj_set_opa_scale(gui->label_pct, LV_OPA_COVER);
+	for (u32 i = 0; i <= hdr.num_blocks; i++)
+	{
+		u8 *buf = bufs[buf_idx];
+		u32 raw_size = 0;
+
+		// Read and decompress the next block while the previous one is written.
+		if (i < hdr.num_blocks)
+		{
+			raw_size = index[i].sectors << 9;
+			u8 *dst = index[i].size == raw_size ? buf : cbuf;
+
+			res = f_lseek(&fp, index[i].offset);
+			if (!res)
+				res = f_read(&fp, dst, index[i].size, NULL);
+			manual_system_maintenance(false);
+
+			if (!res && dst == cbuf &&
+				LZ4_decompress_safe((const char *)cbuf, (char *)buf, index[i].size, raw_size) != (int)raw_size)
+				res = FR_INT_ERR;
+
+			if (res)
+			{
+				s_printf(gui->txt_buf,
+					"\n#FF0000 Fatal error (%d) when reading from SD!#\n"
+					"#FF0000 This device may be in an inoperative state!#\n"
+					"#FFDD00 Please try again now!#\n", res);
+				goto error;
+			}
+		}
 
-				s_printf(txt_buf, "#00DDFF %02d: %s#\n#00DDFF Range: 0x%08X - 0x%08X#\n\n",
-					i, part->name, part->lba_start, part->lba_end);
-				lv_label_set_text(gui->label_info, txt_buf);
-				s_printf(txt_buf, "%02d: %s... ", i, part->name);
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+		// Finish previous block. Retry synchronously if it failed.
+		if (write_req)
+		{
+			u32 prev = i - 1;
+			u32 lba = part->lba_start + prev * NUM_SECTORS_PER_ITER;
+			u8 *prev_buf = bufs[buf_idx ^ 1];
+
+			int retryCount = 0;
+			res = !sdmmc_storage_async_wait(write_req);
+			write_req = NULL;
+			while (res)
+			{
+				s_printf(gui->txt_buf,
+					"\n#FFDD00 Error writing %d blocks @ LBA %08X,#\n"
+					"#FFDD00 from eMMC (try %d). #",
+					index[prev].sectors, lba, ++retryCount);
+				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
 				manual_system_maintenance(true);
-				i++;
 
-				emmcsn_path_impl(sdPath, "/partitions", part->name, &emmc_storage);
-				res = _dump_emmc_part(gui, sdPath, 0, &emmc_storage, part);
-				// If a part failed, don't continue.
-				if (!res)
+				msleep(150);
+				if (retryCount >= 3)
 				{
-					s_printf(txt_buf, "#FFDD00 Failed!#\n");
-					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
-					break;
+					s_printf(gui->txt_buf, "#FF0000 Aborting...#\n"
+						"#FF0000 This device may be in an inoperative state!#\n"
+						"#FFDD00 Please try again now!#\n");
+					goto error;
 				}
-				else
-					s_printf(txt_buf, "Done!\n");
 
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+				s_printf(gui->txt_buf, "#FFDD00 Retrying...#\n");
+				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
 				manual_system_maintenance(true);
-			}
-			emmc_gpt_free(&gpt);
-		}
 
-		if (dumpType & PART_RAW)
-		{
-			// Get GP partition size dynamically.
-			const u32 RAW_AREA_NUM_SECTORS = emmc_storage.sec_cnt;
+				res = !sdmmc_storage_write(storage, lba, index[prev].sectors, prev_buf);
+			}
 
-			emmc_part_t rawPart;
-			memset(&rawPart, 0, sizeof(rawPart));
-			rawPart.lba_start = 0;
-			rawPart.lba_end = RAW_AREA_NUM_SECTORS - 1;
-			strcpy(rawPart.name, "rawnand.bin");
+			u32 pct = (u64)((u64)i * 100u) / (u64)hdr.num_blocks;
+			if (pct != prevPct)
 			{
-				s_printf(txt_buf, "#00DDFF %02d: %s#\n#00DDFF Range: 0x%08X - 0x%08X#\n\n",
-					i, rawPart.name, rawPart.lba_start, rawPart.lba_end);
-				lv_label_set_text(gui->label_info, txt_buf);
-				s_printf(txt_buf, "%02d: %s... ", i, rawPart.name);
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
+				lv_bar_set_value(gui->bar, pct);
+				s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
+				lv_label_set_text(gui->label_pct, gui->txt_buf);
 				manual_system_maintenance(true);
 
-				i++;
+				prevPct = pct;
+			}
+		}
 
-				// Set filename to backup/{emmc_sn}/rawnand.bin or backup/{emmc_sn}/emummc/rawnand.bin.
-				if (!gui->raw_emummc)
-					emmcsn_path_impl(sdPath, "",        rawPart.name, &emmc_storage);
-				else
-					emmcsn_path_impl(sdPath, "/emummc", rawPart.name, &emmc_storage);
+		if (i == hdr.num_blocks)
+			break;
 
-				res = _dump_emmc_part(gui, sdPath, 2, &emmc_storage, &rawPart);
+		u32 lba = part->lba_start + i * NUM_SECTORS_PER_ITER;
+		write_req = sdmmc_storage_write_async(storage, lba, index[i].sectors, buf);
+		if (!write_req && !sdmmc_storage_write(storage, lba, index[i].sectors, buf))
+		{
+			s_printf(gui->txt_buf, "\n#FF0000 Error writing %d blocks @ LBA %08X!#\n"
+				"#FF0000 This device may be in an inoperative state!#\n"
+				"#FFDD00 Please try again now!#\n", index[i].sectors, lba);
+			goto error;
+		}
 
-				if (!res)
-					s_printf(txt_buf, "#FFDD00 Failed!#\n");
-				else
-					s_printf(txt_buf, "Done!\n");
+		buf_idx ^= 1;
+	}
+	lv_bar_set_value(gui->bar, 100);
+	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
+	manual_system_maintenance(true);
 
-				lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, txt_buf);
-				manual_system_maintenance(true);
-			}
+	// Restore operation ended successfully.
+	f_close(&fp);
+
+	if (n_cfg.verification)
+	{
+		// Verify restored data against the block hashes.
+		if (_lz4_verify(gui, storage, inFilename, part, index, hdr.num_blocks, true))
+		{
+			s_printf(gui->txt_buf, "#FFDD00 Please try again...#\n");
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			free(index);
+
+			return 0;
 		}
+		lv_bar_set_value(gui->bar, 100);
+		lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
+		manual_system_maintenance(true);
 	}
 
-	timer = get_tmr_s() - timer;
-	emmc_end();
+	free(index);
 
-	if (res && n_cfg.verification && !gui->raw_emummc)
-		s_printf(txt_buf, "Time taken: %dm %ds.\n#96FF00 Finished and verified!#", timer / 60, timer % 60);
-	else if (res)
-		s_printf(txt_buf, "Time taken: %dm %ds.\nFinished!", timer / 60, timer % 60);
-	else
-		s_printf(txt_buf, "Time taken: %dm %ds.", timer / 60, timer % 60);
+	return 1;
 
-	lv_label_set_text(gui->label_finish, txt_buf);
+error:
+	lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+	manual_system_maintenance(true);
 
-out:
-	free(txt_buf);
-	free(gui->base_path);
-	if (!partial_sd_full_unmount)
-		sd_unmount();
-	else
-	{
-		partial_sd_full_unmount = false;
-		sd_end();
-	}
+	if (write_req)
+		sdmmc_storage_async_wait(write_req);
+
+	f_close(&fp);
+	free(index);
+
+	return 0;
+
+invalid:
+	// Nothing was written yet, so let the caller try a raw backup instead.
+	strcat(gui->txt_buf, "#FFDD00 Checking for raw backup...#\n");
+	lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+	manual_system_maintenance(true);
+
+	f_close(&fp);
+	free(index);
+
+	return -1;
 }
 
 static int _restore_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_part, sdmmc_storage_t *storage, emmc_part_t *part, bool allow_multi_part)
@@ -967,6 +2257,15 @@ static int _restore_emmc_part(emmc_tool_gui_t *gui, char *sd_path, int active_pa
 	bool use_multipart = false;
 	bool check_4MB_aligned = true;
 
+	// Prefer a compressed backup if there's one.
+	if (!gui->raw_emummc)
+	{
+		res = _restore_emmc_part_lz4(gui, sd_path, storage, part);
+		if (res >= 0)
+			return res;
+		res = 0;
+	}
+
 	if (!allow_multi_part)
 		goto multipart_not_allowed;
 
@@ -1212,7 +2511,7 @@ multipart_not_allowed:
 			if (n_cfg.verification && !gui->raw_emummc)
 			{
 				// Verify part.
-				if (_dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part))
+				if (_dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part, NULL))
 				{
 					s_printf(gui->txt_buf, "\n#FFDD00 Please try again...#\n");
 					lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
@@ -1334,7 +2633,7 @@ multipart_not_allowed:
 	if (n_cfg.verification && !gui->raw_emummc)
 	{
 		// Verify restored data.
-		if (_dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part))
+		if (_dump_emmc_verify(gui, storage, lbaStartPart, outFilename, part, NULL))
 		{
 			s_printf(gui->txt_buf, "#FFDD00 Please try again...#\n");
 			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
@@ -1367,6 +2666,207 @@ multipart_not_allowed:
 	return 1;
 }
 
+static int _restore_emmc_part_sparse(emmc_tool_gui_t *gui, char *sd_path, sdmmc_storage_t *storage, emmc_part_t *part)
+{
+	static const u32 SECTORS_TO_MIB_COEFF = 11;
+
+	u32 totalSectors = part->lba_end - part->lba_start + 1;
+	sparse_extent_t *extents = NULL;
+	DWORD *clmt = NULL;
+	int res = 0;
+
+	char *outFilename = sd_path;
+	u32 sdPathLen = strlen(sd_path);
+	strcat(outFilename, ".sparse");
+
+	FIL fp;
+	FILINFO fno;
+	if (f_stat(outFilename, &fno) || f_open(&fp, outFilename, FA_READ))
+		return -1;
+
+	// Don't let a stale sparse backup take priority over a newer raw one.
+	sd_path[sdPathLen] = 0;
+	if (_raw_backup_is_newer(sd_path, &fno))
+	{
+		f_close(&fp);
+
+		s_printf(gui->txt_buf, "\n#FFDD00 Raw backup is newer than sparse one. Using raw...#\n");
+		lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+		manual_system_maintenance(true);
+
+		return -1;
+	}
+	strcat(outFilename, ".sparse");
+
+	s_printf(gui->txt_buf, "#96FF00 Filepath:#\n%s\n#96FF00 Filename:# #FF8000 %s#",
+		gui->base_path, outFilename + strlen(gui->base_path));
+	lv_label_ins_text(gui->label_info, LV_LABEL_POS_LAST, gui->txt_buf);
+	manual_system_maintenance(true);
+
+	sparse_hdr_t hdr;
+	if (f_read(&fp, &hdr, sizeof(sparse_hdr_t), NULL) || hdr.magic != SPARSE_MAGIC || hdr.version != SPARSE_VERSION)
+	{
+		s_printf(gui->txt_buf, "\n#FFDD00 Invalid sparse backup!#\n");
+		goto error;
+	}
+
+	if (hdr.total_sectors != totalSectors)
+	{
+		s_printf(gui->txt_buf, "\n#FFDD00 Sparse backup size doesn't match#\n#FFDD00 eMMC's selected part size!#\n");
+		goto error;
+	}
+
+	// Extents can't outnumber sectors and data must start after the extent table.
+	u32 table_size = hdr.num_extents * sizeof(sparse_extent_t);
+	u32 table_sectors = (table_size + EMMC_BLOCKSIZE - 1) / EMMC_BLOCKSIZE;
+	if (!hdr.num_extents || hdr.num_extents > totalSectors || hdr.data_offset < 1 + table_sectors)
+	{
+		s_printf(gui->txt_buf, "\n#FFDD00 Invalid sparse backup!#\n");
+		goto error;
+	}
+
+	// Validate the extent table.
+	extents = (sparse_extent_t *)malloc(table_size);
+	if (!extents)
+	{
+		s_printf(gui->txt_buf, "\n#FF0000 Out of memory!#\n");
+		goto error;
+	}
+	if (f_read(&fp, extents, table_size, NULL))
+	{
+		s_printf(gui->txt_buf, "\n#FFDD00 Invalid sparse backup!#\n");
+		goto error;
+	}
+
+	// Extents must be sorted and not overlapping, so data can't exceed partition size.
+	u32 data_sectors = 0;
+	u32 ext_end = 0;
+	for (u32 i = 0; i < hdr.num_extents; i++)
+	{
+		if (extents[i].lba < ext_end || extents[i].lba >= totalSectors ||
+			!extents[i].sectors || extents[i].sectors > totalSectors - extents[i].lba)
+		{
+			s_printf(gui->txt_buf, "\n#FFDD00 Sparse backup extent out of bounds!#\n");
+			goto error;
+		}
+		ext_end = extents[i].lba + extents[i].sectors;
+		data_sectors += extents[i].sectors;
+	}
+
+	if (data_sectors != hdr.data_sectors || ((u64)(hdr.data_offset + data_sectors) << 9) != f_size(&fp))
+	{
+		s_printf(gui->txt_buf, "\n#FFDD00 Sparse backup is incomplete!#\n");
+		goto error;
+	}
+
+	s_printf(gui->txt_buf, "\n\n#96FF00 Sparse backup size:# %d MiB (of %d MiB)\n",
+		data_sectors >> SECTORS_TO_MIB_COEFF, totalSectors >> SECTORS_TO_MIB_COEFF);
+	lv_label_ins_text(gui->label_info, LV_LABEL_POS_LAST, gui->txt_buf);
+
+	lv_bar_set_value(gui->bar, 0);
+	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 0%");
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_BG, lv_theme_get_current()->bar.bg);
+	lv_bar_set_style(gui->bar, LV_BAR_STYLE_INDIC, gui->bar_white_ind);
+	manual_system_maintenance(true);
+
+	clmt = f_expand_cltbl(&fp, SZ_4M, 0);
+	f_lseek(&fp, (u64)hdr.data_offset << 9);
+
+	u8 *buf = (u8 *)MIXD_BUF_ALIGNED;
+	u32 ext_idx = 0, ext_off = 0, lba = 0;
+	u32 sectors_done = 0;
+	u32 prevPct = 200;
+	u32 num = _sparse_next_chunk(extents, hdr.num_extents, &ext_idx, &ext_off, &lba);
+
+	lv_obj_set_opa_scale(gui->bar, LV_OPA_COVER);
+	lv_obj_set_opa_scale(gui->label_pct, LV_OPA_COVER);
+	while (num)
+	{
+		res = f_read(&fp, buf, num << 9, NULL);
+		manual_system_maintenance(false);
+		if (res)
+		{
+			s_printf(gui->txt_buf,
+				"\n#FF0000 Fatal error (%d) when reading from SD!#\n"
+				"#FF0000 This device may be in an inoperative state!#\n"
+				"#FFDD00 Please try again now!#\n", res);
+			goto error;
+		}
+
+		int retryCount = 0;
+		while (!sdmmc_storage_write(storage, part->lba_start + lba, num, buf))
+		{
+			s_printf(gui->txt_buf,
+				"\n#FFDD00 Error writing %d blocks @ LBA %08X,#\n"
+				"#FFDD00 to eMMC (try %d). #",
+				num, part->lba_start + lba, ++retryCount);
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			msleep(150);
+			if (retryCount >= 3)
+			{
+				s_printf(gui->txt_buf, "#FF0000 Aborting...#\n"
+					"#FF0000 This device may be in an inoperative state!#\n"
+					"#FFDD00 Please try again now!#\n");
+				goto error;
+			}
+
+			s_printf(gui->txt_buf, "#FFDD00 Retrying...#\n");
+			lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+			manual_system_maintenance(true);
+		}
+
+		sectors_done += num;
+		u32 pct = (u64)((u64)sectors_done * 100u) / (u64)data_sectors;
+		if (pct != prevPct)
+		{
+			lv_bar_set_value(gui->bar, pct);
+			s_printf(gui->txt_buf, " "SYMBOL_DOT" %d%%", pct);
+			lv_label_set_text(gui->label_pct, gui->txt_buf);
+			manual_system_maintenance(true);
+
+			prevPct = pct;
+		}
+
+		num = _sparse_next_chunk(extents, hdr.num_extents, &ext_idx, &ext_off, &lba);
+	}
+	lv_bar_set_value(gui->bar, 100);
+	lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
+	manual_system_maintenance(true);
+
+	// Restore operation ended successfully.
+	f_close(&fp);
+	free(clmt);
+
+	if (n_cfg.verification)
+	{
+		if (_sparse_verify(gui, storage, outFilename, part, extents, hdr.num_extents, hdr.data_offset, data_sectors))
+		{
+			free(extents);
+
+			return 0;
+		}
+		lv_bar_set_value(gui->bar, 100);
+		lv_label_set_text(gui->label_pct, " "SYMBOL_DOT" 100%");
+		manual_system_maintenance(true);
+	}
+
+	free(extents);
+
+	return 1;
+
+error:
+	lv_label_ins_text(gui->label_log, LV_LABEL_POS_LAST, gui->txt_buf);
+	manual_system_maintenance(true);
+
+	f_close(&fp);
+	free(clmt);
+	free(extents);
+
+	return 0;
+}
+
 void restore_emmc_selected(emmcPartType_t restoreType, emmc_tool_gui_t *gui)
 {
 	int res = 0;
@@ -1507,7 +3007,14 @@ void restore_emmc_selected(emmcPartType_t restoreType, emmc_tool_gui_t *gui)
 			i++;
 
 			emmcsn_path_impl(sdPath, "/restore/partitions", part->name, &emmc_storage);
-			res = _restore_emmc_part(gui, sdPath, 0, &emmc_storage, part, false);
+			res = -1;
+			if (!gui->raw_emummc)
+				res = _restore_emmc_part_sparse(gui, sdPath, &emmc_storage, part);
+			if (res < 0)
+			{
+				emmcsn_path_impl(sdPath, "/restore/partitions", part->name, &emmc_storage);
+				res = _restore_emmc_part(gui, sdPath, 0, &emmc_storage, part, false);
+			}
 
 			if (!res)
 				s_printf(txt_buf, "#FFDD00 Failed!#\n");
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include <bdk.h>
+
+#include "fe_sensors.h"
+
+// Max age of each sensor group before it gets sampled again.
+static const u32 sensor_stale_ms[SENSOR_GRPS] = {
+	5000, // RTC. Status bar shows minutes.
+	4000, // SoC temperature. TMP451 converts every 4s.
+	5000, // Charger status.
+	5000  // Fuel gauge.
+};
+
+static sensors_t sensors;
+
+static void _sensors_sample_grp(u32 grp)
+{
+	int fuel[7];
+
+	switch (grp)
+	{
+	case SENSOR_GRP_RTC:
+		max77620_rtc_get_time_adjusted(&sensors.time);
+		break;
+	case SENSOR_GRP_SOC_TEMP:
+		sensors.soc_temp = tmp451_get_soc_temp(false);
+		break;
+	case SENSOR_GRP_CHARGER:
+		bq24193_get_property(BQ24193_ChargeStatus, &sensors.charge_status);
+		break;
+	case SENSOR_GRP_FUEL:
+		// One transaction for RepCap, RepSOC, Age, TEMP, VCELL, Current and AvgCurrent.
+		if (max17050_get_properties(MAX17050_RepCap, 7, fuel))
+			return;
+		sensors.batt_cap      = fuel[0];
+		sensors.batt_percent  = fuel[1];
+		sensors.batt_age      = fuel[2];
+		sensors.batt_temp     = fuel[3];
+		sensors.batt_volt     = fuel[4];
+		sensors.batt_curr     = fuel[5];
+		sensors.batt_avg_curr = fuel[6];
+		break;
+	}
+
+	sensors.sampled_ms[grp] = get_tmr_ms();
+}
+
+static bool _sensors_stale(u32 grp, u32 now)
+{
+	return !sensors.sampled_ms[grp] || (now - sensors.sampled_ms[grp]) >= sensor_stale_ms[grp];
+}
+
+void sensors_init()
+{
+	memset(&sensors, 0, sizeof(sensors_t));
+
+	for (u32 grp = 0; grp < SENSOR_GRPS; grp++)
+		_sensors_sample_grp(grp);
+}
+
+// Periodic task. Samples only the most overdue group, so each run costs one I2C transaction batch.
+void sensors_sample(void *param)
+{
+	u32 now = get_tmr_ms();
+	u32 stale_grp = SENSOR_GRPS;
+	u32 max_overdue = 0;
+
+	for (u32 grp = 0; grp < SENSOR_GRPS; grp++)
+	{
+		if (!_sensors_stale(grp, now))
+			continue;
+
+		u32 overdue = now - sensors.sampled_ms[grp] - sensor_stale_ms[grp];
+		if (stale_grp == SENSOR_GRPS || overdue > max_overdue)
+		{
+			stale_grp = grp;
+			max_overdue = overdue;
+		}
+	}
+
+	if (stale_grp != SENSOR_GRPS)
+		_sensors_sample_grp(stale_grp);
+}
+
+// Samples the requested groups if stale. For consumers that need fresh values now.
+const sensors_t *sensors_get(u32 grps)
+{
+	u32 now = get_tmr_ms();
+
+	for (u32 grp = 0; grp < SENSOR_GRPS; grp++)
+		if ((grps & BIT(grp)) && _sensors_stale(grp, now))
+			_sensors_sample_grp(grp);
+
+	return &sensors;
+}
+
+// Returns cached values without any I2C traffic.
+const sensors_t *sensors_peek()
+{
+	return &sensors;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _FE_SENSORS_H_
+#define _FE_SENSORS_H_
+
+#include <bdk.h>
+
+#define SENSORS_SAMPLE_PERIOD_MS 1000
+
+typedef enum _sensor_grp_t
+{
+	SENSOR_GRP_RTC      = 0,
+	SENSOR_GRP_SOC_TEMP = 1,
+	SENSOR_GRP_CHARGER  = 2,
+	SENSOR_GRP_FUEL     = 3,
+	SENSOR_GRPS
+} sensor_grp_t;
+
+#define SENSOR_RTC      BIT(SENSOR_GRP_RTC)
+#define SENSOR_SOC_TEMP BIT(SENSOR_GRP_SOC_TEMP)
+#define SENSOR_CHARGER  BIT(SENSOR_GRP_CHARGER)
+#define SENSOR_FUEL     BIT(SENSOR_GRP_FUEL)
+#define SENSOR_ALL      (BIT(SENSOR_GRPS) - 1)
+
+typedef struct _sensors_t
+{
+	// MAX77620 RTC.
+	rtc_time_t time;
+
+	// TMP451. Integer part in MSB, 2 decimals in LSB.
+	u16 soc_temp;
+
+	// BQ24193.
+	int charge_status;
+
+	// MAX17050. Burst read from RepCap to AvgCurrent.
+	int batt_cap;      // mAh.
+	int batt_percent;  // RepSOC. Integer part in MSB.
+	int batt_age;      // %.
+	int batt_temp;     // 0.1 oC.
+	int batt_volt;     // mV.
+	int batt_curr;     // uA.
+	int batt_avg_curr; // uA.
+
+	u32 sampled_ms[SENSOR_GRPS];
+} sensors_t;
+
+void sensors_init();
+void sensors_sample(void *param);
+const sensors_t *sensors_get(u32 grps);
+const sensors_t *sensors_peek();
+
+#endif
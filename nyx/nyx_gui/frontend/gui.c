@@ -23,6 +23,7 @@
 #include "gui_tools.h"
 #include "gui_info.h"
 #include "gui_options.h"
+#include "fe_sensors.h"
 #include <libs/lvgl/lv_themes/lv_theme_hekate.h>
 #include <libs/lvgl/lvgl.h>
 #include "../gfx/logos-gui.h"
@@ -40,6 +41,13 @@ extern lv_res_t launch_payload(lv_obj_t *list);
 static bool disp_init_done = false;
 static bool do_reload = false;
 
+static bool console_enabled = false;
+
+static u32 disp_fb_src = NYX_LV_VDB_ADR;
+
+gui_disp_stats_t disp_stats;
+gui_loop_stats_t loop_stats;
+
 lv_style_t hint_small_style;
 lv_style_t hint_small_style_white;
 lv_style_t monospace_text;
@@ -90,7 +98,7 @@ gui_status_bar_ctx status_bar;
 static void _nyx_disp_init()
 {
 	vic_surface_t vic_sfc;
-	vic_sfc.src_buf  = NYX_FB2_ADDRESS;
+	vic_sfc.src_buf  = disp_fb_src;
 	vic_sfc.dst_buf  = NYX_FB_ADDRESS;
 	vic_sfc.width    = 1280;
 	vic_sfc.height   = 720;
@@ -209,7 +217,7 @@ static void _save_fb_to_bmp()
 	const u32 file_size = NYX_FB_SZ + 0x36;
 	u8 *bitmap = malloc(file_size);
 	u32 *fb = malloc(NYX_FB_SZ);
-	u32 *fb_ptr = (u32 *)NYX_FB2_ADDRESS;
+	u32 *fb_ptr = (u32 *)disp_fb_src;
 	u32 line_bytes = 1280 * sizeof(u32);
 
 	// Reconstruct FB for bottom-top, landscape bmp. No rotation.
@@ -310,15 +318,20 @@ static void _save_fb_to_bmp()
 
 static void _disp_fb_flush(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const lv_color_t *color_p)
 {
-	// Draw to intermediate non-rotated framebuffer.
-	gfx_set_rect_pitch((u32 *)NYX_FB2_ADDRESS, (u32 *)color_p, 1280, x1, y1, x2, y2);
+	// VDB holds the whole screen. Rotate and copy the flushed area directly from it.
+	disp_fb_src = (u32)color_p;
 
-	// Rotate and copy to visible framebuffer.
 	if (disp_init_done)
-		vic_compose();
+	{
+		vic_set_source(disp_fb_src);
+		vic_compose_rect(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+
+		// Flush is signalled as ready when VIC is done.
+		return;
+	}
 
 	// Check if display init was done. If it's the first big draw, init.
-	if (!disp_init_done && ((x2 - x1 + 1) > 600))
+	if ((x2 - x1 + 1) > 600)
 	{
 		disp_init_done = true;
 		_nyx_disp_init();
@@ -327,9 +340,48 @@ static void _disp_fb_flush(int32_t x1, int32_t y1, int32_t x2, int32_t y2, const
 	lv_flush_ready();
 }
 
+static void _disp_flush_wait()
+{
+	vic_compose_wait();
+	lv_flush_ready();
+}
+
+static void _disp_refr_monitor(uint32_t time, uint32_t px_num)
+{
+	// Update frame time histogram.
+	u32 bin = 0;
+	while (bin < (DISP_FRAME_HIST_BINS - 1) && time >= (4u << bin))
+		bin++;
+	disp_stats.frame_hist[bin]++;
+	disp_stats.frames++;
+
+	// Update composed pixels per second.
+	u32 elapsed = get_tmr_ms() - disp_stats.time_ms;
+	if (elapsed < 1000)
+		return;
+
+	u32 composed_px = vic_get_composed_pixels();
+	disp_stats.composed_pps = (u64)(composed_px - disp_stats.composed_px) * 1000 / elapsed;
+	disp_stats.composed_px  = composed_px;
+	disp_stats.time_ms      = get_tmr_ms();
+
+	if (console_enabled)
+	{
+		// Print display debugging in console.
+		gfx_con_getpos(&gfx_con.savedx, &gfx_con.savedy, &gfx_con.savedcol);
+		gfx_con_setpos(32, 622, GFX_COL_AUTO);
+		gfx_con.fntsz = 8;
+		gfx_printf("frames: %6d | px/s: %8d | ms <4: %d, <8: %d, <16: %d, <32: %d, <64: %d, >64: %d",
+			disp_stats.frames, disp_stats.composed_pps,
+			disp_stats.frame_hist[0], disp_stats.frame_hist[1], disp_stats.frame_hist[2],
+			disp_stats.frame_hist[3], disp_stats.frame_hist[4], disp_stats.frame_hist[5]);
+		gfx_con_setpos(gfx_con.savedx, gfx_con.savedy, gfx_con.savedcol);
+		gfx_con.fntsz = 16;
+	}
+}
+
 static touch_event touchpad;
 static bool touch_enabled;
-static bool console_enabled = false;
 
 static bool _fts_touch_read(lv_indev_data_t *data)
 {
@@ -622,19 +674,68 @@ typedef struct _system_maintenance_tasks_t
 {
 	union
 	{
-		lv_task_t *tasks[2];
+		lv_task_t *tasks[3];
 		struct
 		{
 			lv_task_t *status_bar;
 			lv_task_t *dram_periodic_comp;
+			lv_task_t *sensors;
 		} task;
 	};
 } system_maintenance_tasks_t;
 
 static system_maintenance_tasks_t system_tasks;
 
+#define GUI_LOOP_MAX_SLEEP_MS 100 // Wake up at least that often, even without due tasks.
+#define GUI_EMC_1600_EXTRA_MW 280 // DRAM at 1600 MHz draws that much more than at 800 MHz.
+
+static gui_emc_state_t emc_state = GUI_EMC_HIGH; // Nyx starts with DRAM at 1600 MHz.
+static u64 emc_time_us[GUI_EMC_STATES];
+static u64 sleep_time_us;
+static u32 emc_time_start;
+static u32 loop_stats_time_ms;
+
+static void _nyx_loop_account()
+{
+	u32 now = get_tmr_us();
+	emc_time_us[emc_state] += now - emc_time_start;
+	emc_time_start = now;
+
+	loop_stats.emc_ms[GUI_EMC_LOW]  = emc_time_us[GUI_EMC_LOW] / 1000;
+	loop_stats.emc_ms[GUI_EMC_HIGH] = emc_time_us[GUI_EMC_HIGH] / 1000;
+	loop_stats.sleep_ms = sleep_time_us / 1000;
+
+	// Old loop kept DRAM at 1600 MHz whenever LVGL was running. Credit the time spent at 800 MHz instead.
+	if (!h_cfg.t210b01)
+		loop_stats.energy_saved_mj = emc_time_us[GUI_EMC_LOW] * GUI_EMC_1600_EXTRA_MW / 1000000;
+}
+
+static void _nyx_emc_set(gui_emc_state_t state)
+{
+	// Minerva not supported on T210B01 yet.
+	if (h_cfg.t210b01 || emc_state == state)
+		return;
+
+	// Do not retrain while VIC is still composing from DRAM.
+	if (disp_init_done)
+		vic_compose_wait();
+
+	_nyx_loop_account();
+
+	if (state == GUI_EMC_HIGH)
+		minerva_change_freq(FREQ_1600); // Takes 295 us.
+	else
+		minerva_change_freq(FREQ_800);  // Takes 80 us.
+
+	emc_state = state;
+	loop_stats.emc_switches++;
+}
+
 void manual_system_maintenance(bool refresh)
 {
+	// Called from long jobs that block the main loop. Keep DRAM at full speed for them.
+	_nyx_emc_set(GUI_EMC_HIGH);
+
 	for (u32 task_idx = 0; task_idx < (sizeof(system_maintenance_tasks_t) / sizeof(lv_task_t *)); task_idx++)
 	{
 		lv_task_t *task = system_tasks.tasks[task_idx];
@@ -784,9 +885,7 @@ bool nyx_emmc_check_battery_enough()
 	if (fuse_read_hw_state() == FUSE_NX_HW_STATE_DEV)
 		return true;
 
-	int batt_volt = 0;
-
-	max17050_get_property(MAX17050_VCELL, &batt_volt);
+	int batt_volt = sensors_get(SENSOR_FUEL)->batt_volt;
 
 	if (batt_volt && batt_volt < 3650)
 	{
@@ -1299,24 +1398,27 @@ static void _create_tab_about(lv_theme_t * th, lv_obj_t * parent)
 	lv_label_set_text(lbl_ver, version);
 }
 
+static void _status_bar_set_text(lv_obj_t *label, const char *text)
+{
+	// Unchanged text would only cause a redraw.
+	if (!strcmp(lv_label_get_text(label), text))
+		return;
+
+	lv_label_set_text(label, text);
+}
+
 static void _update_status_bar(void *params)
 {
 	static char *label = NULL;
 
-	u16 soc_temp = 0;
-	u32 batt_percent = 0;
-	int charge_status = 0;
-	int batt_volt = 0;
-	int batt_curr = 0;
-	rtc_time_t time;
-
-	// Get sensor data.
-	max77620_rtc_get_time_adjusted(&time);
-	soc_temp = tmp451_get_soc_temp(false);
-	bq24193_get_property(BQ24193_ChargeStatus, &charge_status);
-	max17050_get_property(MAX17050_RepSOC, (int *)&batt_percent);
-	max17050_get_property(MAX17050_VCELL, &batt_volt);
-	max17050_get_property(MAX17050_Current, &batt_curr);
+	// Get sensor data. Sampled by the sensors task, so no I2C traffic here.
+	const sensors_t *sns = sensors_peek();
+	u16 soc_temp = sns->soc_temp;
+	u32 batt_percent = sns->batt_percent;
+	int charge_status = sns->charge_status;
+	int batt_volt = sns->batt_volt;
+	int batt_curr = sns->batt_curr;
+	const rtc_time_t *time = &sns->time;
 
 	// Enable fan if more than 41 oC.
 	u32 soc_temp_dec = soc_temp >> 8;
@@ -1327,9 +1429,9 @@ static void _update_status_bar(void *params)
 
 	// Set time and SoC temperature.
 	s_printf(label, "%02d:%02d "SYMBOL_DOT" "SYMBOL_TEMPERATURE" %02d.%d",
-		time.hour, time.min, soc_temp_dec, (soc_temp & 0xFF) / 10);
+		time->hour, time->min, soc_temp_dec, (soc_temp & 0xFF) / 10);
 
-	lv_label_set_text(status_bar.time_temp, label);
+	_status_bar_set_text(status_bar.time_temp, label);
 
 	lv_obj_realign(status_bar.temp_symbol);
 	lv_obj_realign(status_bar.temp_degrees);
@@ -1353,7 +1455,7 @@ static void _update_status_bar(void *params)
 	if (charge_status)
 		strcat(label, " #FFDD00 "SYMBOL_CHARGE"#");
 
-	lv_label_set_text(status_bar.battery, label);
+	_status_bar_set_text(status_bar.battery, label);
 	lv_obj_realign(status_bar.battery);
 
 	// Set battery current draw and voltage.
@@ -1363,7 +1465,7 @@ static void _update_status_bar(void *params)
 	s_printf(label + strlen(label), " mA# (%s%d mV%s)",
 		voltage_empty ? "#FF8000 " : "", batt_volt,  voltage_empty ? " "SYMBOL_WARNING"#" : "");
 
-	lv_label_set_text(status_bar.battery_more, label);
+	_status_bar_set_text(status_bar.battery_more, label);
 	lv_obj_realign(status_bar.battery_more);
 }
 
@@ -2349,6 +2451,8 @@ static void _nyx_main_menu(lv_theme_t * th)
 	system_tasks.task.dram_periodic_comp = lv_task_create(minerva_periodic_training, EMC_PERIODIC_TRAIN_MS, LV_TASK_PRIO_HIGHEST, NULL);
 	lv_task_ready(system_tasks.task.dram_periodic_comp);
 
+	system_tasks.task.sensors = lv_task_create(sensors_sample, SENSORS_SAMPLE_PERIOD_MS, LV_TASK_PRIO_LOW, NULL);
+
 	system_tasks.task.status_bar = lv_task_create(_update_status_bar, 5000, LV_TASK_PRIO_LOW, NULL);
 	lv_task_ready(system_tasks.task.status_bar);
 
@@ -2400,6 +2504,81 @@ static void _nyx_main_menu(lv_theme_t * th)
 		task_bpmp_clock = lv_task_create(first_time_bpmp_clock, 10000, LV_TASK_PRIO_LOWEST, NULL);
 }
 
+static bool _nyx_work_pending()
+{
+	// Redraw pending.
+	if (lv_refr_get_buf_size())
+		return true;
+
+	// Pointer held. Actions that run I/O jobs are fired on its release.
+	if (jc_drv_ctx.indev_jc->proc.state == LV_INDEV_STATE_PR ||
+		jc_drv_ctx.indev_touch->proc.state == LV_INDEV_STATE_PR)
+		return true;
+
+	// Keys held. Long jobs poll them for cancellation.
+	if (btn_read_vol())
+		return true;
+
+	// One shot jobs queued, like UMS, clock edit or Joy-Con init.
+	if (lv_task_once_pending())
+		return true;
+
+	return false;
+}
+
+static void _nyx_loop_stats_print()
+{
+	if (!console_enabled || (get_tmr_ms() - loop_stats_time_ms) < 1000)
+		return;
+
+	loop_stats_time_ms = get_tmr_ms();
+	_nyx_loop_account();
+
+	// Print main loop debugging in console.
+	gfx_con_getpos(&gfx_con.savedx, &gfx_con.savedy, &gfx_con.savedcol);
+	gfx_con_setpos(32, 606, GFX_COL_AUTO);
+	gfx_con.fntsz = 8;
+	gfx_printf("loops: %8d | sleeps: %8d (%8d ms) | emc 800: %8d ms, 1600: %8d ms, sw: %6d | saved: %6d mJ",
+		loop_stats.iterations, loop_stats.sleeps, loop_stats.sleep_ms,
+		loop_stats.emc_ms[GUI_EMC_LOW], loop_stats.emc_ms[GUI_EMC_HIGH], loop_stats.emc_switches,
+		loop_stats.energy_saved_mj);
+	gfx_con_setpos(gfx_con.savedx, gfx_con.savedy, gfx_con.savedcol);
+	gfx_con.fntsz = 16;
+}
+
+static void _nyx_gui_loop()
+{
+	memset(&loop_stats, 0, sizeof(gui_loop_stats_t));
+
+	// Start from 800 MHz. DRAM is only raised when there is work for it.
+	if (!h_cfg.t210b01)
+		minerva_change_freq(FREQ_800);
+	emc_state = GUI_EMC_LOW;
+	emc_time_start = get_tmr_us();
+
+	while (true)
+	{
+		_nyx_emc_set(_nyx_work_pending() ? GUI_EMC_HIGH : GUI_EMC_LOW);
+
+		// Halt BPMP until the next LVGL task is due. Timer IRQ wakes it up.
+		u32 next_ms = lv_task_get_next_run();
+		if (next_ms)
+		{
+			u32 start = get_tmr_us();
+			timer_usleep(MIN(next_ms, GUI_LOOP_MAX_SLEEP_MS) * 1000);
+			sleep_time_us += get_tmr_us() - start;
+			loop_stats.sleeps++;
+
+			continue;
+		}
+
+		lv_task_handler();
+		loop_stats.iterations++;
+
+		_nyx_loop_stats_print();
+	}
+}
+
 void nyx_load_and_run()
 {
 	memset(&system_tasks, 0, sizeof(system_maintenance_tasks_t));
@@ -2411,7 +2590,10 @@ void nyx_load_and_run()
 	lv_disp_drv_t disp_drv;
 	lv_disp_drv_init(&disp_drv);
 	disp_drv.disp_flush = _disp_fb_flush;
+	disp_drv.disp_flush_wait = _disp_flush_wait;
 	lv_disp_drv_register(&disp_drv);
+	lv_refr_set_monitor_cb(_disp_refr_monitor);
+	memset(&disp_stats, 0, sizeof(gui_disp_stats_t));
 
 	// Initialize Joy-Con.
 	if (!n_cfg.jc_disable)
@@ -2439,6 +2621,9 @@ void nyx_load_and_run()
 	// Initialize temperature sensor.
 	tmp451_init();
 
+	// Take the first sensor samples. Sensors task keeps them fresh afterwards.
+	sensors_init();
+
 	// Set hekate theme based on chosen hue.
 	lv_theme_t *th = lv_theme_hekate_init(n_cfg.theme_bg, n_cfg.theme_color, NULL);
 	lv_theme_set_current(th);
@@ -2459,25 +2644,5 @@ void nyx_load_and_run()
 	}
 
 	// Gui loop.
-	if (h_cfg.t210b01)
-	{
-		// Minerva not supported on T210B01 yet. Slight power saving via spinlock.
-		while (true)
-		{
-			lv_task_handler();
-			usleep(400);
-		}
-	}
-	else
-	{
-		// Alternate DRAM frequencies. Saves 280 mW.
-		while (true)
-		{
-			minerva_change_freq(FREQ_1600);  // Takes 295 us.
-
-			lv_task_handler();
-
-			minerva_change_freq(FREQ_800);   // Takes 80 us.
-		}
-	}
+	_nyx_gui_loop();
 }
@@ -44,6 +44,34 @@ typedef struct _gui_status_bar_ctx
 	lv_obj_t *battery_more;
 } gui_status_bar_ctx;
 
+#define DISP_FRAME_HIST_BINS 6 // <4, <8, <16, <32, <64 and >=64 ms.
+
+typedef struct _gui_disp_stats_t
+{
+	u32 composed_pps; // Composed pixels per second.
+	u32 composed_px;
+	u32 time_ms;
+	u32 frames;
+	u32 frame_hist[DISP_FRAME_HIST_BINS];
+} gui_disp_stats_t;
+
+typedef enum _gui_emc_state_t
+{
+	GUI_EMC_LOW  = 0, // 800 MHz or fixed rate on T210B01.
+	GUI_EMC_HIGH = 1, // 1600 MHz.
+	GUI_EMC_STATES
+} gui_emc_state_t;
+
+typedef struct _gui_loop_stats_t
+{
+	u32 iterations;              // LVGL task handler runs.
+	u32 sleeps;                  // BPMP halts while waiting for a task to become due.
+	u32 emc_switches;            // DRAM frequency changes.
+	u32 sleep_ms;                // Time BPMP was halted.
+	u32 emc_ms[GUI_EMC_STATES];  // Time spent at each DRAM frequency.
+	u32 energy_saved_mj;         // Estimated energy saved by not running DRAM at 1600 MHz.
+} gui_loop_stats_t;
+
 extern lv_style_t hint_small_style;
 extern lv_style_t hint_small_style_white;
 extern lv_style_t monospace_text;
@@ -67,6 +95,8 @@ extern lv_style_t mbox_darken;
 extern char *text_color;
 
 extern gui_status_bar_ctx status_bar;
+extern gui_disp_stats_t disp_stats;
+extern gui_loop_stats_t loop_stats;
 
 void reload_nyx();
 lv_img_dsc_t *bmp_to_lvimg_obj(const char *path);
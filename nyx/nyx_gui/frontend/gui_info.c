@@ -19,6 +19,8 @@
 #include <bdk.h>
 
 #include "gui.h"
+#include "fe_bench.h"
+#include "fe_sensors.h"
 #include "../config.h"
 #include "../hos/hos.h"
 #include "../hos/pkg1.h"
@@ -1288,6 +1290,166 @@ out:
 	return LV_RES_OK;
 }
 
+#define BENCH_SCRATCH     "bootloader/benchmarks/.scratch"
+#define BENCH_SCRATCH_SCT 0x80000 // 256MB.
+
+typedef struct _bench_ctx_t
+{
+	sdmmc_storage_t *storage;
+	FIL *fp; // Set when I/O targets the scratch file.
+	sdmmc_storage_async_t *req;
+	lv_obj_t *bar;
+	u32 prev_pct;
+	u32 render_timer;
+	u32 rnd[4];
+	u32 rnd_idx;
+} bench_ctx_t;
+
+static int _bench_read(void *ctx, u32 sector, u32 num_sectors, void *buf)
+{
+	bench_ctx_t *bench = (bench_ctx_t *)ctx;
+
+	if (bench->fp)
+		return !f_lseek(bench->fp, (FSIZE_t)sector << 9) && !f_read(bench->fp, buf, num_sectors << 9, NULL);
+
+	return sdmmc_storage_read(bench->storage, sector, num_sectors, buf);
+}
+
+static int _bench_read_async(void *ctx, u32 sector, u32 num_sectors, void *buf)
+{
+	bench_ctx_t *bench = (bench_ctx_t *)ctx;
+
+	// Raw storage only. Fall back to a blocking read if it can't be queued.
+	bench->req = sdmmc_storage_read_async(bench->storage, sector, num_sectors, buf);
+	if (!bench->req)
+		return sdmmc_storage_read(bench->storage, sector, num_sectors, buf);
+
+	return 1;
+}
+
+static int _bench_wait(void *ctx)
+{
+	bench_ctx_t *bench = (bench_ctx_t *)ctx;
+
+	if (!bench->req)
+		return 1;
+
+	int res = sdmmc_storage_async_wait(bench->req);
+	bench->req = NULL;
+
+	return res;
+}
+
+static int _bench_write(void *ctx, u32 sector, u32 num_sectors, void *buf)
+{
+	bench_ctx_t *bench = (bench_ctx_t *)ctx;
+
+	// Never write to the raw storage.
+	if (!bench->fp)
+		return 0;
+
+	return !f_lseek(bench->fp, (FSIZE_t)sector << 9) && !f_write(bench->fp, buf, num_sectors << 9, NULL);
+}
+
+static u32 _bench_rand(void *ctx)
+{
+	bench_ctx_t *bench = (bench_ctx_t *)ctx;
+
+	if (bench->rnd_idx >= 4)
+	{
+		// Generate new random numbers.
+		while (!se_gen_prng128(bench->rnd))
+			;
+		bench->rnd_idx = 0;
+	}
+
+	return bench->rnd[bench->rnd_idx++];
+}
+
+static int _bench_progress(void *ctx, u32 pct)
+{
+	bench_ctx_t *bench = (bench_ctx_t *)ctx;
+
+	manual_system_maintenance(false);
+
+	if (pct != bench->prev_pct && bench->render_timer < get_tmr_ms())
+	{
+		lv_bar_set_value(bench->bar, pct);
+		manual_system_maintenance(true);
+		bench->render_timer = get_tmr_ms() + 66;
+
+		bench->prev_pct = pct;
+
+		if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
+			return 1;
+	}
+
+	return 0;
+}
+
+static int _bench_run_test(bench_io_t *io, const bench_test_t *test, u32 offset, u32 span, bench_result_t *res,
+	char *txt_buf, lv_obj_t *lbl_status, lv_obj_t *mbox)
+{
+	bench_ctx_t *bench = (bench_ctx_t *)io->ctx;
+
+	bench->prev_pct = 200;
+	bench->render_timer = get_tmr_ms() + 66;
+
+	int error = bench_run(io, test, offset, span, res);
+	if (error)
+		return error;
+
+	lv_bar_set_value(bench->bar, 100);
+
+	u32 rate_100 = (u64)res->rate_kibs * 100 / 1024;
+	s_printf(txt_buf + strlen(txt_buf),
+		" %.16s - Rate: #C7EA46 %4d.%02d MiB/s#, IOPS: #C7EA46 %5d#, p99: #C7EA46 %5d us#\n",
+		test->name, rate_100 / 100, rate_100 % 100, res->iops, res->lat_p99_us);
+	lv_label_set_text(lbl_status, txt_buf);
+	lv_obj_align(lbl_status, NULL, LV_ALIGN_CENTER, 0, 0);
+	lv_obj_align(mbox, NULL, LV_ALIGN_CENTER, 0, 0);
+	manual_system_maintenance(true);
+
+	return 0;
+}
+
+static int _bench_save_results(bool sd_bench, sdmmc_storage_t *storage, bench_result_t *results, u32 res_cnt, char *path)
+{
+	char id[32];
+	char *out = (char *)malloc(SZ_128K);
+
+	// Identify the storage by its CID.
+	char prod_name[9] = { 0 };
+	memcpy(prod_name, storage->cid.prod_name, sizeof(storage->cid.prod_name));
+	s_printf(id, "%02X_%s_%08X", storage->cid.manfid, prod_name, storage->cid.serial);
+
+	strcpy(path, "bootloader");
+	f_mkdir(path);
+	strcat(path, "/benchmarks");
+	f_mkdir(path);
+
+	// Create date/time name.
+	rtc_time_t time;
+	max77620_rtc_get_time_adjusted(&time);
+	s_printf(path + strlen(path), "/%s_%04d%02d%02d_%02d%02d%02d",
+		sd_bench ? "sd" : "emmc", time.year, time.month, time.day, time.hour, time.min, time.sec);
+	u32 path_len = strlen(path);
+
+	bench_export_csv(out, sd_bench ? "sd" : "emmc", results, res_cnt);
+	strcat(path, ".csv");
+	int res = sd_save_to_file(out, strlen(out), path);
+
+	bench_export_json(out, sd_bench ? "sd" : "emmc", id, results, res_cnt);
+	strcpy(path + path_len, ".json");
+	if (!res)
+		res = sd_save_to_file(out, strlen(out), path);
+
+	path[path_len] = 0;
+	free(out);
+
+	return res;
+}
+
 static lv_res_t _create_mbox_benchmark(bool sd_bench)
 {
 	sdmmc_storage_t *storage;
@@ -1303,8 +1465,8 @@ static lv_res_t _create_mbox_benchmark(bool sd_bench)
 
 	char *txt_buf = (char *)malloc(SZ_16K);
 
-	s_printf(txt_buf, "#FF8000 %s Benchmark#\n[Raw Reads] Abort: VOL- & VOL+",
-		sd_bench ? "SD Card" : "eMMC");
+	s_printf(txt_buf, "#FF8000 %s Benchmark#\n[%s] Abort: VOL- & VOL+",
+		sd_bench ? "SD Card" : "eMMC", sd_bench ? "Raw Reads, Scratch File Writes" : "Raw Reads");
 
 	lv_mbox_set_text(mbox, txt_buf);
 	txt_buf[0] = 0;
@@ -1353,6 +1515,26 @@ static lv_res_t _create_mbox_benchmark(bool sd_bench)
 		goto out;
 	}
 
+	bench_ctx_t bench = { 0 };
+	bench.storage = storage;
+	bench.bar     = bar;
+	bench.rnd_idx = 4;
+
+	bench_io_t io = { 0 };
+	io.ctx      = &bench;
+	io.read     = _bench_read;
+	io.write    = _bench_write;
+	io.read_async = _bench_read_async;
+	io.wait       = _bench_wait;
+	io.rand     = _bench_rand;
+	io.progress = _bench_progress;
+	io.get_us   = get_tmr_us;
+	io.buf      = (u8 *)MIXD_BUF_ALIGNED;
+	io.buf_sct  = 0x8000; // 16MB.
+
+	u32 res_cnt = 0;
+	bench_result_t *results = (bench_result_t *)malloc((bench_read_suite_cnt * 3 + bench_write_suite_cnt) * sizeof(bench_result_t));
+
 	int error = 0;
 	u32 iters = 3;
 	u32 offset_chunk_start = ALIGN_DOWN(storage->sec_cnt / 3, 0x8000); // Align to 16MB.
@@ -1361,175 +1543,93 @@ static lv_res_t _create_mbox_benchmark(bool sd_bench)
 
 	for (u32 iter_curr = 0; iter_curr < iters; iter_curr++)
 	{
-		u32 pct = 0;
-		u32 prevPct = 200;
-		u32 timer = 0;
-		u32 lba_curr = 0;
 		u32 sector = offset_chunk_start * iter_curr;
-		u32 sector_num = 0x8000;       // 16MB chunks.
-		u32 data_remaining = 0x200000; // 1GB.
 
-		s_printf(txt_buf + strlen(txt_buf), "#C7EA46 %d/3# - Sector Offset #C7EA46 %08X#:\n", iter_curr + 1, sector);
+		s_printf(txt_buf + strlen(txt_buf), "#C7EA46 %d/%d# - Sector Offset #C7EA46 %08X#:\n", iter_curr + 1, iters, sector);
 
-		u32 render_min_ms = 66;
-		u32 render_timer  = get_tmr_ms() + render_min_ms;
-		while (data_remaining)
+		for (u32 i = 0; i < bench_read_suite_cnt; i++)
 		{
-			u32 time_taken = get_tmr_us();
-			error = !sdmmc_storage_read(storage, sector + lba_curr, sector_num, (u8 *)MIXD_BUF_ALIGNED);
-			time_taken = get_tmr_us() - time_taken;
-			timer += time_taken;
-
-			manual_system_maintenance(false);
-			data_remaining -= sector_num;
-			lba_curr += sector_num;
-
-			pct = (lba_curr * 100) / 0x200000;
-			if (pct != prevPct && render_timer < get_tmr_ms())
-			{
-				lv_bar_set_value(bar, pct);
-				manual_system_maintenance(true);
-				render_timer = get_tmr_ms() + render_min_ms;
-
-				prevPct = pct;
-
-				if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
-					error = -1;
-			}
-
+			// 1GB test area.
+			error = _bench_run_test(&io, &bench_read_suite[i], sector, 0x200000, &results[res_cnt], txt_buf, lbl_status, mbox);
 			if (error)
 				goto error;
+			res_cnt++;
 		}
-		lv_bar_set_value(bar, 100);
-
-		u32 rate_1k = ((u64)1024 * 1000 * 1000 * 1000) / timer;
-		s_printf(txt_buf + strlen(txt_buf),
-			" Sequential 16MiB - Rate: #C7EA46 %3d.%02d MiB/s#\n",
-			rate_1k / 1000, (rate_1k % 1000) / 10);
-		lv_label_set_text(lbl_status, txt_buf);
-		lv_obj_align(lbl_status, NULL, LV_ALIGN_CENTER, 0, 0);
-		lv_obj_align(mbox, NULL, LV_ALIGN_CENTER, 0, 0);
-		manual_system_maintenance(true);
+	}
 
-		pct = 0;
-		prevPct = 200;
-		timer = 0;
-		lba_curr = 0;
-		sector_num = 8;            // 4KB chunks.
-		data_remaining = 0x100000; // 512MB.
+	// Write tests only run inside a preallocated scratch file. eMMC is never written.
+	if (sd_bench)
+	{
+		FIL fp;
 
-		render_timer = get_tmr_ms() + render_min_ms;
-		while (data_remaining)
+		f_mkdir("bootloader");
+		f_mkdir("bootloader/benchmarks");
+		if (!f_open(&fp, BENCH_SCRATCH, FA_CREATE_ALWAYS | FA_READ | FA_WRITE))
 		{
-			u32 time_taken = get_tmr_us();
-			error = !sdmmc_storage_read(storage, sector + lba_curr, sector_num, (u8 *)MIXD_BUF_ALIGNED);
-			time_taken = get_tmr_us() - time_taken;
-			timer += time_taken;
-
-			manual_system_maintenance(false);
-			data_remaining -= sector_num;
-			lba_curr += sector_num;
-
-			pct = (lba_curr * 100) / 0x100000;
-			if (pct != prevPct && render_timer < get_tmr_ms())
+			DWORD *clmt = f_expand_cltbl(&fp, SZ_4M, (FSIZE_t)BENCH_SCRATCH_SCT << 9);
+			if (clmt && f_size(&fp) == ((FSIZE_t)BENCH_SCRATCH_SCT << 9))
 			{
-				lv_bar_set_value(bar, pct);
-				manual_system_maintenance(true);
-				render_timer = get_tmr_ms() + render_min_ms;
-
-				prevPct = pct;
-
-				if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
-					error = -1;
+				// File is not guaranteed to be contiguous. Link map is size, count/cluster pair per fragment and terminator.
+				bool contiguous = clmt[0] == 4;
+
+				bench.fp    = &fp;
+				io.lba_base = fp.obj.fs->database + (fp.obj.sclust - 2) * fp.obj.fs->csize;
+				io.au_sct   = sd_storage_get_ssr_au(storage) * 2; // KiB to sectors.
+
+				s_printf(txt_buf + strlen(txt_buf), "#C7EA46 Writes# - Scratch File #C7EA46 %d MiB#:\n", BENCH_SCRATCH_SCT >> 11);
+				if (!contiguous)
+					s_printf(txt_buf + strlen(txt_buf), " #FFDD00 Scratch file has %d fragments. Skipping AU test!#\n", (u32)(clmt[0] - 2) / 2);
+
+				for (u32 i = 0; i < bench_write_suite_cnt; i++)
+				{
+					// AU alignment is only valid if the whole file is physically contiguous.
+					if (bench_write_suite[i].au_align && !contiguous)
+						continue;
+
+					error = _bench_run_test(&io, &bench_write_suite[i], 0, BENCH_SCRATCH_SCT, &results[res_cnt], txt_buf, lbl_status, mbox);
+					if (error)
+						break;
+					res_cnt++;
+				}
+
+				bench.fp = NULL;
 			}
+			else
+				strcat(txt_buf, "#FFDD00 Not enough free space for write tests!#\n");
+
+			f_close(&fp);
+			free(clmt);
+			f_unlink(BENCH_SCRATCH);
 
 			if (error)
 				goto error;
 		}
-		lv_bar_set_value(bar, 100);
-
-		rate_1k = ((u64)512 * 1000 * 1000 * 1000) / timer;
-		u32 iops_1k = ((u64)512 * 1024 * 1000 * 1000 * 1000) / (4096 / 1024) / timer / 1000;
-		s_printf(txt_buf + strlen(txt_buf),
-			" Sequential  4KiB - Rate: #C7EA46 %3d.%02d MiB/s#, IOPS: #C7EA46 %4d#\n",
-			rate_1k / 1000, (rate_1k % 1000) / 10, iops_1k);
-		lv_label_set_text(lbl_status, txt_buf);
-		lv_obj_align(lbl_status, NULL, LV_ALIGN_CENTER, 0, 0);
-		lv_obj_align(mbox, NULL, LV_ALIGN_CENTER, 0, 0);
-		manual_system_maintenance(true);
-
-		u32 lba_idx = 0;
-		u32 *random_offsets = malloc(0x20000 * sizeof(u32));
-		u32  random_numbers[4];
-		for (u32 i = 0; i < 0x20000; i += 4)
-		{
-			// Generate new random numbers.
-			while (!se_gen_prng128(random_numbers))
-				;
-			// Clamp offsets to 512MB range.
-			random_offsets[i + 0] = random_numbers[0] % 0x100000;
-			random_offsets[i + 1] = random_numbers[1] % 0x100000;
-			random_offsets[i + 2] = random_numbers[2] % 0x100000;
-			random_offsets[i + 3] = random_numbers[3] % 0x100000;
-		}
-
-		pct = 0;
-		prevPct = 200;
-		timer = 0;
-		data_remaining = 0x100000; // 512MB.
-
-		render_timer = get_tmr_ms() + render_min_ms;
-		while (data_remaining)
-		{
-			u32 time_taken = get_tmr_us();
-			error = !sdmmc_storage_read(storage, sector + random_offsets[lba_idx], sector_num, (u8 *)MIXD_BUF_ALIGNED);
-			time_taken = get_tmr_us() - time_taken;
-			timer += time_taken;
-
-			manual_system_maintenance(false);
-			data_remaining -= sector_num;
-			lba_idx++;
-
-			pct = (lba_idx * 100) / 0x20000;
-			if (pct != prevPct && render_timer < get_tmr_ms())
-			{
-				lv_bar_set_value(bar, pct);
-				manual_system_maintenance(true);
-				render_timer = get_tmr_ms() + render_min_ms;
-
-				prevPct = pct;
+		else
+			strcat(txt_buf, "#FFDD00 Failed to create scratch file!#\n");
+	}
 
-				if (btn_read_vol() == (BTN_VOL_UP | BTN_VOL_DOWN))
-					error = -1;
-			}
+	// Save results. eMMC results need the SD card.
+	char path[128];
+	if (sd_bench || sd_mount())
+	{
+		if (!_bench_save_results(sd_bench, storage, results, res_cnt, path))
+			s_printf(txt_buf + strlen(txt_buf), "Saved to #C7EA46 %s.csv/json#", path);
+		else
+			strcat(txt_buf, "#FFDD00 Failed to save results!#");
 
-			if (error)
-			{
-				free(random_offsets);
-				goto error;
-			}
-		}
-		lv_bar_set_value(bar, 100);
-
-		// Calculate rate and IOPS for 512MB transfer.
-		rate_1k = ((u64)512 * 1000 * 1000 * 1000) / timer;
-		iops_1k = ((u64)512 * 1024 * 1000 * 1000 * 1000) / (4096 / 1024) / timer / 1000;
-		s_printf(txt_buf + strlen(txt_buf),
-			" Random      4KiB - Rate: #C7EA46 %3d.%02d MiB/s#, IOPS: #C7EA46 %4d#\n",
-			rate_1k / 1000, (rate_1k % 1000) / 10, iops_1k);
-		if (iter_curr == iters - 1)
-			txt_buf[strlen(txt_buf) - 1] = 0; // Cut off last line change.
-		lv_label_set_text(lbl_status, txt_buf);
-		lv_obj_align(lbl_status, NULL, LV_ALIGN_CENTER, 0, 0);
-		lv_obj_align(mbox, NULL, LV_ALIGN_CENTER, 0, 0);
-		manual_system_maintenance(true);
-		free(random_offsets);
+		if (!sd_bench)
+			sd_unmount();
 	}
+	else
+		strcat(txt_buf, "#FFDD00 No SD Card to save results!#");
+
+	lv_label_set_text(lbl_status, txt_buf);
+	lv_obj_align(lbl_status, NULL, LV_ALIGN_CENTER, 0, 0);
 
 error:
 	if (error)
 	{
-		if (error == -1)
+		if (error == BENCH_ERR_ABORT)
 			s_printf(txt_buf + strlen(txt_buf), "\n#FFDD00 Aborted!#");
 		else
 			s_printf(txt_buf + strlen(txt_buf), "\n#FFDD00 IO Error occurred!#");
@@ -1538,13 +1638,12 @@ error:
 		lv_obj_align(lbl_status, NULL, LV_ALIGN_CENTER, 0, 0);
 	}
 
+	free(results);
 	lv_obj_del(bar);
 
-	if (sd_bench && error && error != -1)
-		sd_end();
 	if (sd_bench)
 	{
-		if (error && error != -1)
+		if (error && error != BENCH_ERR_ABORT)
 			sd_end();
 		else
 			sd_unmount();
@@ -2225,12 +2324,10 @@ static lv_res_t _create_window_battery_status(lv_obj_t *btn)
 
 	char *txt_buf = (char *)malloc(SZ_16K);
 	int value = 0;
-	int cap_pct = 0;
 
-	// Fuel gauge IC info.
-	max17050_get_property(MAX17050_RepSOC, &cap_pct);
-	max17050_get_property(MAX17050_RepCap, &value);
-	s_printf(txt_buf, "\n%d mAh [%d %%]\n", value, cap_pct >> 8);
+	// Fuel gauge IC info. Frequently sampled registers come from the sensors cache.
+	const sensors_t *sns = sensors_get(SENSOR_FUEL | SENSOR_CHARGER);
+	s_printf(txt_buf, "\n%d mAh [%d %%]\n", sns->batt_cap, sns->batt_percent >> 8);
 
 	max17050_get_property(MAX17050_FullCAP, &value);
 	s_printf(txt_buf + strlen(txt_buf), "%d mAh\n", value);
@@ -2240,16 +2337,13 @@ static lv_res_t _create_window_battery_status(lv_obj_t *btn)
 	s_printf(txt_buf + strlen(txt_buf), "%s%d mAh%s\n",
 		design_cap_init ? "#FF8000 " : "", value,  design_cap_init ? " - Init "SYMBOL_WARNING"#" : "");
 
-	max17050_get_property(MAX17050_Current, &value);
-	s_printf(txt_buf + strlen(txt_buf), "%d mA\n", value / 1000);
+	s_printf(txt_buf + strlen(txt_buf), "%d mA\n", sns->batt_curr / 1000);
 
-	max17050_get_property(MAX17050_AvgCurrent, &value);
-	s_printf(txt_buf + strlen(txt_buf), "%d mA\n", value / 1000);
+	s_printf(txt_buf + strlen(txt_buf), "%d mA\n", sns->batt_avg_curr / 1000);
 
-	max17050_get_property(MAX17050_VCELL, &value);
-	bool voltage_empty = value < 3200;
+	bool voltage_empty = sns->batt_volt < 3200;
 	s_printf(txt_buf + strlen(txt_buf), "%s%d mV%s\n",
-		voltage_empty ? "#FF8000 " : "", value,  voltage_empty ? " - Low "SYMBOL_WARNING"#" : "");
+		voltage_empty ? "#FF8000 " : "", sns->batt_volt,  voltage_empty ? " - Low "SYMBOL_WARNING"#" : "");
 
 	max17050_get_property(MAX17050_OCVInternal, &value);
 	s_printf(txt_buf + strlen(txt_buf), "%d mV\n", value);
@@ -2263,7 +2357,7 @@ static lv_res_t _create_window_battery_status(lv_obj_t *btn)
 	max17050_get_property(MAX17050_V_empty, &value);
 	s_printf(txt_buf + strlen(txt_buf), "%d mV\n", value);
 
-	max17050_get_property(MAX17050_TEMP, &value);
+	value = sns->batt_temp;
 	s_printf(txt_buf + strlen(txt_buf), "%d.%d oC\n\n\n", value / 10, (value >= 0 ? value : (~value + 1)) % 10);
 
 	// Main Pmic IC info.
@@ -2340,8 +2434,7 @@ static lv_res_t _create_window_battery_status(lv_obj_t *btn)
 	bq24193_get_property(BQ24193_ChargeVoltageLimit, &value);
 	s_printf(txt_buf + strlen(txt_buf), "%d mV\n", value);
 
-	bq24193_get_property(BQ24193_ChargeStatus, &value);
-	switch (value)
+	switch (sns->charge_status)
 	{
 	case 0:
 		strcat(txt_buf, "Not charging\n");
@@ -2356,7 +2449,7 @@ static lv_res_t _create_window_battery_status(lv_obj_t *btn)
 		strcat(txt_buf, "Charge terminated\n");
 		break;
 	default:
-		s_printf(txt_buf + strlen(txt_buf), "Unknown (%d)\n", value);
+		s_printf(txt_buf + strlen(txt_buf), "Unknown (%d)\n", sns->charge_status);
 		break;
 	}
 
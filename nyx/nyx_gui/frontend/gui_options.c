@@ -1318,14 +1318,16 @@ lv_res_t create_win_nyx_options(lv_obj_t *parrent_btn)
 		"Off (Fastest)\n"
 		"Sparse (Fast)    \n"
 		"Full (Slow)\n"
-		"Full (Hashes)");
+		"Full (Hashes)\n"
+		"Full (Inline)");
 	lv_ddlist_set_selected(ddlist2, n_cfg.verification);
 	lv_obj_align(ddlist2, label_txt, LV_ALIGN_OUT_RIGHT_MID, LV_DPI * 3 / 8, 0);
 	lv_ddlist_set_action(ddlist2, _data_verification_action);
 
 	label_txt2 = lv_label_create(sw_h3, NULL);
 	lv_label_set_static_text(label_txt2, "Set the type of data verification done for backup and restore.\n"
-		"Can be canceled without losing the backup/restore.\n");
+		"Can be canceled without losing the backup/restore.\n"
+		"Inline hashes eMMC data while backing up and saves them.\n");
 	lv_obj_set_style(label_txt2, &hint_small_style);
 	lv_obj_align(label_txt2, label_txt, LV_ALIGN_OUT_BOTTOM_LEFT, 0, LV_DPI / 4);
 
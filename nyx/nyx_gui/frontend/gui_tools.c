@@ -414,6 +414,7 @@ lv_res_t action_ums_sd(lv_obj_t *btn)
 	usbs.offset = 0;
 	usbs.sectors = 0;
 	usbs.ro = 0;
+	usbs.write_cache = n_cfg.ums_write_cache;
 	usbs.system_maintenance = &manual_system_maintenance;
 	usbs.set_text = &usb_gadget_set_text;
 
@@ -433,6 +434,7 @@ static lv_res_t _action_ums_emmc_boot0(lv_obj_t *btn)
 	usbs.offset = 0;
 	usbs.sectors = 0;
 	usbs.ro = usb_msc_emmc_read_only;
+	usbs.write_cache = 0;
 	usbs.system_maintenance = &manual_system_maintenance;
 	usbs.set_text = &usb_gadget_set_text;
 
@@ -452,6 +454,7 @@ static lv_res_t _action_ums_emmc_boot1(lv_obj_t *btn)
 	usbs.offset = 0;
 	usbs.sectors = 0;
 	usbs.ro = usb_msc_emmc_read_only;
+	usbs.write_cache = 0;
 	usbs.system_maintenance = &manual_system_maintenance;
 	usbs.set_text = &usb_gadget_set_text;
 
@@ -471,6 +474,7 @@ static lv_res_t _action_ums_emmc_gpp(lv_obj_t *btn)
 	usbs.offset = 0;
 	usbs.sectors = 0;
 	usbs.ro = usb_msc_emmc_read_only;
+	usbs.write_cache = 0;
 	usbs.system_maintenance = &manual_system_maintenance;
 	usbs.set_text = &usb_gadget_set_text;
 
@@ -518,6 +522,7 @@ static lv_res_t _action_ums_emuemmc_boot0(lv_obj_t *btn)
 		usbs.partition = EMMC_BOOT0 + 1;
 		usbs.sectors = 0x2000; // Forced 4MB.
 		usbs.ro = usb_msc_emmc_read_only;
+		usbs.write_cache = 0;
 		usbs.system_maintenance = &manual_system_maintenance;
 		usbs.set_text = &usb_gadget_set_text;
 		_create_mbox_ums(&usbs);
@@ -565,6 +570,7 @@ static lv_res_t _action_ums_emuemmc_boot1(lv_obj_t *btn)
 		usbs.partition = EMMC_BOOT1 + 1;
 		usbs.sectors = 0x2000; // Forced 4MB.
 		usbs.ro = usb_msc_emmc_read_only;
+		usbs.write_cache = 0;
 		usbs.system_maintenance = &manual_system_maintenance;
 		usbs.set_text = &usb_gadget_set_text;
 		_create_mbox_ums(&usbs);
@@ -621,6 +627,7 @@ static lv_res_t _action_ums_emuemmc_gpp(lv_obj_t *btn)
 		usbs.type = MMC_SD;
 		usbs.partition = EMMC_GPP + 1;
 		usbs.ro = usb_msc_emmc_read_only;
+		usbs.write_cache = 0;
 		usbs.system_maintenance = &manual_system_maintenance;
 		usbs.set_text = &usb_gadget_set_text;
 		_create_mbox_ums(&usbs);
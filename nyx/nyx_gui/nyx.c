@@ -286,6 +286,12 @@ skip_main_cfg_parse:
 					n_cfg.jc_force_right = atoi(kv->val) == 1;
 				else if (!strcmp("bpmpclock",    kv->key))
 					n_cfg.bpmp_clock     = atoi(kv->val);
+				else if (!strcmp("sparsebackup", kv->key))
+					n_cfg.sparse_backup  = atoi(kv->val) == 1;
+				else if (!strcmp("compressbackup", kv->key))
+					n_cfg.compress_backup = atoi(kv->val) == 1;
+				else if (!strcmp("umswritecache", kv->key))
+					n_cfg.ums_write_cache = atoi(kv->val) == 1;
 			}
 
 			break;
@@ -451,18 +457,22 @@ void nyx_init_load_res()
 	}
 
 	// Train DRAM and switch to max frequency.
+	TRACE_BEGIN(TRACE_MINERVA_INIT, 0);
 	minerva_init();
+	TRACE_END(TRACE_MINERVA_INIT, 0);
 
 	// Load hekate/Nyx configuration.
 	_load_saved_configuration();
 
 	// Load Nyx resources.
+	TRACE_BEGIN(TRACE_NYX_RES_LOAD, 0);
 	if (nyx_load_resources())
 	{
 		// Try again.
 		if (nyx_load_resources())
 			_show_errors(SD_FILE_ERROR); // Fatal since resources are mandatory.
 	}
+	TRACE_END(TRACE_NYX_RES_LOAD, 0);
 
 	// Initialize nyx cfg to lower clock on first boot.
 	// In case of lower binned SoC, this can help with hangs.
@@ -495,6 +505,9 @@ void nyx_init_load_res()
 	// Load default launch icons and background if it exists.
 	nyx_load_bg_icons();
 
+	// Save boot trace, including the hekate part.
+	trace_save("nyx");
+
 	// Unmount FAT partition.
 	sd_unmount();
 }
@@ -504,6 +517,10 @@ void ipl_main()
 	// Set heap address.
 	heap_init((void *)IPL_HEAP_START);
 
+	// Continue boot tracing from hekate.
+	trace_init((trace_buf_t *)&nyx_str->trace, false);
+	TRACE_POINT(TRACE_NYX_MAIN, 0);
+
 	b_cfg = (boot_cfg_t *)(nyx_str->hekate + 0x94);
 
 #ifdef DEBUG_UART_PORT
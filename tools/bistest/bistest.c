@@ -0,0 +1,410 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Replays sector access traces against the BIS driver natively.
+// eMMC and SE are mocked with a RAM disk and a position keyed XOR cipher,
+// so every read is checked against a plaintext shadow and wrong tweak
+// offsets or lost write-backs show up as data mismatches.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <memory_map.h>
+#include <utils/types.h>
+
+// Cache and lookup table live in host memory.
+static u8 cache_mem[NX_BIS_CACHE_SZ] __attribute__((aligned(64)));
+static u8 lookup_mem[NX_BIS_LOOKUP_SZ] __attribute__((aligned(64)));
+#undef  NX_BIS_CACHE_ADDR
+#undef  NX_BIS_LOOKUP_ADDR
+#define NX_BIS_CACHE_ADDR  cache_mem
+#define NX_BIS_LOOKUP_ADDR lookup_mem
+
+// Build the driver in, with the bdk allocator renamed so it doesn't clash with the host one.
+#define malloc bdk_malloc
+#define calloc bdk_calloc
+#define zalloc bdk_zalloc
+#define free   bdk_free
+#include <storage/nx_emmc_bis.c>
+#undef malloc
+#undef calloc
+#undef zalloc
+#undef free
+
+#define HOT_SIZE (4 * 1024 * 1024) // FAT and directory clusters.
+
+static u8 *disk;
+static u8 *shadow;
+static u32 part_sectors;
+
+static u64 disk_reads, disk_writes, disk_rd_sct, disk_wr_sct;
+static nx_emmc_bis_cache_stats_t total; // Cache stats are reset on every init.
+
+sdmmc_storage_t sd_storage, emmc_storage;
+
+static u32 rng_state = 0x12345678;
+
+static u32 _rand()
+{
+	// xorshift32.
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+
+	return rng_state;
+}
+
+static void _mock_crypt(u32 ks, u64 offset, void *dst, void *src, u32 size)
+{
+	u32 *pdst = (u32 *)dst;
+	u32 *psrc = (u32 *)src;
+
+	// Keystream depends on keyslot and absolute partition offset.
+	for (u32 i = 0; i < size / 4; i++)
+	{
+		u64 word = (offset >> 2) + i;
+		u32 key = (u32)word * 0x9E3779B1 ^ (u32)(word >> 32) ^ (ks << 24);
+		pdst[i] = psrc[i] ^ key ^ (key >> 15);
+	}
+}
+
+int se_aes_xts_crypt_sec_nx(u32 tweak_ks, u32 crypt_ks, u32 enc, u64 sec, u8 *tweak, bool regen_tweak, u32 tweak_exp, void *dst, void *src, u32 sec_size)
+{
+	// The driver always regenerates the tweak for whole or partial clusters.
+	if (!regen_tweak)
+		return 0;
+
+	_mock_crypt(crypt_ks ^ (tweak_ks << 4), sec * BIS_CLUSTER_SIZE + tweak_exp * EMMC_BLOCKSIZE, dst, src, sec_size);
+
+	return 1;
+}
+
+int se_aes_xts_crypt_multi_nx(u32 tweak_ks, u32 crypt_ks, u32 enc, u64 sec, u32 sec_off, void *dst, void *src, u32 size, u32 sec_size)
+{
+	_mock_crypt(crypt_ks ^ (tweak_ks << 4), sec * sec_size + sec_off, dst, src, size);
+
+	return 1;
+}
+
+int emmc_part_read(emmc_part_t *part, u32 sector_off, u32 num_sectors, void *buf)
+{
+	if (sector_off + num_sectors > part_sectors)
+		return 0;
+
+	memcpy(buf, disk + (u64)sector_off * EMMC_BLOCKSIZE, num_sectors * EMMC_BLOCKSIZE);
+	disk_reads++;
+	disk_rd_sct += num_sectors;
+
+	return 1;
+}
+
+int emmc_part_write(emmc_part_t *part, u32 sector_off, u32 num_sectors, void *buf)
+{
+	if (sector_off + num_sectors > part_sectors)
+		return 0;
+
+	memcpy(disk + (u64)sector_off * EMMC_BLOCKSIZE, buf, num_sectors * EMMC_BLOCKSIZE);
+	disk_writes++;
+	disk_wr_sct += num_sectors;
+
+	return 1;
+}
+
+int sdmmc_storage_read_sg(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, sdmmc_dma_seg_t *segs, u32 num_segs)
+{
+	// Partition starts at 0 and emuMMC is not used.
+	if (storage != &emmc_storage || sector + num_sectors > part_sectors)
+		return 0;
+
+	u8 *src = disk + (u64)sector * EMMC_BLOCKSIZE;
+	u32 size = num_sectors * EMMC_BLOCKSIZE;
+	for (u32 i = 0; i < num_segs && size; i++)
+	{
+		u32 seg_size = MIN(segs[i].size, size);
+		memcpy(segs[i].buf, src, seg_size);
+		src += seg_size;
+		size -= seg_size;
+	}
+	if (size)
+		return 0;
+
+	disk_reads++;
+	disk_rd_sct += num_sectors;
+
+	return 1;
+}
+
+// emuMMC path. Only used if an offset is passed to init, which this tool doesn't.
+int sdmmc_storage_read(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
+{
+	return 0;
+}
+
+int sdmmc_storage_write(sdmmc_storage_t *storage, u32 sector, u32 num_sectors, void *buf)
+{
+	return 0;
+}
+
+static void _stats_add()
+{
+	nx_emmc_bis_cache_stats_t stats;
+	nx_emmc_bis_cache_stats(&stats);
+
+	total.hits       += stats.hits;
+	total.misses     += stats.misses;
+	total.evictions  += stats.evictions;
+	total.writebacks += stats.writebacks;
+	total.cached      = stats.cached;
+	total.dirty       = stats.dirty;
+}
+
+static void _fill(u32 sector, u32 count)
+{
+	u8 *p = shadow + (u64)sector * EMMC_BLOCKSIZE;
+	for (u32 i = 0; i < count * EMMC_BLOCKSIZE; i++)
+		p[i] = _rand();
+}
+
+static int _do_op(char type, u32 sector, u32 count, u64 op)
+{
+	static u8 buf[256 * EMMC_BLOCKSIZE] __attribute__((aligned(8)));
+
+	if (type == 'f')
+	{
+		// Unmount and mount again. Flushes dirty clusters and starts cold.
+		emmc_part_t *part = system_part;
+		bool enabled = bis_cache->enabled;
+		nx_emmc_bis_end();
+		_stats_add();
+		nx_emmc_bis_init(part, enabled, 0);
+
+		return 0;
+	}
+
+	if (!count || count > 256 || sector >= part_sectors || count > part_sectors - sector)
+		return 0;
+
+	switch (type)
+	{
+	case 'r':
+		if (!nx_emmc_bis_read(sector, count, buf))
+		{
+			fprintf(stderr, "Read failed at op %llu!\n", (unsigned long long)op);
+			return 1;
+		}
+		if (memcmp(buf, shadow + (u64)sector * EMMC_BLOCKSIZE, count * EMMC_BLOCKSIZE))
+		{
+			fprintf(stderr, "Read mismatch at op %llu (sector %x count %u)!\n", (unsigned long long)op, sector, count);
+			return 1;
+		}
+		break;
+
+	case 'w':
+		_fill(sector, count);
+		memcpy(buf, shadow + (u64)sector * EMMC_BLOCKSIZE, count * EMMC_BLOCKSIZE);
+		if (!nx_emmc_bis_write(sector, count, buf))
+		{
+			fprintf(stderr, "Write failed at op %llu!\n", (unsigned long long)op);
+			return 1;
+		}
+		break;
+	}
+
+	return 0;
+}
+
+static void _usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [-n ops] [-p part_mib] [-s seed] [-u] [-t trace] [-w trace]\n"
+		"  -u disables the cluster cache.\n"
+		"  -t replays a trace file. Lines are 'r <sector> <count>', 'w <sector> <count>' or 'f'.\n"
+		"  -w writes the generated random trace.\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	u64 num_ops = 1000000;
+	u32 part_mib = 320; // Bigger than the cache, so evictions happen.
+	bool enable_cache = true;
+	const char *trace_in = NULL;
+	const char *trace_out = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-u"))
+		{
+			enable_cache = false;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+		{
+			_usage(argv[0]);
+			return 1;
+		}
+
+		if (!strcmp(argv[i], "-n"))
+			num_ops = strtoull(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-p"))
+			part_mib = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-s"))
+			rng_state = strtoul(argv[++i], NULL, 0) | 1;
+		else if (!strcmp(argv[i], "-t"))
+			trace_in = argv[++i];
+		else if (!strcmp(argv[i], "-w"))
+			trace_out = argv[++i];
+		else
+		{
+			_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (part_mib < 8)
+		part_mib = 8;
+
+	FILE *fin = NULL, *fout = NULL;
+	if (trace_in && !(fin = fopen(trace_in, "r")))
+	{
+		fprintf(stderr, "Failed to open %s\n", trace_in);
+		return 1;
+	}
+	if (trace_out && !(fout = fopen(trace_out, "w")))
+	{
+		fprintf(stderr, "Failed to create %s\n", trace_out);
+		return 1;
+	}
+
+	u64 part_size = (u64)part_mib << 20;
+	part_sectors = part_size / EMMC_BLOCKSIZE;
+	disk = malloc(part_size);
+	shadow = malloc(part_size);
+	if (!disk || !shadow)
+	{
+		fprintf(stderr, "Out of memory!\n");
+		return 1;
+	}
+
+	emmc_part_t part = {0};
+	strcpy(part.name, "SYSTEM");
+	part.lba_end = part_sectors - 1;
+
+	// Create the encrypted image.
+	_fill(0, part_sectors);
+	_mock_crypt(4 ^ (5 << 4), 0, disk, shadow, part_size);
+
+	nx_emmc_bis_init(&part, enable_cache, 0);
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	u64 op = 0;
+	int res = 0;
+	while (!res)
+	{
+		char type;
+		u32 sector = 0, count = 0;
+
+		if (fin)
+		{
+			char line[64];
+			if (!fgets(line, sizeof(line), fin))
+				break;
+			if (sscanf(line, " %c %u %u", &type, &sector, &count) < 1)
+				continue;
+		}
+		else
+		{
+			if (op >= num_ops)
+				break;
+
+			// Mostly small FAT and directory accesses, with some file data streams.
+			u32 r = _rand();
+			type = (r % 100) < 25 ? 'w' : 'r';
+			if (!(r % 100000))
+				type = 'f';
+			if ((_rand() % 100) < 60)
+			{
+				sector = _rand() % (HOT_SIZE / EMMC_BLOCKSIZE);
+				count = (_rand() % 8) + 1;
+			}
+			else
+			{
+				sector = _rand() % part_sectors;
+				count = (_rand() % 256) + 1;
+			}
+
+			if (fout)
+			{
+				if (type == 'f')
+					fprintf(fout, "f\n");
+				else
+					fprintf(fout, "%c %u %u\n", type, sector, count);
+			}
+		}
+
+		res = _do_op(type, sector, count, op);
+		op++;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	// Dirty count is only meaningful before the final flush.
+	u32 dirty = bis_cache->dirty_cnt;
+
+	// Flush and check that the encrypted image matches everything written.
+	nx_emmc_bis_end();
+	_stats_add();
+	u8 *plain = malloc(BIS_CLUSTER_SIZE);
+	for (u32 i = 0; i < part_size / BIS_CLUSTER_SIZE && !res; i++)
+	{
+		_mock_crypt(4 ^ (5 << 4), (u64)i * BIS_CLUSTER_SIZE, plain, disk + (u64)i * BIS_CLUSTER_SIZE, BIS_CLUSTER_SIZE);
+		if (memcmp(plain, shadow + (u64)i * BIS_CLUSTER_SIZE, BIS_CLUSTER_SIZE))
+		{
+			fprintf(stderr, "Image mismatch at cluster %u after flush!\n", i);
+			res = 1;
+		}
+	}
+	free(plain);
+
+	double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("%s: %llu ops in %.2fs, %.0f ops/s, cache %s\n", res ? "FAIL" : "OK",
+		(unsigned long long)op, secs, op / secs, enable_cache ? "on" : "off");
+	printf("Storage: %llu reads (%llu MiB), %llu writes (%llu MiB)\n",
+		(unsigned long long)disk_reads, (unsigned long long)(disk_rd_sct >> 11),
+		(unsigned long long)disk_writes, (unsigned long long)(disk_wr_sct >> 11));
+	if (enable_cache)
+	{
+		u64 lookups = (u64)total.hits + total.misses;
+		printf("Cache: %u hits, %u misses (%.1f%% hit rate), %u evictions, %u write-backs, %u cached, %u dirty before flush\n",
+			total.hits, total.misses, lookups ? total.hits * 100.0 / lookups : 0.0,
+			total.evictions, total.writebacks, total.cached, dirty);
+	}
+
+	free(disk);
+	free(shadow);
+	if (fin)
+		fclose(fin);
+	if (fout)
+		fclose(fout);
+
+	return res;
+}
@@ -0,0 +1,427 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Round trip and speed test for bdk's BLZ decoder.
+// Compresses generated data (or a given file) with a simple BLZ encoder, then checks
+// that bdk's decoder output is byte identical to the input and to the reference
+// kernel style decoder. Corrupted streams must also decode identically in both.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <libs/compr/blz.h>
+
+#define SEG_SIZE_MIN 3
+#define SEG_SIZE_MAX (0xF + 3)
+#define SEG_OFS_MIN  3
+#define SEG_OFS_MAX  (0xFFF + 3)
+
+#define HASH_BITS    16
+#define CHAIN_DEPTH  64
+
+#define SLACK        0x2000 // Guard for reads of corrupted streams.
+#define BENCH_LOOPS  20
+
+// Reference decoder, same as the kernel one.
+// Kernel doesn't check the control byte read. underflow reports it, so corrupted streams that would
+// read before the buffer can be skipped. Decoding is otherwise unchanged.
+static int _blz_uncompress_ref(u8 *data, u32 comp_size, const blz_footer *footer, bool *underflow)
+{
+	u32 addl_size = footer->addl_size;
+	u32 header_size = footer->header_size;
+	u32 cmp_and_hdr_size = footer->cmp_and_hdr_size;
+
+	u8 *cmp_start = &data[comp_size] - cmp_and_hdr_size;
+	u32 cmp_ofs = cmp_and_hdr_size - header_size;
+	u32 out_ofs = cmp_and_hdr_size + addl_size;
+
+	while (out_ofs)
+	{
+		if (!cmp_ofs)
+		{
+			*underflow = true;
+			return 0;
+		}
+
+		u8 control = cmp_start[--cmp_ofs];
+		for (u32 i = 0; i < 8; i++)
+		{
+			if (control & 0x80)
+			{
+				if (cmp_ofs < 2)
+					return 0;
+
+				cmp_ofs -= 2;
+				u16 seg_val = ((u32)(cmp_start[cmp_ofs + 1]) << 8) | cmp_start[cmp_ofs];
+				u32 seg_size = ((seg_val >> 12) & 0xF) + 3;
+				u32 seg_ofs = (seg_val & 0x0FFF) + 3;
+
+				if (out_ofs < seg_size)
+					seg_size = out_ofs;
+
+				out_ofs -= seg_size;
+
+				for (u32 j = 0; j < seg_size; j++)
+					cmp_start[out_ofs + j] = cmp_start[out_ofs + j + seg_ofs];
+			}
+			else
+			{
+				if (cmp_ofs < 1)
+					return 0;
+
+				cmp_start[--out_ofs] = cmp_start[--cmp_ofs];
+			}
+
+			control <<= 1;
+
+			if (!out_ofs)
+				return 1;
+		}
+	}
+
+	return 1;
+}
+
+static u32 _hash3(const u8 *p)
+{
+	return ((p[0] << 16 | p[1] << 8 | p[2]) * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Greedy LZ on the reversed data. Returns the forward stream size.
+// Matches never overlap themselves, since the decoder copies them backwards.
+static u32 _lz_reverse(const u8 *rev, u32 size, u8 *out)
+{
+	int *head = malloc(sizeof(int) << HASH_BITS);
+	int *prev = malloc(sizeof(int) * size);
+	memset(head, 0xFF, sizeof(int) << HASH_BITS);
+
+	u32 pos = 0, out_pos = 0;
+	while (pos < size)
+	{
+		u32 ctrl_pos = out_pos++;
+		u8 control = 0;
+
+		for (u32 i = 0; i < 8 && pos < size; i++)
+		{
+			u32 best_len = 0, best_ofs = 0;
+
+			if (pos + SEG_SIZE_MIN <= size)
+			{
+				int cand = head[_hash3(&rev[pos])];
+				for (u32 depth = 0; cand >= 0 && depth < CHAIN_DEPTH; depth++, cand = prev[cand])
+				{
+					u32 ofs = pos - cand;
+					if (ofs > SEG_OFS_MAX)
+						break;
+					if (ofs < SEG_OFS_MIN)
+						continue;
+
+					u32 max_len = MIN(MIN(SEG_SIZE_MAX, ofs), size - pos);
+					u32 len = 0;
+					while (len < max_len && rev[cand + len] == rev[pos + len])
+						len++;
+
+					if (len > best_len)
+					{
+						best_len = len;
+						best_ofs = ofs;
+					}
+				}
+			}
+
+			u32 adv = 1;
+			if (best_len >= SEG_SIZE_MIN)
+			{
+				u32 seg_val = ((best_len - 3) << 12) | (best_ofs - 3);
+				out[out_pos++] = seg_val >> 8;
+				out[out_pos++] = seg_val & 0xFF;
+				control |= 0x80 >> i;
+				adv = best_len;
+			}
+			else
+				out[out_pos++] = rev[pos];
+
+			for (u32 j = 0; j < adv; j++, pos++)
+			{
+				if (pos + SEG_SIZE_MIN <= size)
+				{
+					u32 h = _hash3(&rev[pos]);
+					prev[pos] = head[h];
+					head[h] = pos;
+				}
+			}
+		}
+
+		out[ctrl_pos] = control;
+	}
+
+	free(head);
+	free(prev);
+
+	return out_pos;
+}
+
+// Compresses data[raw..size) and keeps data[0..raw) uncompressed. Returns compressed file size or 0.
+static u32 _blz_compress(const u8 *data, u32 size, u32 raw, u8 *out)
+{
+	u32 cmp_size = size - raw;
+	u8 *rev = malloc(cmp_size + 1);
+	u8 *fwd = malloc(cmp_size + cmp_size / 8 + 16);
+
+	for (u32 i = 0; i < cmp_size; i++)
+		rev[i] = data[size - 1 - i];
+
+	u32 stream = _lz_reverse(rev, cmp_size, fwd);
+
+	// Uncompressed part, reversed stream, padding and footer.
+	u32 pad = (4 - ((raw + stream) & 3)) & 3;
+	blz_footer footer;
+	footer.header_size = sizeof(blz_footer) + pad;
+	footer.cmp_and_hdr_size = stream + footer.header_size;
+
+	u32 res = 0;
+	if (footer.cmp_and_hdr_size <= cmp_size)
+	{
+		footer.addl_size = cmp_size - footer.cmp_and_hdr_size;
+
+		memcpy(out, data, raw);
+		for (u32 i = 0; i < stream; i++)
+			out[raw + i] = fwd[stream - 1 - i];
+		memset(out + raw + stream, 0xFF, pad);
+		memcpy(out + raw + stream + pad, &footer, sizeof(blz_footer));
+
+		res = raw + footer.cmp_and_hdr_size;
+	}
+
+	free(rev);
+	free(fwd);
+
+	return res;
+}
+
+static u64 _get_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (u64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static u32 rng_state = 0x2545F491;
+
+static u32 _rand()
+{
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+
+	return rng_state;
+}
+
+// Generates code like, sparse or text like data.
+static void _gen_data(u8 *buf, u32 size, u32 kind)
+{
+	static const u32 dict[] = { 0xE92D4FF0, 0xE8BD8FF0, 0xE3A00000, 0xE12FFF1E, 0xEB000000, 0xE5900000, 0xE1A00000, 0x00000000 };
+
+	for (u32 i = 0; i < size; i += 4)
+	{
+		u32 word;
+		switch (kind)
+		{
+		case 0: // Code like.
+			word = dict[_rand() & 7] | ((_rand() & 3) ? 0 : (_rand() & 0xFFF));
+			break;
+		case 1: // Zero runs with noise.
+			word = (_rand() & 31) ? 0 : _rand();
+			break;
+		default: // Text like.
+			word = 0x20202020 | (_rand() & 0x07070707);
+			break;
+		}
+		memcpy(buf + i, &word, MIN(4, size - i));
+	}
+}
+
+static int _test_one(const u8 *data, u32 size, double *ref_mbs, double *new_mbs, u32 *comp_out)
+{
+	u8 *comp = malloc(size + SLACK);
+	u8 *buf_ref = malloc(size + SLACK);
+	u8 *buf_new = malloc(size + SLACK);
+	int res = 1;
+
+	// Keep part of the start uncompressed until in-place decoding doesn't overwrite unread input.
+	u32 comp_size = 0;
+	u32 raw = 0;
+	while (raw < size)
+	{
+		comp_size = _blz_compress(data, size, raw, comp);
+		if (!comp_size)
+			break;
+
+		memset(buf_ref, 0, size + SLACK);
+		memcpy(buf_ref, comp, comp_size);
+		blz_footer footer;
+		blz_get_footer(buf_ref, comp_size, &footer);
+		bool underflow = false;
+		if (_blz_uncompress_ref(buf_ref, comp_size, &footer, &underflow) && !memcmp(buf_ref, data, size))
+			break;
+
+		raw += MAX(16, (size - raw) / 64);
+		comp_size = 0;
+	}
+
+	if (!comp_size)
+	{
+		printf("  Data not compressible, skipped.\n");
+		res = 0;
+		goto out;
+	}
+	*comp_out = comp_size;
+
+	// Round trip through bdk's decoder.
+	if (!blz_uncompress_srcdest(comp, comp_size, buf_new, size) || memcmp(buf_new, data, size))
+	{
+		fprintf(stderr, "  Round trip mismatch!\n");
+		goto out;
+	}
+
+	// Speed. Input must be restored every loop, since decoding is in place.
+	blz_footer footer;
+	blz_get_footer(comp, comp_size, &footer);
+	u64 t_ref = 0, t_new = 0;
+	for (u32 i = 0; i < BENCH_LOOPS; i++)
+	{
+		memcpy(buf_ref, comp, comp_size);
+		bool underflow = false;
+		u64 t = _get_ns();
+		_blz_uncompress_ref(buf_ref, comp_size, &footer, &underflow);
+		t_ref += _get_ns() - t;
+
+		memcpy(buf_new, comp, comp_size);
+		t = _get_ns();
+		blz_uncompress_inplace(buf_new, comp_size, &footer);
+		t_new += _get_ns() - t;
+	}
+	*ref_mbs = (double)size * BENCH_LOOPS / (t_ref / 1e9) / 1e6;
+	*new_mbs = (double)size * BENCH_LOOPS / (t_new / 1e9) / 1e6;
+
+	// Corrupted streams. Both decoders must agree on result and output.
+	u32 tested = 0;
+	for (u32 i = 0; i < 1000 && tested < 200; i++)
+	{
+		memset(buf_ref, 0, size + SLACK);
+		memcpy(buf_ref, comp, comp_size);
+		u32 flips = 1 + (_rand() & 7);
+		for (u32 j = 0; j < flips; j++)
+			buf_ref[footer.cmp_and_hdr_size > footer.header_size ?
+				comp_size - footer.cmp_and_hdr_size + _rand() % (footer.cmp_and_hdr_size - footer.header_size) : 0] ^= 1 << (_rand() & 7);
+		memcpy(buf_new, buf_ref, size + SLACK);
+
+		// Skip streams that would also crash the kernel.
+		bool underflow = false;
+		int r_ref = _blz_uncompress_ref(buf_ref, comp_size, &footer, &underflow);
+		if (underflow)
+			continue;
+		tested++;
+
+		int r_new = blz_uncompress_inplace(buf_new, comp_size, &footer);
+		if (r_ref != r_new || memcmp(buf_ref, buf_new, size + SLACK))
+		{
+			fprintf(stderr, "  Corrupted stream %d decoded differently!\n", i);
+			goto out;
+		}
+	}
+
+	res = 0;
+
+out:
+	free(comp);
+	free(buf_ref);
+	free(buf_new);
+
+	return res;
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *kind_names[] = { "code", "zeros", "text" };
+	int failed = 0;
+
+	if (argc > 2)
+	{
+		fprintf(stderr, "Usage: %s [file]\n", argv[0]);
+		return 1;
+	}
+
+	u32 sizes[] = { 1, 3, 17, 100, 4096, 65537, 0x400000 };
+	for (u32 kind = 0; kind < 3 && argc == 1; kind++)
+	{
+		for (u32 s = 0; s < sizeof(sizes) / sizeof(u32); s++)
+		{
+			u32 size = sizes[s];
+			u8 *data = malloc(size);
+			_gen_data(data, size, kind);
+
+			printf("%-5s %8u bytes:\n", kind_names[kind], size);
+			double ref_mbs = 0, new_mbs = 0;
+			u32 comp_size = 0;
+			if (_test_one(data, size, &ref_mbs, &new_mbs, &comp_size))
+				failed = 1;
+			else if (comp_size)
+				printf("  -> %8u bytes, ref %7.1f MB/s, bdk %7.1f MB/s\n", comp_size, ref_mbs, new_mbs);
+
+			free(data);
+		}
+	}
+
+	if (argc == 2)
+	{
+		FILE *f = fopen(argv[1], "rb");
+		if (!f)
+		{
+			perror(argv[1]);
+			return 1;
+		}
+		fseek(f, 0, SEEK_END);
+		u32 size = ftell(f);
+		fseek(f, 0, SEEK_SET);
+		u8 *data = malloc(size);
+		if (fread(data, 1, size, f) != size)
+		{
+			perror(argv[1]);
+			return 1;
+		}
+		fclose(f);
+
+		printf("%s %u bytes:\n", argv[1], size);
+		double ref_mbs = 0, new_mbs = 0;
+		u32 comp_size = 0;
+		if (_test_one(data, size, &ref_mbs, &new_mbs, &comp_size))
+			failed = 1;
+		else if (comp_size)
+			printf("  -> %8u bytes, ref %7.1f MB/s, bdk %7.1f MB/s\n", comp_size, ref_mbs, new_mbs);
+
+		free(data);
+	}
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+
+	return failed;
+}
@@ -0,0 +1,360 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Replays alloc/realloc/free traces against the bdk heap natively.
+// Every live block is pattern checked and the node list and free bins
+// are validated after each operation.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Build bdk heap in, renamed so it doesn't replace the host allocator.
+#define malloc bdk_malloc
+#define calloc bdk_calloc
+#define zalloc bdk_zalloc
+#define free   bdk_free
+#include <mem/heap.c>
+#undef malloc
+#undef calloc
+#undef zalloc
+#undef free
+
+#define ARENA_SIZE (256 * 1024 * 1024)
+#define SLOTS_MAX  4096
+
+typedef struct _slot_t
+{
+	u8 *buf;
+	u32 size;
+	u32 seed;
+} slot_t;
+
+static u8 arena[ARENA_SIZE] __attribute__((aligned(64)));
+static slot_t slots[SLOTS_MAX];
+static heap_t heap;
+
+static u32 rng_state;
+
+static u32 _rand()
+{
+	// xorshift32.
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+
+	return rng_state;
+}
+
+static void _fill(slot_t *s)
+{
+	u32 v = s->seed;
+	for (u32 i = 0; i < s->size; i++)
+	{
+		v = v * 1103515245 + 12345;
+		s->buf[i] = v >> 16;
+	}
+}
+
+static int _verify(slot_t *s, u32 size)
+{
+	u32 v = s->seed;
+	for (u32 i = 0; i < size; i++)
+	{
+		v = v * 1103515245 + 12345;
+		if (s->buf[i] != (u8)(v >> 16))
+			return 1;
+	}
+
+	return 0;
+}
+
+static int _check_heap(u64 op)
+{
+	u32 free_nodes = 0;
+	hnode_t *node = heap.first;
+	hnode_t *prev = NULL;
+
+	while (node)
+	{
+		if ((u8 *)node < (u8 *)heap.start || (u8 *)node + sizeof(hnode_t) + node->size > (u8 *)heap.end)
+			goto corrupt;
+		if (node->prev != prev)
+			goto corrupt;
+		if (node->size & (sizeof(hnode_t) - 1))
+			goto corrupt;
+
+		// Nodes must be physically contiguous.
+		if (node->next && (u8 *)node->next != (u8 *)node + sizeof(hnode_t) + node->size)
+			goto corrupt;
+
+		if (!node->used)
+		{
+			free_nodes++;
+#ifndef BDK_MALLOC_NO_DEFRAG
+			// Free neighbours must be merged and the top must be returned.
+			if (!node->next || (node->next && !node->next->used))
+				goto corrupt;
+#endif
+		}
+
+		prev = node;
+		node = node->next;
+	}
+
+	if (heap.last != prev)
+		goto corrupt;
+
+#ifndef BDK_MALLOC_NO_DEFRAG
+	// Every free node must be binned once and bitmaps must match the bins.
+	u32 binned = 0;
+	for (u32 fl = 0; fl < HEAP_FL_COUNT; fl++)
+	{
+		for (u32 sl = 0; sl < HEAP_SL_COUNT; sl++)
+		{
+			hnode_t *bin = heap.bins[fl][sl];
+			if (!!bin != !!(heap.sl_bitmap[fl] & BIT(sl)))
+				goto corrupt;
+
+			hnode_t *bin_prev = NULL;
+			while (bin)
+			{
+				if (bin->used || bin->free_prev != bin_prev)
+					goto corrupt;
+				binned++;
+				bin_prev = bin;
+				bin = bin->free_next;
+			}
+		}
+
+		if (!!heap.sl_bitmap[fl] != !!(heap.fl_bitmap & BIT(fl)))
+			goto corrupt;
+	}
+
+	if (binned != free_nodes)
+		goto corrupt;
+#endif
+
+	return 0;
+
+corrupt:
+	fprintf(stderr, "Heap corrupted after op %llu!\n", (unsigned long long)op);
+
+	return 1;
+}
+
+static int _do_op(char type, u32 idx, u32 size, u64 op, u64 *failed)
+{
+	slot_t *s = &slots[idx % SLOTS_MAX];
+
+	switch (type)
+	{
+	case 'a':
+		if (s->buf)
+			return 0;
+		s->buf = heap_pool_alloc(&heap, size);
+		if (!s->buf)
+		{
+			(*failed)++;
+			return 0;
+		}
+		if ((u32)s->buf & (sizeof(hnode_t) - 1))
+		{
+			fprintf(stderr, "Unaligned block after op %llu!\n", (unsigned long long)op);
+			return 1;
+		}
+		s->size = size;
+		s->seed = _rand();
+		_fill(s);
+		break;
+
+	case 'r':
+		if (!s->buf)
+			return 0;
+		u8 *buf = heap_pool_realloc(&heap, s->buf, size);
+		if (!buf)
+		{
+			(*failed)++;
+			return 0;
+		}
+		s->buf = buf;
+		if (_verify(s, MIN(s->size, size)))
+		{
+			fprintf(stderr, "Realloc lost data at op %llu!\n", (unsigned long long)op);
+			return 1;
+		}
+		s->size = size;
+		_fill(s);
+		break;
+
+	case 'f':
+		if (!s->buf)
+			return 0;
+		if (_verify(s, s->size))
+		{
+			fprintf(stderr, "Block overwritten before op %llu!\n", (unsigned long long)op);
+			return 1;
+		}
+		heap_pool_free(&heap, s->buf);
+		s->buf = NULL;
+		break;
+
+	default:
+		return 0;
+	}
+
+	return 0;
+}
+
+static void _usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [-n ops] [-m max_size] [-s seed] [-c check_interval] [-t trace] [-w trace]\n"
+		"  -c validates the whole heap every N ops (default 1000).\n"
+		"  -t replays a trace file. Lines are 'a <slot> <size>', 'r <slot> <size>' or 'f <slot>'.\n"
+		"  -w writes the generated random trace.\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	u64 num_ops = 1000000;
+	u32 max_size = 0x100000;
+	u32 check_interval = 1000;
+	const char *trace_in = NULL;
+	const char *trace_out = NULL;
+	rng_state = 0x12345678;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			_usage(argv[0]);
+			return 1;
+		}
+
+		if (!strcmp(argv[i], "-n"))
+			num_ops = strtoull(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-m"))
+			max_size = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-s"))
+			rng_state = strtoul(argv[++i], NULL, 0) | 1;
+		else if (!strcmp(argv[i], "-c"))
+			check_interval = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-t"))
+			trace_in = argv[++i];
+		else if (!strcmp(argv[i], "-w"))
+			trace_out = argv[++i];
+		else
+		{
+			_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	FILE *fin = NULL, *fout = NULL;
+	if (trace_in && !(fin = fopen(trace_in, "r")))
+	{
+		fprintf(stderr, "Failed to open %s\n", trace_in);
+		return 1;
+	}
+	if (trace_out && !(fout = fopen(trace_out, "w")))
+	{
+		fprintf(stderr, "Failed to create %s\n", trace_out);
+		return 1;
+	}
+
+	heap_pool_init(&heap, arena, ARENA_SIZE);
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	u64 op = 0, failed = 0;
+	int res = 0;
+	while (!res)
+	{
+		char type;
+		u32 idx, size = 0;
+
+		if (fin)
+		{
+			char line[64];
+			if (!fgets(line, sizeof(line), fin))
+				break;
+			if (sscanf(line, " %c %u %u", &type, &idx, &size) < 2)
+				continue;
+		}
+		else
+		{
+			if (op >= num_ops)
+				break;
+
+			// Mostly small blocks, like the real users, with a few big ones.
+			u32 r = _rand();
+			type = (r & 3) == 0 ? 'r' : ((r & 3) == 1 ? 'f' : 'a');
+			idx = _rand() % SLOTS_MAX;
+			size = (_rand() & 7) ? (_rand() % 0x1000) + 1 : (_rand() % max_size) + 1;
+
+			if (fout)
+			{
+				if (type == 'f')
+					fprintf(fout, "f %u\n", idx);
+				else
+					fprintf(fout, "%c %u %u\n", type, idx, size);
+			}
+		}
+
+		res = _do_op(type, idx, size, op, &failed);
+		op++;
+
+		if (!res && check_interval && !(op % check_interval))
+			res = _check_heap(op);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	if (!res)
+		res = _check_heap(op);
+
+	heap_monitor_t mon;
+	heap_pool_monitor(&heap, &mon);
+
+	// Free everything. The heap must be empty afterwards, unless freed blocks are never reused.
+	for (u32 i = 0; i < SLOTS_MAX && !res; i++)
+		res = _do_op('f', i, 0, op, &failed);
+#ifndef BDK_MALLOC_NO_DEFRAG
+	if (!res && heap.first)
+	{
+		fprintf(stderr, "Heap not empty after freeing all blocks!\n");
+		res = 1;
+	}
+#endif
+
+	double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+	printf("%s: %llu ops (%llu out of memory) in %.2fs, %.0f ops/s\n", res ? "FAIL" : "OK",
+		(unsigned long long)op, (unsigned long long)failed, secs, op / secs);
+	printf("Final heap: %u KiB used in %u/%u nodes, %u KiB free below top, %u%% fragmentation\n",
+		mon.used >> 10, mon.nodes_used, mon.nodes_total, mon.free_total >> 10, mon.fragmentation);
+
+	if (fin)
+		fclose(fin);
+	if (fout)
+		fclose(fout);
+
+	return res;
+}
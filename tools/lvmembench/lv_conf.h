@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Host replacement of Nyx lv_conf.h, with only what lv_mem needs.
+// LV_BENCH_BUILTIN selects the original lv_mem allocator over the heap pool.
+
+#ifndef LV_CONF_H
+#define LV_CONF_H
+
+#include <memory_map.h>
+
+extern unsigned char lv_bench_pool[NYX_LV_MEM_SZ];
+
+#ifdef LV_BENCH_BUILTIN
+#define LV_MEM_CUSTOM         0
+#  define LV_MEM_SIZE         NYX_LV_MEM_SZ
+#  define LV_MEM_ATTR
+#  define LV_MEM_ADR          lv_bench_pool
+#  define LV_MEM_AUTO_DEFRAG  1
+#else
+#define LV_MEM_CUSTOM         1
+#  define LV_MEM_CUSTOM_INCLUDE   <mem/heap.h>
+#  define LV_MEM_CUSTOM_POOL      heap_t
+#  define LV_MEM_CUSTOM_ADR       lv_bench_pool
+#  define LV_MEM_CUSTOM_SIZE      NYX_LV_MEM_SZ
+#  define LV_MEM_CUSTOM_INIT      heap_pool_init
+#  define LV_MEM_CUSTOM_ALLOC     heap_pool_alloc
+#  define LV_MEM_CUSTOM_FREE      heap_pool_free
+#  define LV_MEM_CUSTOM_RESIZE    heap_pool_realloc
+#  define LV_MEM_CUSTOM_MONITOR   heap_pool_monitor
+#  define LV_MEM_CUSTOM_MONITOR_T heap_monitor_t
+#endif
+
+#define LV_ENABLE_GC 0
+#define LV_USE_LOG   0
+
+#endif
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// LVGL allocation storm benchmark. Opens and closes windows with many
+// objects, ext data and growing label texts, with background churn, like
+// Nyx does. Built against the heap pool or the original lv_mem allocator.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <utils/types.h>
+
+// Build lv_mem and bdk heap in, with the bdk allocator renamed so it doesn't clash with the host one.
+#define malloc bdk_malloc
+#define calloc bdk_calloc
+#define zalloc bdk_zalloc
+#define free   bdk_free
+#ifndef LV_BENCH_BUILTIN
+#include <mem/heap.c>
+#endif
+#include <libs/lvgl/lv_misc/lv_mem.c>
+#undef malloc
+#undef calloc
+#undef zalloc
+#undef free
+
+#define OBJS_MAX   1500
+#define CHURN_MAX  64
+#define LABEL_MAX  1024
+
+typedef struct _blk_t
+{
+	u8  *buf;
+	u32 size;
+	u8  seed;
+} blk_t;
+
+typedef struct _obj_t
+{
+	blk_t obj;
+	blk_t ext;
+	blk_t text;
+} obj_t;
+
+unsigned char lv_bench_pool[NYX_LV_MEM_SZ] __attribute__((aligned(64)));
+
+static obj_t objs[OBJS_MAX];
+static blk_t churn[CHURN_MAX];
+static u64 allocs, reallocs, frees;
+
+static u32 rng_state = 0x12345678;
+
+static u32 _rand()
+{
+	// xorshift32.
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+
+	return rng_state;
+}
+
+static void _fill(blk_t *b, u32 from)
+{
+	for (u32 i = from; i < b->size; i++)
+		b->buf[i] = b->seed + i;
+}
+
+static int _check(blk_t *b, u32 size)
+{
+	for (u32 i = 0; i < size; i++)
+		if (b->buf[i] != (u8)(b->seed + i))
+			return 1;
+
+	return 0;
+}
+
+static int _alloc(blk_t *b, u32 size)
+{
+	b->buf = lv_mem_alloc(size);
+	if (!b->buf)
+	{
+		fprintf(stderr, "Out of memory!\n");
+		return 1;
+	}
+	b->size = size;
+	b->seed = _rand();
+	_fill(b, 0);
+	allocs++;
+
+	return 0;
+}
+
+static int _realloc(blk_t *b, u32 size)
+{
+	u8 *buf = lv_mem_realloc(b->buf, size);
+	if (!buf)
+	{
+		fprintf(stderr, "Out of memory!\n");
+		return 1;
+	}
+	b->buf = buf;
+	if (_check(b, MIN(b->size, size)))
+	{
+		fprintf(stderr, "Realloc lost data!\n");
+		return 1;
+	}
+	u32 old_size = b->size;
+	b->size = size;
+	if (size > old_size)
+		_fill(b, old_size);
+	reallocs++;
+
+	return 0;
+}
+
+static int _free(blk_t *b)
+{
+	if (!b->buf)
+		return 0;
+
+	if (_check(b, b->size))
+	{
+		fprintf(stderr, "Block overwritten!\n");
+		return 1;
+	}
+	lv_mem_free(b->buf);
+	b->buf = NULL;
+	frees++;
+
+	return 0;
+}
+
+static int _churn()
+{
+	// Timers, tasks and style copies come and go in the background.
+	blk_t *b = &churn[_rand() % CHURN_MAX];
+
+	return _free(b) || _alloc(b, (_rand() % 256) + 16);
+}
+
+static int _window(u32 num_objs)
+{
+	// Create objects with ext data. Every 4th is a label whose text grows.
+	for (u32 i = 0; i < num_objs; i++)
+	{
+		obj_t *o = &objs[i];
+		if (_alloc(&o->obj, 64 + (_rand() % 4) * 32) || _alloc(&o->ext, 32 + (_rand() % 16) * 32))
+			return 1;
+
+		if (!(i % 4))
+		{
+			if (_alloc(&o->text, 16))
+				return 1;
+			for (u32 size = 32; size <= LABEL_MAX; size += 32 + (_rand() % 128))
+				if (_realloc(&o->text, size))
+					return 1;
+		}
+
+		if (!(i % 8) && _churn())
+			return 1;
+	}
+
+	// Close the window. Children go first, but not in allocation order.
+	for (u32 i = 0; i < num_objs; i++)
+	{
+		obj_t *o = &objs[(i * 7919) % num_objs];
+		if (_free(&o->text) || _free(&o->ext) || _free(&o->obj))
+			return 1;
+
+		if (!(i % 16) && _churn())
+			return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	u32 cycles = 600;
+	u32 num_objs = OBJS_MAX;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+			goto usage;
+
+		if (!strcmp(argv[i], "-n"))
+			cycles = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-o"))
+			num_objs = MIN(strtoul(argv[++i], NULL, 0), OBJS_MAX);
+		else if (!strcmp(argv[i], "-s"))
+			rng_state = strtoul(argv[++i], NULL, 0) | 1;
+		else
+			goto usage;
+	}
+
+	lv_mem_init();
+
+	struct timespec t0, t1;
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+
+	int res = 0;
+	for (u32 i = 0; i < cycles && !res; i++)
+		res = _window(num_objs);
+
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+
+	lv_mem_monitor_t mon;
+	lv_mem_monitor(&mon);
+
+	for (u32 i = 0; i < CHURN_MAX && !res; i++)
+		res = _free(&churn[i]);
+
+	double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+#ifdef LV_BENCH_BUILTIN
+	const char *name = "lv_mem";
+#else
+	const char *name = "heap pool";
+#endif
+	printf("%s (%s): %u cycles of %u objects in %.2fs, %llu allocs, %llu reallocs, %llu frees\n",
+		res ? "FAIL" : "OK", name, cycles, num_objs, secs,
+		(unsigned long long)allocs, (unsigned long long)reallocs, (unsigned long long)frees);
+	printf("Before last churn free: %u used, %u free entries, %u%% used, %u%% fragmentation\n",
+		mon.used_cnt, mon.free_cnt, mon.used_pct, mon.frag_pct);
+
+	return res;
+
+usage:
+	fprintf(stderr, "Usage: %s [-n cycles] [-o objects] [-s seed]\n", argv[0]);
+
+	return 1;
+}
@@ -17,26 +17,107 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
+#include <time.h>
 #include <sys/stat.h>
 #include "lz.h"
+#include "lz4.h"
+
+#define BENCH_LOOPS 200
 
 char filename[1024];
 
+static int _compress(bool lz4, uint8_t *in, uint8_t *out, uint32_t in_size, uint32_t out_size, uint32_t *work)
+{
+	if (lz4)
+		return LZ4_compress_default((const char *)in, (char *)out, in_size, out_size);
+
+	return LZ_CompressFast(in, out, in_size, work);
+}
+
+static int _uncompress(bool lz4, uint8_t *in, uint8_t *out, uint32_t in_size, uint32_t out_size)
+{
+	if (lz4)
+		return LZ4_decompress_safe((const char *)in, (char *)out, in_size, out_size);
+
+	return LZ_Uncompress(in, out, in_size);
+}
+
+static int _benchmark(uint8_t *in_buf, uint32_t in_size, uint8_t *out_buf, uint32_t out_size, uint32_t *work)
+{
+	uint8_t *dec_buf = (uint8_t *)malloc(in_size);
+	if (!dec_buf)
+		return 1;
+
+	for (int codec = 0; codec < 2; codec++)
+	{
+		bool lz4 = codec;
+		uint32_t comp_size = 0;
+		double secs = 0;
+
+		// Compress and uncompress both halves, same as the loader.
+		for (int i = 0; i < 2; i++)
+		{
+			uint32_t offset = (in_size / 2) * i;
+			uint32_t in_size_tmp = !i ? in_size / 2 : in_size - (in_size / 2);
+
+			int nbytes = _compress(lz4, in_buf + offset, out_buf, in_size_tmp, out_size, work);
+			if (nbytes <= 0)
+				return 1;
+			comp_size += nbytes;
+
+			clock_t start = clock();
+			for (int j = 0; j < BENCH_LOOPS; j++)
+				_uncompress(lz4, out_buf, dec_buf + offset, nbytes, in_size_tmp);
+			secs += (double)(clock() - start) / CLOCKS_PER_SEC;
+		}
+
+		if (memcmp(in_buf, dec_buf, in_size))
+			return 1;
+
+		printf("%-5s %8u -> %8u bytes (%5.2f%%), uncompress %8.1f MB/s\n", lz4 ? "lz4" : "lz77",
+			in_size, comp_size, comp_size * 100.0 / in_size, (double)in_size * BENCH_LOOPS / secs / 1000000.0);
+	}
+
+	free(dec_buf);
+
+	return 0;
+}
+
 int main(int argc, char *argv[])
 {
 	int nbytes;
 	int filename_len;
 	struct stat statbuf;
 	FILE *in_file, *out_file;
+	bool lz4 = false;
+	bool bench = false;
+
+	// Parse options. Last argument is the file.
+	for (int i = 1; i < argc - 1; i++)
+	{
+		if (!strcmp(argv[i], "-lz4"))
+			lz4 = true;
+		else if (!strcmp(argv[i], "-b"))
+			bench = true;
+	}
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s [-lz4] [-b] <file>\n", argv[0]);
+		exit(1);
+	}
+
+	char *path = argv[argc - 1];
 
-	if(stat(argv[1], &statbuf))
+	if(stat(path, &statbuf))
 		goto error;
 
-	if((in_file=fopen(argv[1], "rb")) == NULL)
+	if((in_file=fopen(path, "rb")) == NULL)
 		goto error;
 
-	strcpy(filename, argv[1]);
+	strcpy(filename, path);
 	filename_len = strlen(filename);
 
 	uint32_t in_size = statbuf.st_size;
@@ -54,6 +135,18 @@ int main(int argc, char *argv[])
 	fclose(in_file);
 
 	uint32_t *work = (uint32_t*)malloc(sizeof(uint32_t) * (in_size + 65536));
+	if (!work)
+		goto error;
+
+	// Compare both codecs.
+	if (bench)
+	{
+		if (_benchmark(in_buf, in_size, out_buf, out_size, work))
+			goto error;
+
+		return 0;
+	}
+
 	for (int i = 0; i < 2; i++)
 	{
 		uint32_t in_size_tmp;
@@ -68,12 +161,9 @@ int main(int argc, char *argv[])
 			strcpy(filename + filename_len, ".01.lz");
 		}
 
-		if (work)
-			nbytes = LZ_CompressFast(in_buf + (in_size / 2) * i, out_buf, in_size_tmp, work);
-		else
-			goto error;
+		nbytes = _compress(lz4, in_buf + (in_size / 2) * i, out_buf, in_size_tmp, out_size, work);
 
-		if (nbytes > out_size)
+		if (nbytes <= 0 || nbytes > out_size)
 			goto error;
 
 		if((out_file = fopen(filename,"wb")) == NULL)
@@ -88,6 +178,6 @@ int main(int argc, char *argv[])
 	return 0;
 
 error:
-	fprintf(stderr, "Failed to compress: %s\n", argv[1]);
+	fprintf(stderr, "Failed to compress: %s\n", path);
 	exit(1);
 }
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Converts between raw eMMC backups and Nyx LZ4 block compressed (.nxlz) backups.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "lz4.h"
+
+#define SECTOR_SIZE  512
+#define BLK_SECTORS  8192 // 4MB. Must match Nyx.
+#define BLK_SIZE     (BLK_SECTORS * SECTOR_SIZE)
+
+#define LZ4B_MAGIC   0x5A4C584E // "NXLZ".
+#define LZ4B_VERSION 1
+
+typedef struct _lz4_blk_t
+{
+	uint64_t offset;
+	uint32_t size;
+	uint32_t sectors;
+	uint8_t  sha256[32];
+} lz4_blk_t;
+
+typedef struct _lz4_hdr_t
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t total_sectors;
+	uint32_t blk_sectors;
+	uint32_t num_blocks;
+	uint32_t index_offset;
+	uint32_t data_offset;
+	uint8_t  rsvd[0x1E4];
+} lz4_hdr_t;
+
+static const uint32_t sha256_k[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROR32(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void _sha256_block(uint32_t *state, const uint8_t *data)
+{
+	uint32_t w[64];
+	for (int i = 0; i < 16; i++)
+		w[i] = (data[i * 4] << 24) | (data[i * 4 + 1] << 16) | (data[i * 4 + 2] << 8) | data[i * 4 + 3];
+	for (int i = 16; i < 64; i++)
+	{
+		uint32_t s0 = ROR32(w[i - 15], 7) ^ ROR32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+		uint32_t s1 = ROR32(w[i - 2], 17) ^ ROR32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+		w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+	}
+
+	uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+	uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+	for (int i = 0; i < 64; i++)
+	{
+		uint32_t t1 = h + (ROR32(e, 6) ^ ROR32(e, 11) ^ ROR32(e, 25)) + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+		uint32_t t2 = (ROR32(a, 2) ^ ROR32(a, 13) ^ ROR32(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+		h = g; g = f; f = e; e = d + t1;
+		d = c; c = b; b = a; a = t1 + t2;
+	}
+
+	state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+	state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+static void _sha256(uint8_t *hash, const uint8_t *data, uint32_t size)
+{
+	uint32_t state[8] = {
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+	uint8_t tail[128] = { 0 };
+	uint32_t full = size & ~63u;
+	uint32_t left = size - full;
+
+	for (uint32_t i = 0; i < full; i += 64)
+		_sha256_block(state, data + i);
+
+	// Pad with 0x80 and the big endian bit length.
+	memcpy(tail, data + full, left);
+	tail[left] = 0x80;
+	uint32_t tail_size = left < 56 ? 64 : 128;
+	uint64_t bits = (uint64_t)size * 8;
+	for (int i = 0; i < 8; i++)
+		tail[tail_size - 1 - i] = bits >> (i * 8);
+
+	_sha256_block(state, tail);
+	if (tail_size == 128)
+		_sha256_block(state, tail + 64);
+
+	for (int i = 0; i < 8; i++)
+	{
+		hash[i * 4]     = state[i] >> 24;
+		hash[i * 4 + 1] = state[i] >> 16;
+		hash[i * 4 + 2] = state[i] >> 8;
+		hash[i * 4 + 3] = state[i];
+	}
+}
+
+static int _compress(FILE *in_file, FILE *out_file)
+{
+	fseeko(in_file, 0, SEEK_END);
+	uint64_t in_size = ftello(in_file);
+	fseeko(in_file, 0, SEEK_SET);
+
+	if (!in_size || (in_size % SECTOR_SIZE) || (in_size / SECTOR_SIZE) > 0xFFFFFFFF)
+		return 1;
+
+	uint32_t total_sectors = in_size / SECTOR_SIZE;
+	uint32_t num_blocks = (total_sectors + BLK_SECTORS - 1) / BLK_SECTORS;
+	uint32_t index_sectors = (num_blocks * sizeof(lz4_blk_t) + SECTOR_SIZE - 1) / SECTOR_SIZE;
+	uint32_t data_offset = 1 + index_sectors;
+
+	uint8_t *hdr_buf = (uint8_t *)calloc(data_offset, SECTOR_SIZE);
+	uint8_t *buf = (uint8_t *)malloc(BLK_SIZE);
+	uint8_t *cbuf = (uint8_t *)malloc(LZ4_COMPRESSBOUND(BLK_SIZE));
+	if (!(hdr_buf && buf && cbuf))
+		return 1;
+
+	lz4_hdr_t *hdr = (lz4_hdr_t *)hdr_buf;
+	lz4_blk_t *index = (lz4_blk_t *)(hdr_buf + SECTOR_SIZE);
+
+	// Reserve header and index.
+	if (fwrite(hdr_buf, SECTOR_SIZE, data_offset, out_file) != data_offset)
+		return 1;
+
+	uint64_t offset = (uint64_t)data_offset * SECTOR_SIZE;
+	for (uint32_t i = 0; i < num_blocks; i++)
+	{
+		uint32_t sectors = total_sectors - i * BLK_SECTORS;
+		if (sectors > BLK_SECTORS)
+			sectors = BLK_SECTORS;
+		uint32_t raw_size = sectors * SECTOR_SIZE;
+
+		if (fread(buf, 1, raw_size, in_file) != raw_size)
+			return 1;
+
+		_sha256(index[i].sha256, buf, raw_size);
+
+		// Store block uncompressed if it doesn't shrink.
+		int comp = LZ4_compress_default((const char *)buf, (char *)cbuf, raw_size, LZ4_COMPRESSBOUND(BLK_SIZE));
+		uint8_t *data = cbuf;
+		uint32_t size = comp;
+		if (comp <= 0 || (uint32_t)comp >= raw_size)
+		{
+			data = buf;
+			size = raw_size;
+		}
+
+		index[i].offset = offset;
+		index[i].size = size;
+		index[i].sectors = sectors;
+
+		if (fwrite(data, 1, size, out_file) != size)
+			return 1;
+		offset += size;
+	}
+
+	hdr->magic = LZ4B_MAGIC;
+	hdr->version = LZ4B_VERSION;
+	hdr->total_sectors = total_sectors;
+	hdr->blk_sectors = BLK_SECTORS;
+	hdr->num_blocks = num_blocks;
+	hdr->index_offset = 1;
+	hdr->data_offset = data_offset;
+
+	fseeko(out_file, 0, SEEK_SET);
+	if (fwrite(hdr_buf, SECTOR_SIZE, data_offset, out_file) != data_offset)
+		return 1;
+
+	printf("%llu -> %llu bytes (%5.2f%%), %u blocks\n", (unsigned long long)in_size, (unsigned long long)offset,
+		offset * 100.0 / in_size, num_blocks);
+
+	free(hdr_buf);
+	free(buf);
+	free(cbuf);
+
+	return 0;
+}
+
+static int _uncompress(FILE *in_file, FILE *out_file)
+{
+	lz4_hdr_t hdr;
+	uint8_t hash[32];
+
+	if (fread(&hdr, sizeof(hdr), 1, in_file) != 1)
+		return 1;
+
+	if (hdr.magic != LZ4B_MAGIC || hdr.version != LZ4B_VERSION || hdr.blk_sectors != BLK_SECTORS ||
+		hdr.num_blocks != (hdr.total_sectors + BLK_SECTORS - 1) / BLK_SECTORS)
+	{
+		fprintf(stderr, "Invalid or incomplete nxlz file\n");
+		return 1;
+	}
+
+	lz4_blk_t *index = (lz4_blk_t *)malloc(hdr.num_blocks * sizeof(lz4_blk_t));
+	uint8_t *buf = (uint8_t *)malloc(BLK_SIZE);
+	uint8_t *cbuf = (uint8_t *)malloc(BLK_SIZE);
+	if (!(index && buf && cbuf))
+		return 1;
+
+	fseeko(in_file, (off_t)hdr.index_offset * SECTOR_SIZE, SEEK_SET);
+	if (fread(index, sizeof(lz4_blk_t), hdr.num_blocks, in_file) != hdr.num_blocks)
+		return 1;
+
+	for (uint32_t i = 0; i < hdr.num_blocks; i++)
+	{
+		uint32_t raw_size = index[i].sectors * SECTOR_SIZE;
+		if (!index[i].size || raw_size > BLK_SIZE || index[i].size > raw_size)
+		{
+			fprintf(stderr, "Invalid block %u\n", i);
+			return 1;
+		}
+
+		uint8_t *dst = index[i].size == raw_size ? buf : cbuf;
+		fseeko(in_file, index[i].offset, SEEK_SET);
+		if (fread(dst, 1, index[i].size, in_file) != index[i].size)
+			return 1;
+
+		if (dst == cbuf &&
+			LZ4_decompress_safe((const char *)cbuf, (char *)buf, index[i].size, raw_size) != (int)raw_size)
+		{
+			fprintf(stderr, "Failed to uncompress block %u\n", i);
+			return 1;
+		}
+
+		_sha256(hash, buf, raw_size);
+		if (memcmp(hash, index[i].sha256, sizeof(hash)))
+		{
+			fprintf(stderr, "Hash mismatch in block %u\n", i);
+			return 1;
+		}
+
+		if (fwrite(buf, 1, raw_size, out_file) != raw_size)
+			return 1;
+	}
+
+	free(index);
+	free(buf);
+	free(cbuf);
+
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *in_file, *out_file;
+
+	if (argc != 4 || (strcmp(argv[1], "-c") && strcmp(argv[1], "-d")))
+	{
+		fprintf(stderr, "Usage: %s -c <raw in> <nxlz out>\n", argv[0]);
+		fprintf(stderr, "       %s -d <nxlz in> <raw out>\n", argv[0]);
+		exit(1);
+	}
+
+	bool compress = !strcmp(argv[1], "-c");
+
+	if ((in_file = fopen(argv[2], "rb")) == NULL)
+		goto error;
+
+	if ((out_file = fopen(argv[3], "wb")) == NULL)
+		goto error;
+
+	int res = compress ? _compress(in_file, out_file) : _uncompress(in_file, out_file);
+
+	fclose(in_file);
+	fclose(out_file);
+
+	if (res)
+	{
+		remove(argv[3]);
+		goto error;
+	}
+
+	return 0;
+
+error:
+	fprintf(stderr, "Failed to %s: %s\n", compress ? "compress" : "uncompress", argv[2]);
+	exit(1);
+}
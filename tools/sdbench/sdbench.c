@@ -0,0 +1,340 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Runs the Nyx storage benchmark engine against a file backed mock storage.
+// Checks that every I/O stays inside its area and honors the requested alignment.
+
+#define _FILE_OFFSET_BITS 64
+#define _POSIX_C_SOURCE   200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "fe_bench.h"
+
+#define SECTOR_SIZE 512
+#define BUF_SECTORS 0x8000 // 16MB. Same as Nyx.
+#define AU_SECTORS  0x2000 // 4MB.
+
+typedef struct _mock_t
+{
+	int fd;
+	u32 sct_cnt;
+	u32 area_start; // Allowed I/O area.
+	u32 area_end;
+	u32 align;      // Required alignment of each I/O.
+	u32 writes;
+	u64 seed;
+	int fail;
+
+	// Background read.
+	pthread_t thread;
+	bool pending;
+	u32 async_sct;
+	u32 async_num;
+	void *async_buf;
+	int async_res;
+} mock_t;
+
+static int _mock_check(mock_t *m, u32 sector, u32 num)
+{
+	if (sector < m->area_start || sector + num > m->area_end || sector + num > m->sct_cnt)
+	{
+		fprintf(stderr, "I/O out of area: %08X + %X, area %08X - %08X\n", sector, num, m->area_start, m->area_end);
+		m->fail = 1;
+		return 0;
+	}
+
+	if (m->align && (sector % m->align))
+	{
+		fprintf(stderr, "Unaligned I/O: %08X, alignment %X\n", sector, m->align);
+		m->fail = 1;
+		return 0;
+	}
+
+	return 1;
+}
+
+static int _mock_read(void *ctx, u32 sector, u32 num, void *buf)
+{
+	mock_t *m = ctx;
+
+	if (!_mock_check(m, sector, num))
+		return 0;
+
+	return pread(m->fd, buf, (size_t)num * SECTOR_SIZE, (off_t)sector * SECTOR_SIZE) == (ssize_t)num * SECTOR_SIZE;
+}
+
+static void *_mock_async_thread(void *ctx)
+{
+	mock_t *m = ctx;
+
+	m->async_res = pread(m->fd, m->async_buf, (size_t)m->async_num * SECTOR_SIZE,
+		(off_t)m->async_sct * SECTOR_SIZE) == (ssize_t)m->async_num * SECTOR_SIZE;
+
+	return NULL;
+}
+
+static int _mock_read_async(void *ctx, u32 sector, u32 num, void *buf)
+{
+	mock_t *m = ctx;
+
+	if (m->pending)
+	{
+		fprintf(stderr, "Async read queued while another is pending\n");
+		m->fail = 1;
+		return 0;
+	}
+
+	if (!_mock_check(m, sector, num))
+		return 0;
+
+	m->async_sct = sector;
+	m->async_num = num;
+	m->async_buf = buf;
+	if (pthread_create(&m->thread, NULL, _mock_async_thread, m))
+		return 0;
+	m->pending = true;
+
+	return 1;
+}
+
+static int _mock_wait(void *ctx)
+{
+	mock_t *m = ctx;
+
+	if (!m->pending)
+	{
+		fprintf(stderr, "Async wait without a pending read\n");
+		m->fail = 1;
+		return 0;
+	}
+
+	pthread_join(m->thread, NULL);
+	m->pending = false;
+
+	return m->async_res;
+}
+
+static int _mock_write(void *ctx, u32 sector, u32 num, void *buf)
+{
+	mock_t *m = ctx;
+
+	if (!_mock_check(m, sector, num))
+		return 0;
+
+	m->writes++;
+	return pwrite(m->fd, buf, (size_t)num * SECTOR_SIZE, (off_t)sector * SECTOR_SIZE) == (ssize_t)num * SECTOR_SIZE;
+}
+
+static u32 _mock_rand(void *ctx)
+{
+	mock_t *m = ctx;
+
+	// xorshift64*.
+	m->seed ^= m->seed >> 12;
+	m->seed ^= m->seed << 25;
+	m->seed ^= m->seed >> 27;
+
+	return (m->seed * 0x2545F4914F6CDD1DULL) >> 32;
+}
+
+static u32 _mock_get_us()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (u32)((u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+static int _check_result(const bench_test_t *test, const bench_result_t *res)
+{
+	if (res->ops != test->total_sct / test->block_sct || res->sectors != res->ops * test->block_sct)
+		return 0;
+
+	if (res->lat_min_us > res->lat_p50_us || res->lat_p50_us > res->lat_p99_us || res->lat_p99_us > res->lat_max_us)
+		return 0;
+
+	u32 hist_ops = 0;
+	for (u32 i = 0; i < BENCH_HIST_BINS; i++)
+		hist_ops += res->hist[i];
+
+	return hist_ops == res->ops;
+}
+
+static void _usage(const char *name)
+{
+	printf("Usage: %s -i <image> [-s <size MiB>] [-o <output prefix>]\n"
+		"  Runs the read suite at 3 offsets (1 if under 6GiB) and the write suite on the last 256MiB.\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	const char *img = NULL;
+	const char *out_prefix = NULL;
+	u32 size_mb = 8192; // Sparse.
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-i") && i + 1 < argc)
+			img = argv[++i];
+		else if (!strcmp(argv[i], "-s") && i + 1 < argc)
+			size_mb = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+			out_prefix = argv[++i];
+		else
+		{
+			_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (!img || size_mb < 1280)
+	{
+		_usage(argv[0]);
+		return 1;
+	}
+
+	mock_t m = { 0 };
+	m.fd = open(img, O_RDWR | O_CREAT, 0644);
+	if (m.fd < 0 || ftruncate(m.fd, (off_t)size_mb << 20))
+	{
+		perror(img);
+		return 1;
+	}
+	m.sct_cnt = size_mb << 11;
+	m.seed = 0x9E3779B97F4A7C15ULL;
+
+	bench_io_t io = { 0 };
+	io.ctx     = &m;
+	io.read    = _mock_read;
+	io.write   = _mock_write;
+	io.read_async = _mock_read_async;
+	io.wait       = _mock_wait;
+	io.rand    = _mock_rand;
+	io.get_us  = _mock_get_us;
+	io.buf_sct = BUF_SECTORS;
+	io.au_sct  = AU_SECTORS;
+	io.buf     = aligned_alloc(4096, BUF_SECTORS * SECTOR_SIZE);
+
+	u32 max_results = bench_read_suite_cnt * 3 + bench_write_suite_cnt;
+	bench_result_t *results = calloc(max_results, sizeof(bench_result_t));
+	u32 res_cnt = 0;
+	int failed = 0;
+
+	// Same offsets as Nyx: 3 areas, 16MB aligned.
+	u32 read_span = 0x200000;
+	u32 iters = m.sct_cnt < 0xC00000 ? 1 : 3;
+	u32 offset_chunk = (m.sct_cnt / 3) & ~0x7FFF;
+	for (u32 iter = 0; iter < iters; iter++)
+	{
+		u32 offset = offset_chunk * iter;
+		for (u32 t = 0; t < bench_read_suite_cnt; t++)
+		{
+			const bench_test_t *test = &bench_read_suite[t];
+			m.area_start = offset;
+			m.area_end   = offset + read_span;
+			m.align      = test->block_sct;
+
+			int res = bench_run(&io, test, offset, read_span, &results[res_cnt]);
+			if (res || !_check_result(test, &results[res_cnt]) || m.pending)
+			{
+				fprintf(stderr, "FAIL: %s @ %08X (%d)\n", test->name, offset, res);
+				failed = 1;
+			}
+			res_cnt++;
+		}
+	}
+
+	// Scratch area at the end. Unaligned base to exercise AU alignment.
+	u32 scratch_sct = 0x80000;
+	u32 scratch = m.sct_cnt - scratch_sct - 0x800;
+	io.lba_base = 0x123;
+	for (u32 t = 0; t < bench_write_suite_cnt; t++)
+	{
+		const bench_test_t *test = &bench_write_suite[t];
+		m.area_start = scratch;
+		m.area_end   = scratch + scratch_sct;
+		m.align      = 0; // Checked below, relative to lba_base.
+		m.writes     = 0;
+
+		int res = bench_run(&io, test, scratch, scratch_sct, &results[res_cnt]);
+		if (res || !_check_result(test, &results[res_cnt]) || (test->op == BENCH_OP_WRITE && m.writes != results[res_cnt].ops))
+		{
+			fprintf(stderr, "FAIL: %s (%d)\n", test->name, res);
+			failed = 1;
+		}
+		res_cnt++;
+	}
+
+	// AU alignment check. First AU write must start at a physical AU boundary.
+	{
+		bench_test_t au_test = bench_write_suite[0];
+		au_test.total_sct = au_test.block_sct * 4;
+		m.area_start = scratch;
+		m.area_end   = scratch + scratch_sct;
+		m.align      = AU_SECTORS;
+		io.lba_base  = 0;
+		bench_result_t au_res;
+		if (bench_run(&io, &au_test, scratch + 0x123, scratch_sct - 0x123, &au_res))
+		{
+			fprintf(stderr, "FAIL: AU alignment\n");
+			failed = 1;
+		}
+	}
+
+	for (u32 i = 0; i < res_cnt; i++)
+	{
+		bench_result_t *r = &results[i];
+		printf("%-18s @ %08X: %7d KiB/s, %6d IOPS, lat us min %d p50 %d p99 %d max %d\n",
+			r->name, r->offset, r->rate_kibs, r->iops, r->lat_min_us, r->lat_p50_us, r->lat_p99_us, r->lat_max_us);
+	}
+
+	if (out_prefix)
+	{
+		char *txt = malloc(SZ_1M);
+		char path[256];
+
+		bench_export_csv(txt, "mock", results, res_cnt);
+		snprintf(path, sizeof(path), "%s.csv", out_prefix);
+		FILE *f = fopen(path, "w");
+		if (f) { fputs(txt, f); fclose(f); }
+
+		bench_export_json(txt, "mock", img, results, res_cnt);
+		snprintf(path, sizeof(path), "%s.json", out_prefix);
+		f = fopen(path, "w");
+		if (f) { fputs(txt, f); fclose(f); }
+
+		free(txt);
+	}
+
+	close(m.fd);
+	free(io.buf);
+	free(results);
+
+	if (m.fail)
+		failed = 1;
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+
+	return failed;
+}
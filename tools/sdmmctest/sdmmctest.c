@@ -0,0 +1,593 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Runs the SDMMC storage request layer natively on top of a mock driver.
+// Two RAM cards stand in for SD and eMMC. Transfers take virtual time and
+// fail at random, so async requests, command splitting, bounce buffers,
+// retries and reinit are all exercised and checked against shadow images.
+// It can also simulate eMMC backup timing with and without read prefetch.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mem/mc.h>
+#include <memory_map.h>
+#include <utils/types.h>
+
+// Bounce buffer lives in host memory.
+static u8 bounce_mem[SDMMC_UP_BUF_SZ] __attribute__((aligned(64)));
+#undef  SDMMC_UPPER_BUFFER
+#define SDMMC_UPPER_BUFFER bounce_mem
+
+// Build the request layer in, with the bdk allocator renamed so it doesn't clash with the host one.
+#define malloc bdk_malloc
+#define calloc bdk_calloc
+#define zalloc bdk_zalloc
+#define free   bdk_free
+#include <storage/sdmmc.c>
+#undef malloc
+#undef calloc
+#undef zalloc
+#undef free
+
+#define CARD_SECTORS  (160 * 1024 * 1024 / SDMMC_DAT_BLOCKSIZE)
+#define REQ_MAX       0x20000 // Bigger than 0xFFFF, so requests get split.
+#define NOACCESS_SIZE SZ_1M   // Buffer region SDMMC DMA can't reach, like IRAM.
+#define POLL_COST     32      // Virtual ticks per status poll.
+
+#define BACKUP_SECTORS (128 * 1024 * 1024 / SDMMC_DAT_BLOCKSIZE)
+#define BACKUP_CHUNK   8192 // Same as NUM_SECTORS_PER_ITER of eMMC backup.
+
+typedef struct _card_t
+{
+	u8  *data;
+	u8  *shadow;
+
+	// In flight transfer.
+	u32 sector;
+	u32 num_sectors;
+	sdmmc_req_t req;
+	u32 *blkcnt_out;
+	u64 done_at;
+	int fail;
+
+	// Timing in virtual ticks.
+	u32 cmd_cost;
+	u32 sct_cost;
+} card_t;
+
+sdmmc_t sd_sdmmc, emmc_sdmmc;
+sdmmc_storage_t sd_storage, emmc_storage;
+
+static card_t cards[2];
+static u8 noaccess_mem[NOACCESS_SIZE] __attribute__((aligned(64)));
+static u8 *backup_buf;
+
+static u64 now;         // Virtual time. Advances on polls and sleeps.
+static u32 fail_pct;    // Chance of a command failing.
+static u32 violations;
+static u64 cmds, polls, fails, reinits, retries;
+
+static u32 rng_state = 0x12345678;
+
+static u32 _rand()
+{
+	// xorshift32.
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+
+	return rng_state;
+}
+
+static void _fill(u8 *buf, u64 size)
+{
+	for (u64 i = 0; i < size; i += 4)
+	{
+		u32 v = _rand();
+		memcpy(buf + i, &v, 4);
+	}
+}
+
+static card_t *_card(sdmmc_t *sdmmc)
+{
+	return &cards[sdmmc == &emmc_sdmmc];
+}
+
+static void _violation(const char *msg)
+{
+	fprintf(stderr, "Driver misuse: %s\n", msg);
+	violations++;
+}
+
+// Mock driver.
+void sdmmc_init_cmd(sdmmc_cmd_t *cmdbuf, u16 cmd, u32 arg, u32 rsp_type, u32 check_busy)
+{
+	cmdbuf->cmd = cmd;
+	cmdbuf->arg = arg;
+	cmdbuf->rsp_type = rsp_type;
+	cmdbuf->check_busy = check_busy;
+}
+
+int sdmmc_get_rsp(sdmmc_t *sdmmc, u32 *rsp, u32 size, u32 type)
+{
+	// Card is always ready and in transfer state.
+	rsp[0] = R1_READY_FOR_DATA | (R1_STATE_TRAN << 9);
+
+	return 1;
+}
+
+int sdmmc_execute_cmd_async(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out)
+{
+	card_t *card = _card(sdmmc);
+
+	if (sdmmc->xfer_active)
+	{
+		_violation("command issued while a transfer is in flight");
+		return 0;
+	}
+
+	now += card->cmd_cost;
+	cmds++;
+
+	if (!req)
+		return 1;
+
+	if (req->num_sectors > 0xFFFF || cmd->arg + req->num_sectors > CARD_SECTORS)
+	{
+		_violation("transfer out of range");
+		return 0;
+	}
+
+	if (!req->num_segs && (!mc_client_has_access(req->buf) || ((u64)req->buf & 7)))
+	{
+		_violation("buffer not DMA accessible");
+		return 0;
+	}
+
+	// Command failed.
+	if (_rand() % 100 < fail_pct / 2)
+	{
+		fails++;
+		return 0;
+	}
+
+	card->sector = cmd->arg;
+	card->num_sectors = req->num_sectors;
+	card->req = *req;
+	card->blkcnt_out = blkcnt_out;
+	card->done_at = now + (u64)card->sct_cost * req->num_sectors;
+	card->fail = _rand() % 100 < fail_pct / 2;
+	sdmmc->xfer_active = 1;
+
+	return 1;
+}
+
+static void _xfer(card_t *card, u32 count)
+{
+	u8 *disk = card->data + (u64)card->sector * SDMMC_DAT_BLOCKSIZE;
+	u32 size = count * SDMMC_DAT_BLOCKSIZE;
+
+	if (card->req.num_segs)
+	{
+		for (u32 i = 0; i < card->req.num_segs && size; i++)
+		{
+			u32 seg_size = MIN(card->req.segs[i].size, size);
+			if (card->req.is_write)
+				memcpy(disk, card->req.segs[i].buf, seg_size);
+			else
+				memcpy(card->req.segs[i].buf, disk, seg_size);
+			disk += seg_size;
+			size -= seg_size;
+		}
+	}
+	else if (card->req.is_write)
+		memcpy(disk, card->req.buf, size);
+	else
+		memcpy(card->req.buf, disk, size);
+}
+
+int sdmmc_execute_cmd_poll(sdmmc_t *sdmmc)
+{
+	card_t *card = _card(sdmmc);
+
+	if (!sdmmc->xfer_active)
+	{
+		_violation("poll without a transfer in flight");
+		return SDMMC_XFER_ERROR;
+	}
+
+	now += POLL_COST;
+	polls++;
+
+	if (now < card->done_at)
+		return SDMMC_XFER_BUSY;
+
+	sdmmc->xfer_active = 0;
+
+	// Failed transfers move part of the data, like a CRC error midway.
+	if (card->fail)
+	{
+		fails++;
+		_xfer(card, _rand() % card->num_sectors);
+
+		return SDMMC_XFER_ERROR;
+	}
+
+	_xfer(card, card->num_sectors);
+	if (card->blkcnt_out)
+		*card->blkcnt_out = card->num_sectors;
+
+	return SDMMC_XFER_DONE;
+}
+
+int sdmmc_execute_cmd(sdmmc_t *sdmmc, sdmmc_cmd_t *cmd, sdmmc_req_t *req, u32 *blkcnt_out)
+{
+	int result = sdmmc_execute_cmd_async(sdmmc, cmd, req, blkcnt_out);
+
+	if (result && sdmmc->xfer_active)
+	{
+		do
+		{
+			result = sdmmc_execute_cmd_poll(sdmmc);
+		} while (result == SDMMC_XFER_BUSY);
+
+		result = result == SDMMC_XFER_DONE;
+	}
+
+	return result;
+}
+
+int sdmmc_stop_transmission(sdmmc_t *sdmmc, u32 *rsp)
+{
+	if (sdmmc->xfer_active)
+		_violation("stop while a transfer is in flight");
+
+	return 1;
+}
+
+void sdmmc_end(sdmmc_t *sdmmc) {}
+
+bool mc_client_has_access(void *address)
+{
+	return (u8 *)address < noaccess_mem || (u8 *)address >= noaccess_mem + NOACCESS_SIZE;
+}
+
+void msleep(u32 ms)
+{
+	now += ms * 1000;
+}
+
+void sd_error_count_increment(u8 type)
+{
+	if (type == SD_ERROR_RW_RETRY)
+		retries++;
+}
+
+void emmc_error_count_increment(u8 type)
+{
+	if (type == EMMC_ERROR_RW_RETRY)
+		retries++;
+}
+
+static bool _reinit(sdmmc_storage_t *storage)
+{
+	if (storage->sdmmc->xfer_active)
+		_violation("reinit while a transfer is in flight");
+
+	reinits++;
+
+	return true;
+}
+
+bool sd_initialize(bool power_cycle)   { return _reinit(&sd_storage); }
+int  sd_init_retry(bool power_cycle)   { return _reinit(&sd_storage); }
+bool emmc_initialize(bool power_cycle) { return _reinit(&emmc_storage); }
+int  emmc_init_retry(bool power_cycle) { return _reinit(&emmc_storage); }
+
+static void _card_init(card_t *card, sdmmc_storage_t *storage, sdmmc_t *sdmmc, u32 id)
+{
+	card->data = malloc((u64)CARD_SECTORS * SDMMC_DAT_BLOCKSIZE);
+	card->shadow = malloc((u64)CARD_SECTORS * SDMMC_DAT_BLOCKSIZE);
+
+	_fill(card->data, (u64)CARD_SECTORS * SDMMC_DAT_BLOCKSIZE);
+	memcpy(card->shadow, card->data, (u64)CARD_SECTORS * SDMMC_DAT_BLOCKSIZE);
+
+	memset(sdmmc, 0, sizeof(sdmmc_t));
+	sdmmc->id = id;
+	memset(storage, 0, sizeof(sdmmc_storage_t));
+	storage->sdmmc = sdmmc;
+	storage->has_sector_access = 1;
+	storage->initialized = 1;
+	storage->sec_cnt = CARD_SECTORS;
+}
+
+typedef struct _op_t
+{
+	sdmmc_storage_t *storage;
+	sdmmc_storage_async_t *req;
+	u8  *buf;
+	u32 sector;
+	u32 count;
+	u32 is_write;
+} op_t;
+
+static u8 *_op_buf(u32 slot, u32 count)
+{
+	static u8 *bufs[2];
+
+	if (!bufs[0])
+	{
+		bufs[0] = aligned_alloc(64, REQ_MAX * SDMMC_DAT_BLOCKSIZE + 64);
+		bufs[1] = aligned_alloc(64, REQ_MAX * SDMMC_DAT_BLOCKSIZE + 64);
+	}
+
+	// Small buffers sometimes come from a non DMA region or are unaligned, which needs the bounce buffer.
+	u32 r = _rand() % 8;
+	if (count * SDMMC_DAT_BLOCKSIZE <= NOACCESS_SIZE / 2 && r == 0)
+		return noaccess_mem + slot * (NOACCESS_SIZE / 2);
+	if (r == 1)
+		return bufs[slot] + 4;
+
+	return bufs[slot];
+}
+
+static void _op_start(op_t *op, u32 slot, bool async)
+{
+	card_t *card = _card(op->storage->sdmmc);
+
+	op->count = (_rand() % 64) ? (_rand() % 256) + 1 : (_rand() % REQ_MAX) + 1;
+	op->sector = _rand() % (CARD_SECTORS - op->count);
+	op->is_write = _rand() % 3 == 0;
+	op->buf = _op_buf(slot, op->count);
+	op->req = NULL;
+
+	if (op->is_write)
+	{
+		_fill(op->buf, op->count * SDMMC_DAT_BLOCKSIZE);
+		memcpy(card->shadow + (u64)op->sector * SDMMC_DAT_BLOCKSIZE, op->buf, op->count * SDMMC_DAT_BLOCKSIZE);
+	}
+
+	if (!async)
+		return;
+
+	if (op->is_write)
+		op->req = sdmmc_storage_write_async(op->storage, op->sector, op->count, op->buf);
+	else
+		op->req = sdmmc_storage_read_async(op->storage, op->sector, op->count, op->buf);
+}
+
+static int _op_finish(op_t *op, u64 idx)
+{
+	int res;
+	card_t *card = _card(op->storage->sdmmc);
+
+	// Requests that could not be queued fall back to blocking calls, like the real users.
+	if (op->req)
+		res = sdmmc_storage_async_wait(op->req);
+	else if (op->is_write)
+		res = sdmmc_storage_write(op->storage, op->sector, op->count, op->buf);
+	else
+		res = sdmmc_storage_read(op->storage, op->sector, op->count, op->buf);
+
+	if (!res)
+	{
+		fprintf(stderr, "Request %llu failed (sector %x count %x)!\n", (unsigned long long)idx, op->sector, op->count);
+		return 1;
+	}
+
+	if (!op->is_write && memcmp(op->buf, card->shadow + (u64)op->sector * SDMMC_DAT_BLOCKSIZE, op->count * SDMMC_DAT_BLOCKSIZE))
+	{
+		fprintf(stderr, "Read mismatch at request %llu (sector %x count %x)!\n", (unsigned long long)idx, op->sector, op->count);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int _backup(bool pipelined, u32 cpu_cost, u64 *ticks)
+{
+	// Same loop as eMMC backup. Next eMMC chunk is read while the current one is written to SD.
+	u32 total = BACKUP_SECTORS;
+	u8 *bufs[2] = { backup_buf, backup_buf + BACKUP_CHUNK * SDMMC_DAT_BLOCKSIZE };
+	u32 buf_idx = 0;
+	sdmmc_storage_async_t *read_req = NULL;
+	u64 start = now;
+
+	for (u32 lba = 0; lba < total; lba += BACKUP_CHUNK)
+	{
+		u32 num = MIN(total - lba, BACKUP_CHUNK);
+
+		int res_read;
+		if (read_req)
+			res_read = sdmmc_storage_async_wait(read_req);
+		else
+			res_read = sdmmc_storage_read(&emmc_storage, lba, num, bufs[buf_idx]);
+		read_req = NULL;
+
+		if (!res_read)
+		{
+			fprintf(stderr, "Backup read failed at %x!\n", lba);
+			return 1;
+		}
+
+		u32 num_next = MIN(total - lba - num, BACKUP_CHUNK);
+		if (pipelined && num_next)
+			read_req = sdmmc_storage_read_async(&emmc_storage, lba + num, num_next, bufs[buf_idx ^ 1]);
+
+		// Hashing and UI updates.
+		now += (u64)cpu_cost * num;
+
+		if (!sdmmc_storage_write(&sd_storage, lba, num, bufs[buf_idx]))
+		{
+			fprintf(stderr, "Backup write failed at %x!\n", lba);
+			return 1;
+		}
+
+		if (pipelined)
+			buf_idx ^= 1;
+	}
+
+	*ticks = now - start;
+
+	if (memcmp(cards[0].data, cards[1].data, (u64)total * SDMMC_DAT_BLOCKSIZE))
+	{
+		fprintf(stderr, "Backup image mismatch!\n");
+		return 1;
+	}
+
+	// Scramble SD copy for the next run.
+	_fill(cards[0].data, (u64)total * SDMMC_DAT_BLOCKSIZE);
+
+	return violations != 0;
+}
+
+static void _usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [-n requests] [-f fail_pct] [-s seed] [-p] [-c cpu_cost]\n"
+		"  -p simulates eMMC backup with and without read prefetching, in virtual ticks.\n"
+		"  -c sets CPU ticks per sector spent between reading and writing a chunk.\n", name);
+}
+
+int main(int argc, char *argv[])
+{
+	u64 num_ops = 20000;
+	bool backup = false;
+	u32 cpu_cost = 0;
+	fail_pct = 10;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-p"))
+		{
+			backup = true;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+		{
+			_usage(argv[0]);
+			return 1;
+		}
+
+		if (!strcmp(argv[i], "-n"))
+			num_ops = strtoull(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-f"))
+			fail_pct = strtoul(argv[++i], NULL, 0);
+		else if (!strcmp(argv[i], "-s"))
+			rng_state = strtoul(argv[++i], NULL, 0) | 1;
+		else if (!strcmp(argv[i], "-c"))
+			cpu_cost = strtoul(argv[++i], NULL, 0);
+		else
+		{
+			_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	_card_init(&cards[0], &sd_storage, &sd_sdmmc, SDMMC_1);
+	_card_init(&cards[1], &emmc_storage, &emmc_sdmmc, SDMMC_4);
+	cards[0].cmd_cost = 50;
+	cards[0].sct_cost = 4;
+	cards[1].cmd_cost = 20;
+	cards[1].sct_cost = 1;
+
+	if (backup)
+	{
+		u64 serial = 0, pipelined = 0;
+		backup_buf = aligned_alloc(64, 2 * BACKUP_CHUNK * SDMMC_DAT_BLOCKSIZE);
+
+		int res = _backup(false, cpu_cost, &serial) || _backup(true, cpu_cost, &pipelined);
+
+		printf("%s: %u MiB backup, serial %llu ticks, pipelined %llu ticks, %.2fx, %llu injected failures\n",
+			res ? "FAIL" : "OK", BACKUP_SECTORS >> 11, (unsigned long long)serial, (unsigned long long)pipelined,
+			pipelined ? (double)serial / pipelined : 0.0, (unsigned long long)fails);
+
+		return res;
+	}
+
+	int res = 0;
+	op_t ops[2];
+	u8 *expected = malloc(REQ_MAX * SDMMC_DAT_BLOCKSIZE);
+	for (u64 i = 0; i < num_ops && !res; i++)
+	{
+		// Mix an async request on one controller with requests on both.
+		u32 mode = _rand() % 4;
+		ops[0].storage = (_rand() & 1) ? &emmc_storage : &sd_storage;
+		_op_start(&ops[0], 0, mode != 0);
+
+		switch (mode)
+		{
+		case 0: // Blocking.
+			res = _op_finish(&ops[0], i);
+			break;
+
+		case 1: // Async and waited, with polling in between.
+			for (u32 j = _rand() % 64; j && ops[0].req; j--)
+				sdmmc_storage_async_poll(ops[0].req);
+			res = _op_finish(&ops[0], i);
+			break;
+
+		case 2: // Async on one controller and blocking on the other, like eMMC backup.
+			ops[1].storage = ops[0].storage == &sd_storage ? &emmc_storage : &sd_storage;
+			_op_start(&ops[1], 1, false);
+			res = _op_finish(&ops[1], i) || _op_finish(&ops[0], i);
+			break;
+
+		case 3: // Back to back on the same controller. Second start must finish the first read.
+			if (ops[0].is_write || !ops[0].req)
+			{
+				res = _op_finish(&ops[0], i);
+				break;
+			}
+			memcpy(expected, _card(ops[0].storage->sdmmc)->shadow + (u64)ops[0].sector * SDMMC_DAT_BLOCKSIZE,
+				ops[0].count * SDMMC_DAT_BLOCKSIZE);
+			ops[1].storage = ops[0].storage;
+			_op_start(&ops[1], 1, true);
+			if (memcmp(ops[0].buf, expected, ops[0].count * SDMMC_DAT_BLOCKSIZE))
+			{
+				fprintf(stderr, "Read mismatch at request %llu after restart!\n", (unsigned long long)i);
+				res = 1;
+				break;
+			}
+			res = _op_finish(&ops[1], i);
+			break;
+		}
+
+		if (violations)
+			res = 1;
+	}
+
+	// Final image check.
+	for (u32 c = 0; c < 2 && !res; c++)
+	{
+		if (memcmp(cards[c].data, cards[c].shadow, (u64)CARD_SECTORS * SDMMC_DAT_BLOCKSIZE))
+		{
+			fprintf(stderr, "Card %u image mismatch!\n", c);
+			res = 1;
+		}
+	}
+
+	printf("%s: %llu requests, %llu commands, %llu polls, %llu injected failures, %llu retries, %llu reinits\n",
+		res ? "FAIL" : "OK", (unsigned long long)num_ops, (unsigned long long)cmds, (unsigned long long)polls,
+		(unsigned long long)fails, (unsigned long long)retries, (unsigned long long)reinits);
+
+	return res;
+}
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Decodes hekate/Nyx boot traces from bootloader/trace/*.bin into a stage breakdown.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <utils/trace.h>
+
+#define MAX_DEPTH 32
+#define BAR_WIDTH 40
+
+static const char *trace_names[TRACE_ID_MAX] = {
+	[TRACE_NONE]            = "none",
+	[TRACE_SD_INIT]         = "sd_init",
+	[TRACE_SD_MOUNT]        = "sd_mount",
+	[TRACE_EMMC_INIT]       = "emmc_init",
+	[TRACE_EMUMMC_INIT]     = "emummc_init",
+	[TRACE_PKG1_READ]       = "pkg1_read",
+	[TRACE_PKG2_READ]       = "pkg2_read",
+	[TRACE_HOS_KEYGEN]      = "hos_keygen",
+	[TRACE_PKG1_DECRYPT]    = "pkg1_decrypt",
+	[TRACE_PKG2_DECRYPT]    = "pkg2_decrypt",
+	[TRACE_PKG2_CACHE_LOAD] = "pkg2_cache_load",
+	[TRACE_PKG2_BUILD]      = "pkg2_build_encrypt",
+	[TRACE_KIP_DECOMPRESS]  = "kip_decompress",
+	[TRACE_HW_INIT]         = "hw_init",
+	[TRACE_MINERVA_INIT]    = "minerva_init",
+	[TRACE_AUTO_LAUNCH]     = "auto_launch",
+	[TRACE_INI_PARSE]       = "ini_parse",
+	[TRACE_BOOT_WAIT]       = "boot_wait",
+	[TRACE_HOS_LAUNCH]      = "hos_launch",
+	[TRACE_HOS_CONFIG]      = "hos_config",
+	[TRACE_PKG2_PATCH]      = "pkg2_patch_kips",
+	[TRACE_PKG2_CACHE_SAVE] = "pkg2_cache_save",
+	[TRACE_HOS_HANDOFF]     = "hos_handoff",
+	[TRACE_NYX_LOAD]        = "nyx_load",
+	[TRACE_NYX_LAUNCH]      = "nyx_launch",
+	[TRACE_NYX_MAIN]        = "nyx_main",
+	[TRACE_NYX_RES_LOAD]    = "nyx_res_load",
+};
+
+typedef struct _node_t
+{
+	u32 id;
+	u32 type;
+	u32 arg;
+	u32 arg_end;
+	u32 start; // us from first record.
+	u32 dur;
+	u32 child_dur;
+	u32 depth;
+	int parent;
+	int open;
+} node_t;
+
+static const char *_name(u32 id)
+{
+	static char unk[16];
+
+	if (id < TRACE_ID_MAX && trace_names[id])
+		return trace_names[id];
+
+	snprintf(unk, sizeof(unk), "id_%u", id);
+	return unk;
+}
+
+static void _usage(const char *name)
+{
+	printf("Usage: %s [-f] <trace.bin>\n"
+		"  Prints a stage breakdown of a boot trace.\n"
+		"  -f  Print folded stacks (self time in us) for flamegraph tools instead.\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	int folded = 0;
+	const char *path = NULL;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-f"))
+			folded = 1;
+		else if (!path)
+			path = argv[i];
+		else
+		{
+			_usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (!path)
+	{
+		_usage(argv[0]);
+		return 1;
+	}
+
+	FILE *f = fopen(path, "rb");
+	if (!f)
+	{
+		perror(path);
+		return 1;
+	}
+
+	trace_buf_t *buf = calloc(1, sizeof(trace_buf_t));
+	size_t size = fread(buf, 1, sizeof(trace_buf_t), f);
+	fclose(f);
+
+	if (size < sizeof(trace_buf_t) || buf->magic != TRACE_MAGIC || buf->version != TRACE_VERSION ||
+		buf->recs_max != TRACE_RECS_MAX)
+	{
+		fprintf(stderr, "%s: not a version %d trace with %d records\n", path, TRACE_VERSION, TRACE_RECS_MAX);
+		return 1;
+	}
+
+	// Linearize the ring. Oldest record first.
+	u32 count = buf->head < TRACE_RECS_MAX ? buf->head : TRACE_RECS_MAX;
+	u32 first = buf->head - count;
+	if (!count)
+	{
+		printf("Empty trace.\n");
+		return 0;
+	}
+	if (buf->head > TRACE_RECS_MAX)
+		fprintf(stderr, "Warning: %u oldest records were overwritten.\n", buf->head - TRACE_RECS_MAX);
+
+	node_t *nodes = calloc(count, sizeof(node_t));
+	int stack[MAX_DEPTH];
+	int sp = 0;
+	u32 num_nodes = 0;
+
+	u32 ts_base = buf->recs[first & (TRACE_RECS_MAX - 1)].ts;
+	u32 ts_last = 0;
+
+	for (u32 i = 0; i < count; i++)
+	{
+		trace_rec_t *rec = &buf->recs[(first + i) & (TRACE_RECS_MAX - 1)];
+		u32 ts = rec->ts - ts_base; // Wrap safe.
+		ts_last = ts;
+
+		if (rec->type == TRACE_TYPE_END)
+		{
+			// Find the matching span. Spans left open inside it end here too.
+			int match = sp - 1;
+			while (match >= 0 && nodes[stack[match]].id != rec->id)
+				match--;
+			if (match < 0)
+				continue; // Begin was overwritten.
+
+			while (sp > match)
+			{
+				node_t *n = &nodes[stack[--sp]];
+				n->dur = ts - n->start;
+				n->open = sp != match;
+				if (sp == match)
+					n->arg_end = rec->arg;
+				if (n->parent >= 0)
+					nodes[n->parent].child_dur += n->dur;
+			}
+			continue;
+		}
+
+		node_t *n = &nodes[num_nodes];
+		n->id     = rec->id;
+		n->type   = rec->type;
+		n->arg    = rec->arg;
+		n->start  = ts;
+		n->depth  = sp;
+		n->parent = sp ? stack[sp - 1] : -1;
+
+		if (rec->type == TRACE_TYPE_BEGIN && sp < MAX_DEPTH)
+		{
+			n->open = 1;
+			stack[sp++] = num_nodes;
+		}
+		num_nodes++;
+	}
+
+	// Close spans that never ended (e.g. the launch that handed off).
+	while (sp)
+	{
+		node_t *n = &nodes[stack[--sp]];
+		n->dur = ts_last - n->start;
+		if (n->parent >= 0)
+			nodes[n->parent].child_dur += n->dur;
+	}
+
+	if (folded)
+	{
+		for (u32 i = 0; i < num_nodes; i++)
+		{
+			node_t *n = &nodes[i];
+			if (n->type != TRACE_TYPE_BEGIN)
+				continue;
+
+			const char *chain[MAX_DEPTH + 1];
+			int depth = 0;
+			for (int p = i; p >= 0 && depth <= MAX_DEPTH; p = nodes[p].parent)
+				chain[depth++] = _name(nodes[p].id);
+
+			printf("boot");
+			while (depth)
+				printf(";%s", chain[--depth]);
+			printf(" %u\n", n->dur - n->child_dur);
+		}
+
+		return 0;
+	}
+
+	printf("Trace: %s, %u records, %u.%03u ms total\n\n", path, count, ts_last / 1000, ts_last % 1000);
+	printf("%-34s %10s %10s %10s %6s\n", "Stage", "Start ms", "Total ms", "Self ms", "%");
+
+	u32 top_dur = 0;
+	for (u32 i = 0; i < num_nodes; i++)
+	{
+		node_t *n = &nodes[i];
+		char label[64];
+		int indent = n->depth * 2;
+
+		if (n->type == TRACE_TYPE_POINT)
+		{
+			snprintf(label, sizeof(label), "%*s@ %s", indent, "", _name(n->id));
+			printf("%-34s %6u.%03u\n", label, n->start / 1000, n->start % 1000);
+			continue;
+		}
+
+		if (!n->depth)
+			top_dur += n->dur;
+
+		u32 self = n->dur - n->child_dur;
+		u32 pct_10 = ts_last ? (unsigned long long)n->dur * 1000 / ts_last : 0;
+		u32 bar = ts_last ? (unsigned long long)n->dur * BAR_WIDTH / ts_last : 0;
+		u32 bar_off = ts_last ? (unsigned long long)n->start * BAR_WIDTH / ts_last : 0;
+
+		snprintf(label, sizeof(label), "%*s%s%s", indent, "", _name(n->id), n->open ? " (open)" : "");
+		printf("%-34s %6u.%03u %6u.%03u %6u.%03u %4u.%u |%*s%.*s\n", label,
+			n->start / 1000, n->start % 1000, n->dur / 1000, n->dur % 1000, self / 1000, self % 1000,
+			pct_10 / 10, pct_10 % 10, bar_off, "", bar ? bar : 1,
+			"########################################");
+	}
+
+	u32 untraced = ts_last > top_dur ? ts_last - top_dur : 0;
+	printf("\nUntraced time between top level stages: %u.%03u ms\n", untraced / 1000, untraced % 1000);
+
+	return 0;
+}
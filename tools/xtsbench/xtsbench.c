@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2026 agent
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms and conditions of the GNU General Public License,
+ * version 2, as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Checks the XTS tweak helpers of bdk/sec/se.c against the original
+// bit-serial implementations and times both natively.
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Build se.c in, with the bdk allocator renamed so it doesn't clash with the host one.
+#define malloc bdk_malloc
+#define calloc bdk_calloc
+#define zalloc bdk_zalloc
+#define free   bdk_free
+#include <sec/se.c>
+#undef malloc
+#undef calloc
+#undef zalloc
+#undef free
+
+#define SEC_SIZE   0x200
+#define BUF_SIZE   0x4000
+#define CASES      100000
+#define BENCH_RUNS 20000
+
+static u32 rng_state = 0x12345678;
+
+static u32 _rand()
+{
+	// xorshift32.
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 17;
+	rng_state ^= rng_state << 5;
+
+	return rng_state;
+}
+
+static void _rand_fill(void *buf, u32 size)
+{
+	u8 *p = (u8 *)buf;
+	for (u32 i = 0; i < size; i++)
+		p[i] = _rand();
+}
+
+static double _now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Original implementations.
+static void _ref_gf256_mul_x(void *block)
+{
+	u8 *pdata = (u8 *)block;
+	u32 carry = 0;
+
+	for (int i = 0xF; i >= 0; i--)
+	{
+		u8 b = pdata[i];
+		pdata[i] = (b << 1) | carry;
+		carry = b >> 7;
+	}
+
+	if (carry)
+		pdata[0xF] ^= 0x87;
+}
+
+static void _ref_gf256_mul_x_le(void *block)
+{
+	u32 *pdata = (u32 *)block;
+	u32 carry = 0;
+
+	for (u32 i = 0; i < 4; i++)
+	{
+		u32 b = pdata[i];
+		pdata[i] = (b << 1) | carry;
+		carry = b >> 31;
+	}
+
+	if (carry)
+		pdata[0x0] ^= 0x87;
+}
+
+static void _ref_se_aes_xts_xor_nx(u32 *pdst, u32 *psrc, u32 *tweaks, u32 sec_off, u32 size, u32 sec_size)
+{
+	u8  tweak[SE_KEY_128_SIZE] __attribute__((aligned(4)));
+	u32 *ptweak = (u32 *)tweak;
+	u32 blk_off = sec_off >> 4;
+	u32 blks_left = size >> 4;
+
+	while (blks_left)
+	{
+		u32 blks = MIN(blks_left, (sec_size >> 4) - blk_off);
+
+		memcpy(tweak, tweaks, SE_KEY_128_SIZE);
+		for (u32 i = 0; i < blk_off; i++)
+			_ref_gf256_mul_x_le(tweak);
+
+		for (u32 i = 0; i < blks; i++)
+		{
+			for (u32 j = 0; j < 4; j++)
+				pdst[j] = psrc[j] ^ ptweak[j];
+
+			_ref_gf256_mul_x_le(tweak);
+			psrc += 4;
+			pdst += 4;
+		}
+
+		blks_left -= blks;
+		blk_off = 0;
+		tweaks += 4;
+	}
+}
+
+static int _check()
+{
+	u32 a[4], b[4];
+	static u32 src[BUF_SIZE / 4], dst_ref[BUF_SIZE / 4], dst_new[BUF_SIZE / 4];
+	static u32 tweaks[(BUF_SIZE / SEC_SIZE + 1) * 4];
+
+	for (u32 i = 0; i < CASES; i++)
+	{
+		_rand_fill(a, sizeof(a));
+
+		// Big endian multiply by x.
+		memcpy(b, a, sizeof(a));
+		_ref_gf256_mul_x(a);
+		_gf256_mul_x(b);
+		if (memcmp(a, b, sizeof(a)))
+		{
+			fprintf(stderr, "_gf256_mul_x mismatch at case %u!\n", i);
+			return 1;
+		}
+
+		// Little endian multiply by x^n. Covers the 56-bit chunking and NX's tweak_exp << 5 range.
+		u32 n = (i & 1) ? _rand() % 200 : _rand() % (32 * 32);
+		memcpy(b, a, sizeof(a));
+		for (u32 j = 0; j < n; j++)
+			_ref_gf256_mul_x_le(a);
+		_gf256_mul_xn_le(b, n);
+		if (memcmp(a, b, sizeof(a)))
+		{
+			fprintf(stderr, "_gf256_mul_xn_le mismatch at case %u (n %u)!\n", i, n);
+			return 1;
+		}
+
+		// Block XOR and tweak advance.
+		if (!(i % 16))
+		{
+			u32 blocks = (_rand() % (BUF_SIZE / 16)) + 1;
+			_rand_fill(src, blocks * 16);
+			memcpy(b, a, sizeof(a));
+			u32 *pdst = dst_ref, *psrc = src;
+			for (u32 j = 0; j < blocks; j++)
+			{
+				for (u32 k = 0; k < 4; k++)
+					pdst[k] = psrc[k] ^ a[k];
+				_ref_gf256_mul_x_le(a);
+				psrc += 4;
+				pdst += 4;
+			}
+			_gf256_xor_mul_x_le(dst_new, src, b, blocks);
+			if (memcmp(a, b, sizeof(a)) || memcmp(dst_ref, dst_new, blocks * 16))
+			{
+				fprintf(stderr, "_gf256_xor_mul_x_le mismatch at case %u (%u blocks)!\n", i, blocks);
+				return 1;
+			}
+
+			// Multi sector XOR with a random 16 byte aligned start offset.
+			u32 sec_off = (_rand() % (SEC_SIZE / 16)) * 16;
+			u32 size = ((_rand() % ((BUF_SIZE - SEC_SIZE) / 16)) + 1) * 16;
+			_rand_fill(tweaks, sizeof(tweaks));
+			_ref_se_aes_xts_xor_nx(dst_ref, src, tweaks, sec_off, size, SEC_SIZE);
+			_se_aes_xts_xor_nx(dst_new, src, tweaks, sec_off, size, SEC_SIZE);
+			if (memcmp(dst_ref, dst_new, size))
+			{
+				fprintf(stderr, "_se_aes_xts_xor_nx mismatch at case %u (off %x size %x)!\n", i, sec_off, size);
+				return 1;
+			}
+		}
+	}
+
+	return 0;
+}
+
+static void _bench()
+{
+	static u32 buf[BUF_SIZE / 4];
+	static u32 tweaks[(BUF_SIZE / SEC_SIZE) * 4];
+	u32 sink = 0;
+	double t0, t_ref, t_new;
+
+	_rand_fill(buf, sizeof(buf));
+	_rand_fill(tweaks, sizeof(tweaks));
+
+	// Fast-forward of a cluster tweak, like tweak_exp of the NX BIS cache.
+	u32 tweak[4];
+	memcpy(tweak, tweaks, sizeof(tweak));
+	t0 = _now();
+	for (u32 i = 0; i < BENCH_RUNS; i++)
+		for (u32 j = 0; j < (31 << 5); j++)
+			_ref_gf256_mul_x_le(tweak);
+	t_ref = _now() - t0;
+	sink ^= tweak[0];
+
+	t0 = _now();
+	for (u32 i = 0; i < BENCH_RUNS; i++)
+		_gf256_mul_xn_le(tweak, 31 << 5);
+	t_new = _now() - t0;
+	sink ^= tweak[0];
+
+	printf("Tweak x^992:        old %8.1f ns, new %8.1f ns, %5.1fx\n",
+		t_ref * 1e9 / BENCH_RUNS, t_new * 1e9 / BENCH_RUNS, t_ref / t_new);
+
+	// Both XOR passes over 16KiB of 512B sectors.
+	t0 = _now();
+	for (u32 i = 0; i < BENCH_RUNS / 10; i++)
+		_ref_se_aes_xts_xor_nx(buf, buf, tweaks, 0, BUF_SIZE, SEC_SIZE);
+	t_ref = _now() - t0;
+	sink ^= buf[0];
+
+	t0 = _now();
+	for (u32 i = 0; i < BENCH_RUNS / 10; i++)
+		_se_aes_xts_xor_nx(buf, buf, tweaks, 0, BUF_SIZE, SEC_SIZE);
+	t_new = _now() - t0;
+	sink ^= buf[0];
+
+	printf("XOR 16KiB:          old %8.1f MiB/s, new %8.1f MiB/s, %5.1fx\n",
+		(double)BUF_SIZE * (BENCH_RUNS / 10) / t_ref / (1 << 20),
+		(double)BUF_SIZE * (BENCH_RUNS / 10) / t_new / (1 << 20), t_ref / t_new);
+
+	if (sink == 0x5A5A5A5A)
+		printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc > 1)
+		rng_state = strtoul(argv[1], NULL, 0) | 1;
+
+	int res = _check();
+	printf("%s: %u tweak cases\n", res ? "FAIL" : "OK", CASES);
+
+	if (!res)
+		_bench();
+
+	return res;
+}